@@ -2,16 +2,111 @@ QT += quick network
 
 CONFIG += c++17
 
+# Compile the QML in qml.qrc ahead of time instead of at every launch
+CONFIG += qtquickcompiler
+
+# Release builds are link-time optimized
+CONFIG(release, debug|release): CONFIG += ltcg
+
+# Profile-guided builds take two passes over the same build directory,
+# which tools/pgo_build.sh runs along with the training in between:
+#   qmake PGO=generate  instrumented; profiles are written to PGO_DIR
+#   qmake PGO=use       optimized with the profiles collected there
+isEmpty(PGO_DIR): PGO_DIR = $$OUT_PWD/pgo-data
+!isEmpty(PGO) {
+    msvc: error("PGO builds are set up for GCC and Clang only")
+    contains(QMAKE_COMPILER, clang) {
+        # Clang writes one raw profile per process; llvm-profdata merges them
+        equals(PGO, generate): PGO_FLAGS = -fprofile-instr-generate=$$PGO_DIR/%p.profraw
+        else: equals(PGO, use): PGO_FLAGS = -fprofile-instr-use=$$PGO_DIR/merged.profdata -Wno-profile-instr-unprofiled
+    } else {
+        # Atomic counters: the log writer, request threads and sharedcache workers all run instrumented code
+        equals(PGO, generate): PGO_FLAGS = -fprofile-generate=$$PGO_DIR -fprofile-update=prefer-atomic
+        else: equals(PGO, use): PGO_FLAGS = -fprofile-use=$$PGO_DIR -fprofile-partial-training -Wno-missing-profile
+    }
+    isEmpty(PGO_FLAGS): error("PGO must be generate or use, not $$PGO")
+    QMAKE_CXXFLAGS += $$PGO_FLAGS
+    QMAKE_LFLAGS += $$PGO_FLAGS
+}
+
 SOURCES += \
         main.cpp \
         weatherservice.cpp \
-        aiagent.cpp
+        aiagent.cpp \
+        requestmetrics.cpp \
+        requestpolicy.cpp \
+        resilientreply.cpp \
+        requestscheduler.cpp \
+        refreshengine.cpp \
+        forecaststore.cpp \
+        forecastmodel.cpp \
+        historystore.cpp \
+        marssolcache.cpp \
+        cityaliases.cpp \
+        cityindex.cpp \
+        sharedcache.cpp \
+        networktrace.cpp \
+        logging.cpp \
+        startupprofiler.cpp \
+        frameprofiler.cpp \
+        weatherconditions.cpp \
+        memorybudget.cpp \
+        backgroundimages.cpp \
+        batchexporter.cpp \
+        appsettings.cpp \
+        benchmarks.cpp
 
 HEADERS += \
         weatherservice.h \
-        aiagent.h
+        aiagent.h \
+        requestmetrics.h \
+        requestpolicy.h \
+        resilientreply.h \
+        requestscheduler.h \
+        refreshengine.h \
+        forecaststore.h \
+        forecastmodel.h \
+        historystore.h \
+        marssolcache.h \
+        cityaliases.h \
+        cityindex.h \
+        sharedcache.h \
+        networktrace.h \
+        logging.h \
+        startupprofiler.h \
+        frameprofiler.h \
+        weatherconditions.h \
+        memorybudget.h \
+        backgroundimages.h \
+        batchexporter.h \
+        appsettings.h \
+        benchmarks.h
+
+RESOURCES += qml.qrc data.qrc
+
+# GetProcessMemoryInfo, for MemoryBudget::residentBytes()
+win32: LIBS += -lpsapi
+
+# City alias table: a perfect hash generated from data/city_aliases.tsv
+isEmpty(PYTHON): PYTHON = python3
+ALIAS_DATA = $$PWD/data/city_aliases.tsv
+aliasgen.input = ALIAS_DATA
+aliasgen.output = city_aliases_table.h
+aliasgen.commands = $$PYTHON $$PWD/tools/gen_city_aliases.py ${QMAKE_FILE_IN} ${QMAKE_FILE_OUT}
+aliasgen.depends = $$PWD/tools/gen_city_aliases.py
+aliasgen.variable_out = HEADERS
+aliasgen.CONFIG += no_link target_predeps
+QMAKE_EXTRA_COMPILERS += aliasgen
 
-RESOURCES += qml.qrc
+# Condition icons and descriptions, indexed by OpenWeatherMap condition id
+CONDITION_DATA = $$PWD/data/weather_conditions.tsv
+conditiongen.input = CONDITION_DATA
+conditiongen.output = conditions_table.h
+conditiongen.commands = $$PYTHON $$PWD/tools/gen_conditions.py ${QMAKE_FILE_IN} ${QMAKE_FILE_OUT}
+conditiongen.depends = $$PWD/tools/gen_conditions.py
+conditiongen.variable_out = HEADERS
+conditiongen.CONFIG += no_link target_predeps
+QMAKE_EXTRA_COMPILERS += conditiongen
 
 # Additional import path used to resolve QML modules in Qt Creator's code model
 QML_IMPORT_PATH =
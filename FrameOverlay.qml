@@ -0,0 +1,58 @@
+import QtQuick
+
+// Frame profiler readout, shown when ELEGANTWEATHER_FRAMES is set
+Rectangle {
+    id: overlay
+
+    readonly property var stats: frameProfiler ? frameProfiler.stats : ({})
+    readonly property var frames: stats.frames || ({})
+
+    function ms(value) {
+        return (value || 0).toFixed(1)
+    }
+
+    width: readout.implicitWidth + 16
+    height: readout.implicitHeight + 12
+    radius: 8
+    color: "#C0000000"
+
+    Column {
+        id: readout
+        x: 8
+        y: 6
+        spacing: 2
+
+        Text {
+            color: "white"
+            font.family: "monospace"
+            font.pixelSize: 11
+            text: (overlay.stats.fps || 0).toFixed(0) + " fps  frame p50 " + overlay.ms(overlay.frames.p50Ms)
+                  + " p95 " + overlay.ms(overlay.frames.p95Ms) + " p99 " + overlay.ms(overlay.frames.p99Ms)
+                  + " max " + overlay.ms(overlay.frames.maxMs) + " ms"
+        }
+
+        Repeater {
+            model: overlay.stats.signals || []
+
+            Text {
+                required property var modelData
+
+                color: modelData.longFrames > 0 ? "#FCA5A5" : "#D0D0D0"
+                font.family: "monospace"
+                font.pixelSize: 11
+                text: modelData.name + "  ×" + modelData.emissions
+                      + "  " + modelData.bindingsPerEmission.toFixed(0) + " bindings"
+                      + "  to frame p95 " + overlay.ms(modelData.latency.p95Ms) + " ms"
+                      + "  long " + modelData.longFrames
+            }
+        }
+
+        Text {
+            color: overlay.stats.otherLongFrames > 0 ? "#FCA5A5" : "#D0D0D0"
+            font.family: "monospace"
+            font.pixelSize: 11
+            text: "other long frames " + (overlay.stats.otherLongFrames || 0)
+                  + " (over " + overlay.ms(overlay.stats.longFrameMs) + " ms)"
+        }
+    }
+}
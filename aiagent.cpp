@@ -3,8 +3,19 @@
 #include <QJsonDocument>
 #include <QJsonObject>
 #include <QJsonArray>
-#include <QDebug>
 #include <QDir>
+#include <QFileInfo>
+#include "logging.h"
+#include "memorybudget.h"
+
+namespace {
+
+// A few thousand exchanges; a kiosk left chatting all week stays under it
+constexpr qint64 kChatHistoryBudgetBytes = 512 * 1024;
+// The latest question and answer survive any trim, so the dialog never empties
+constexpr qsizetype kKeptChatMessages = 2;
+
+} // namespace
 
 AIAgent::AIAgent(QObject *parent)
     : QObject(parent)
@@ -28,7 +39,7 @@ AIAgent::~AIAgent()
 void AIAgent::startService()
 {
     if (m_process->state() != QProcess::NotRunning) {
-        qDebug() << "Service already running";
+        qCDebug(lcAiAgent) << "Service already running";
         return;
     }
 
@@ -36,12 +47,14 @@ void AIAgent::startService()
     setIsReady(false);
 
     // Get the path to the service.py file
-    // Use absolute path to source directory
-    QString servicePath = "/home/mlayug/ElegantWeather/weather-ai-agent/service.py";
-    QString workingDir = "/home/mlayug/ElegantWeather/weather-ai-agent";
+    // Use absolute path to source directory, unless a stand-in is given (benchmarks)
+    const QFileInfo service(qEnvironmentVariable("ELEGANTWEATHER_AI_SERVICE",
+                                                 "/home/mlayug/ElegantWeather/weather-ai-agent/service.py"));
+    QString servicePath = service.absoluteFilePath();
+    QString workingDir = service.absolutePath();
 
-    qDebug() << "Starting AI service:" << servicePath;
-    qDebug() << "Working directory:" << workingDir;
+    qCInfo(lcAiAgent) << "Starting AI service:" << servicePath;
+    qCDebug(lcAiAgent) << "Working directory:" << workingDir;
 
     // Set the working directory for the process
     m_process->setWorkingDirectory(workingDir);
@@ -65,6 +78,23 @@ void AIAgent::stopService()
     setIsReady(false);
 }
 
+void AIAgent::registerMemory(MemoryBudget *budget)
+{
+    budget->addPool(
+        "chat", this, kChatHistoryBudgetBytes,
+        [this]() { return MemoryAccounting::bytes(m_chatHistory) + m_buffer.capacity(); },
+        [this](qint64 targetBytes) {
+            // The read buffer only holds a partial line; between replies it can go
+            if (m_buffer.isEmpty()) m_buffer.squeeze();
+            const QStringList latest = m_chatHistory.mid(qMax<qsizetype>(0, m_chatHistory.size() - kKeptChatMessages));
+            const qint64 historyTarget = qMax(targetBytes - qint64(m_buffer.capacity()),
+                                              MemoryAccounting::bytes(latest));
+            if (MemoryAccounting::trimFront(m_chatHistory, historyTarget) > 0) {
+                emit chatHistoryChanged();
+            }
+        });
+}
+
 void AIAgent::setWeatherData(const QString &location, const QVariantMap &weatherData)
 {
     if (!m_isReady) {
@@ -121,7 +151,7 @@ void AIAgent::sendCommand(const QJsonObject &command)
     QJsonDocument doc(command);
     QString jsonString = doc.toJson(QJsonDocument::Compact) + "\n";
 
-    qDebug() << "Sending command:" << jsonString.trimmed();
+    qCDebug(lcAiAgent) << "Sending command:" << jsonString.trimmed();
     m_process->write(jsonString.toUtf8());
 }
 
@@ -132,7 +162,7 @@ void AIAgent::onProcessReadyRead()
     // Also read stderr for error messages
     QByteArray errorOutput = m_process->readAllStandardError();
     if (!errorOutput.isEmpty()) {
-        qDebug() << "Service stderr:" << errorOutput;
+        qCDebug(lcAiAgent) << "Service stderr:" << errorOutput;
     }
 
     // Process all complete lines
@@ -141,7 +171,7 @@ void AIAgent::onProcessReadyRead()
         QByteArray line = m_buffer.left(newlineIndex);
         m_buffer = m_buffer.mid(newlineIndex + 1);
 
-        qDebug() << "Received line:" << line;
+        qCDebug(lcAiAgent) << "Received line:" << line;
 
         QJsonDocument doc = QJsonDocument::fromJson(line);
         if (!doc.isNull() && doc.isObject()) {
@@ -152,12 +182,12 @@ void AIAgent::onProcessReadyRead()
 
 void AIAgent::onProcessStarted()
 {
-    qDebug() << "AI service process started";
+    qCInfo(lcAiAgent) << "AI service process started";
 }
 
 void AIAgent::onProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
-    qDebug() << "AI service process finished with exit code:" << exitCode;
+    qCInfo(lcAiAgent) << "AI service process finished with exit code:" << exitCode;
     setIsReady(false);
     setIsProcessing(false);
 
@@ -193,7 +223,7 @@ void AIAgent::onProcessError(QProcess::ProcessError error)
             break;
     }
 
-    qDebug() << "Process error:" << errorMsg;
+    qCWarning(lcAiAgent) << "Process error:" << errorMsg;
     setError(errorMsg);
     setIsReady(false);
     setIsProcessing(false);
@@ -204,11 +234,9 @@ void AIAgent::handleResponse(const QJsonObject &response)
     QString status = response["status"].toString();
     QString command = response["command"].toString();
 
-    qDebug() << "Received response:" << QJsonDocument(response).toJson(QJsonDocument::Compact);
-
     if (status == "ready") {
         setIsReady(true);
-        qDebug() << "AI service is ready";
+        qCInfo(lcAiAgent) << "AI service is ready";
         return;
     }
 
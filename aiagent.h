@@ -8,6 +8,7 @@
 #include <QVariantMap>
 
 // Forward declarations for faster compilation
+class MemoryBudget;
 class QJsonObject;
 
 class AIAgent : public QObject
@@ -29,6 +30,9 @@ public:
     QString currentLocation() const { return m_currentLocation; }
     QStringList chatHistory() const { return m_chatHistory; }
 
+    // Reports the chat history to budget, which drops the oldest messages when it's over
+    void registerMemory(MemoryBudget *budget);
+
     Q_INVOKABLE void startService();
     Q_INVOKABLE void stopService();
     Q_INVOKABLE void setWeatherData(const QString &location, const QVariantMap &weatherData);
@@ -0,0 +1,18 @@
+#include "appsettings.h"
+
+namespace {
+
+QSettings::Format settingsFormat()
+{
+    const QString directory = qEnvironmentVariable("ELEGANTWEATHER_SETTINGS_DIR");
+    if (directory.isEmpty()) return QSettings::NativeFormat;
+    QSettings::setPath(QSettings::IniFormat, QSettings::UserScope, directory);
+    return QSettings::IniFormat;
+}
+
+} // namespace
+
+AppSettings::AppSettings()
+    : QSettings(settingsFormat(), QSettings::UserScope, "ElegantWeather", "ElegantWeather")
+{
+}
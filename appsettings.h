@@ -0,0 +1,16 @@
+#ifndef APPSETTINGS_H
+#define APPSETTINGS_H
+
+#include <QSettings>
+
+// The app's settings store: the platform's native one (registry, CFPreferences
+// or an INI file), or an INI file in ELEGANTWEATHER_SETTINGS_DIR when that is
+// set. Benchmarks and scripted runs set it so that they never read or write
+// the user's configuration, which test mode only redirects on Linux.
+class AppSettings : public QSettings
+{
+public:
+    AppSettings();
+};
+
+#endif // APPSETTINGS_H
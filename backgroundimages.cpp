@@ -0,0 +1,109 @@
+#include "backgroundimages.h"
+#include <QBuffer>
+#include <QImage>
+#include <QImageReader>
+#include <algorithm>
+#include "memorybudget.h"
+
+namespace {
+
+// Unsplash "regular" photos run 150-400 KB, and one decoded one is ~7 MB
+constexpr qint64 kBackgroundBudgetBytes = 24 * 1024 * 1024;
+
+QString imageUrl(const QString &id)
+{
+    return QStringLiteral("image://backgrounds/") + id;
+}
+
+} // namespace
+
+BackgroundImageProvider::BackgroundImageProvider()
+    : QQuickImageProvider(QQuickImageProvider::Image)
+{
+}
+
+QString BackgroundImageProvider::find(const QString &sourceUrl)
+{
+    QMutexLocker locker(&m_mutex);
+    for (Photo &photo : m_photos) {
+        if (photo.sourceUrl != sourceUrl) continue;
+        photo.lastUse = ++m_useClock;
+        m_shownId = photo.id;
+        return imageUrl(photo.id);
+    }
+    return QString();
+}
+
+QString BackgroundImageProvider::insert(const QString &sourceUrl, const QByteArray &encoded)
+{
+    QMutexLocker locker(&m_mutex);
+    Photo photo;
+    photo.id = QString::number(++m_nextId);
+    photo.sourceUrl = sourceUrl;
+    photo.encoded = encoded;
+    photo.lastUse = ++m_useClock;
+    m_shownId = photo.id;
+    m_photos.append(photo);
+    return imageUrl(photo.id);
+}
+
+QImage BackgroundImageProvider::requestImage(const QString &id, QSize *size, const QSize &requestedSize)
+{
+    QByteArray encoded;
+    {
+        QMutexLocker locker(&m_mutex);
+        auto it = std::find_if(m_photos.begin(), m_photos.end(), [&id](const Photo &photo) { return photo.id == id; });
+        if (it == m_photos.end()) return QImage();
+        it->lastUse = ++m_useClock;
+        encoded = it->encoded;
+    }
+
+    // Decoded here, on the Image's loader thread
+    QBuffer buffer(&encoded);
+    QImageReader reader(&buffer);
+    reader.setAutoTransform(true);
+    if (requestedSize.isValid() && reader.size().isValid()) {
+        reader.setScaledSize(reader.size().scaled(requestedSize, Qt::KeepAspectRatioByExpanding));
+    }
+    const QImage image = reader.read();
+    if (size) *size = image.size();
+
+    QMutexLocker locker(&m_mutex);
+    if (id == m_shownId) m_decodedBytes = image.sizeInBytes();
+    return image;
+}
+
+qint64 BackgroundImageProvider::byteSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 bytes = m_decodedBytes;
+    for (const Photo &photo : m_photos) {
+        bytes += photo.encoded.capacity();
+    }
+    return bytes;
+}
+
+void BackgroundImageProvider::trim(qint64 targetBytes)
+{
+    QMutexLocker locker(&m_mutex);
+    qint64 bytes = m_decodedBytes;
+    for (const Photo &photo : std::as_const(m_photos)) {
+        bytes += photo.encoded.capacity();
+    }
+
+    // Oldest first, then drop from the front until under target
+    std::sort(m_photos.begin(), m_photos.end(),
+              [](const Photo &a, const Photo &b) { return a.lastUse < b.lastUse; });
+    m_photos.removeIf([this, &bytes, targetBytes](const Photo &photo) {
+        if (bytes <= targetBytes || photo.id == m_shownId) return false;
+        bytes -= photo.encoded.capacity();
+        return true;
+    });
+}
+
+void BackgroundImageProvider::registerMemory(MemoryBudget *budget)
+{
+    budget->addPool(
+        "backgrounds", this, kBackgroundBudgetBytes, [this]() { return byteSize(); },
+        [this](qint64 targetBytes) { trim(targetBytes); });
+}
@@ -0,0 +1,54 @@
+#ifndef BACKGROUNDIMAGES_H
+#define BACKGROUNDIMAGES_H
+
+#include <QQuickImageProvider>
+#include <QByteArray>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+// Forward declarations for faster compilation
+class MemoryBudget;
+
+// City backgrounds for QML as image://backgrounds/<id>. WeatherService
+// downloads each photo once and hands over the encoded bytes; the Image's
+// loader thread decodes them on request, so QML keeps no pixmap cache of
+// its own (the Image sets cache: false) and a photo seen again costs a
+// decode, not a download. Photos are evicted least recently used first,
+// never the one shown last. Owned by the QML engine; the loader thread and
+// the GUI thread share it.
+class BackgroundImageProvider : public QQuickImageProvider
+{
+public:
+    BackgroundImageProvider();
+
+    // The image:// URL of a photo already held, or empty
+    QString find(const QString &sourceUrl);
+    // Stores a downloaded photo and returns its image:// URL
+    QString insert(const QString &sourceUrl, const QByteArray &encoded);
+
+    QImage requestImage(const QString &id, QSize *size, const QSize &requestedSize) override;
+
+    // Encoded photos, plus the last decoded image, which QML holds while it's shown
+    qint64 byteSize() const;
+    void trim(qint64 targetBytes);
+
+    void registerMemory(MemoryBudget *budget);
+
+private:
+    struct Photo {
+        QString id;
+        QString sourceUrl;
+        QByteArray encoded;
+        quint64 lastUse = 0;
+    };
+
+    mutable QMutex m_mutex;
+    QList<Photo> m_photos;
+    QString m_shownId; // Never evicted
+    qint64 m_decodedBytes = 0;
+    quint64 m_useClock = 0;
+    int m_nextId = 0;
+};
+
+#endif // BACKGROUNDIMAGES_H
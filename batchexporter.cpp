@@ -0,0 +1,378 @@
+#include "batchexporter.h"
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QPointer>
+#include <QUrl>
+#include <QUrlQuery>
+#include <cstdio>
+#include "appsettings.h"
+#include "requestscheduler.h"
+#include "resilientreply.h"
+#include "weatherconditions.h"
+#include "weatherservice.h"
+
+namespace {
+
+constexpr double kZeroCelsiusKelvin = 273.15;
+
+// Geocoder answers kept for repeats; a few hundred bytes each
+constexpr int kGeocodeCacheCities = 10000;
+
+const char *const kCsvHeader =
+    "index,query,name,country,lat,lon,observedAt,temperatureC,feelsLikeC,humidity,pressure,windSpeed,"
+    "conditionId,description,error\n";
+
+QString csvField(const QString &value)
+{
+    if (!value.contains(QLatin1Char(',')) && !value.contains(QLatin1Char('"')) && !value.contains(QLatin1Char('\n'))) {
+        return value;
+    }
+    QString quoted = value;
+    quoted.replace(QLatin1String("\""), QLatin1String("\"\""));
+    return QLatin1Char('"') + quoted + QLatin1Char('"');
+}
+
+QString celsius(double kelvin)
+{
+    return QString::number(kelvin - kZeroCelsiusKelvin, 'f', 2);
+}
+
+} // namespace
+
+BatchExporter::BatchExporter(const Options &options, QIODevice *input, QIODevice *output, QObject *parent)
+    : QObject(parent)
+    , m_options(options)
+    , m_input(input)
+    , m_output(output)
+    , m_network(new QNetworkAccessManager(this))
+    , m_scheduler(new RequestScheduler(this))
+{
+    m_options.concurrency = qMax(1, m_options.concurrency);
+    m_geocoded.setMaxCost(kGeocodeCacheCities);
+    m_scheduler->setCallsPerMinute(m_options.callsPerMinute);
+}
+
+void BatchExporter::start()
+{
+    m_clock.start();
+    if (m_options.format == Csv) m_output->write(kCsvHeader);
+    // Queued, so finished() can't fire before the caller is listening
+    QMetaObject::invokeMethod(this, &BatchExporter::fill, Qt::QueuedConnection);
+}
+
+QVariantMap BatchExporter::summary() const
+{
+    const qint64 wallMs = m_inputDone && m_inFlight == 0 ? m_wallMs : m_clock.elapsed();
+    QVariantMap map;
+    map["cities"] = m_cities;
+    map["succeeded"] = m_succeeded;
+    map["failed"] = m_failed;
+    map["geocodeCacheHits"] = m_geocodeCacheHits;
+    map["wallMs"] = wallMs;
+    map["citiesPerSecond"] = wallMs > 0 ? m_cities * 1000.0 / wallMs : 0.0;
+    return map;
+}
+
+void BatchExporter::fill()
+{
+    // Read only as far as there is room in flight
+    while (m_inFlight < m_options.concurrency && !m_inputDone) {
+        const QByteArray raw = m_input->readLine();
+        if (raw.isEmpty()) {
+            m_inputDone = true;
+            break;
+        }
+        const QString line = QString::fromUtf8(raw).trimmed();
+        ++m_lineNumber;
+        if (line.isEmpty() || line.startsWith(QLatin1Char('#'))) continue;
+
+        City city;
+        city.index = m_lineNumber;
+        city.query = line;
+        city.apiName = WeatherService::getApiCityName(line);
+        city.name = city.apiName;
+        ++m_cities;
+        ++m_inFlight;
+
+        if (!m_options.geocode) {
+            fetchWeather(city);
+            continue;
+        }
+        if (const City *known = m_geocoded.object(city.apiName)) {
+            ++m_geocodeCacheHits;
+            City located = *known;
+            located.index = city.index;
+            located.query = city.query;
+            fetchWeather(located);
+        } else if (auto pending = m_geocoding.find(city.apiName); pending != m_geocoding.end()) {
+            // Same name already being looked up; it takes that answer
+            ++m_geocodeCacheHits;
+            pending->append(city);
+        } else {
+            m_geocoding.insert(city.apiName, {});
+            geocode(city);
+        }
+    }
+
+    if (m_inputDone && m_inFlight == 0) {
+        m_wallMs = m_clock.elapsed();
+        emit finished();
+    }
+}
+
+void BatchExporter::geocode(City city)
+{
+    QUrlQuery query;
+    query.addQueryItem("q", city.apiName);
+    query.addQueryItem("limit", "1");
+    ResilientReply *reply = get("/geo/1.0/direct", query, &m_geocodePolicy,
+                                QString("batch/geo/%1").arg(city.index));
+    connect(reply, &QNetworkReply::finished, this, [this, reply, city]() mutable {
+        reply->deleteLater();
+        // Taken first: finishing a city reads more input, which may ask for this name again
+        const QList<City> followers = m_geocoding.take(city.apiName);
+        const auto fail = [&](const QString &error) {
+            writeRow(city, QJsonObject(), error);
+            for (const City &follower : followers) writeRow(follower, QJsonObject(), error);
+            for (qsizetype i = 0; i <= followers.size(); ++i) finishCity(false);
+        };
+        if (reply->error() != QNetworkReply::NoError) {
+            fail("geocoding failed: " + reply->errorString());
+            return;
+        }
+        const QJsonArray places = QJsonDocument::fromJson(reply->body()).array();
+        if (places.isEmpty()) {
+            fail("city not found");
+            return;
+        }
+
+        const QJsonObject place = places.first().toObject();
+        city.name = place["name"].toString(city.apiName);
+        city.country = place["country"].toString();
+        city.latitude = place["lat"].toDouble();
+        city.longitude = place["lon"].toDouble();
+        city.located = true;
+        m_geocoded.insert(city.apiName, new City(city));
+        fetchWeather(city);
+        for (const City &follower : followers) {
+            City located = city;
+            located.index = follower.index;
+            located.query = follower.query;
+            fetchWeather(located);
+        }
+    });
+}
+
+void BatchExporter::fetchWeather(const City &city)
+{
+    QUrlQuery query;
+    if (city.located) {
+        query.addQueryItem("lat", QString::number(city.latitude, 'f', 4));
+        query.addQueryItem("lon", QString::number(city.longitude, 'f', 4));
+    } else {
+        query.addQueryItem("q", city.apiName);
+    }
+    query.addQueryItem("units", "standard"); // Kelvin, converted when written
+    ResilientReply *reply = get("/data/2.5/weather", query, &m_weatherPolicy,
+                                QString("batch/weather/%1").arg(city.index));
+    connect(reply, &QNetworkReply::finished, this, [this, reply, city]() {
+        reply->deleteLater();
+        const QJsonObject weather = QJsonDocument::fromJson(reply->body()).object();
+        if (reply->error() != QNetworkReply::NoError || !weather.contains("main")) {
+            const QString reason = reply->error() != QNetworkReply::NoError ? reply->errorString()
+                                                                            : QString("malformed response");
+            writeRow(city, QJsonObject(), "weather failed: " + reason);
+            finishCity(false);
+            return;
+        }
+        writeRow(city, weather, QString());
+        finishCity(true);
+    });
+}
+
+ResilientReply *BatchExporter::get(const QString &path, QUrlQuery query, RequestPolicy *policy, const QString &key)
+{
+    query.addQueryItem("appid", m_options.apiKey);
+    QUrl url(m_options.baseUrl + path);
+    url.setQuery(query);
+    QNetworkRequest request(url);
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+
+    // Upstream is degraded; fail the city at once rather than spend a retry cycle on it
+    if (!policy->allowRequest()) {
+        return ResilientReply::completed(request, QByteArray(), QNetworkReply::ServiceUnavailableError,
+                                         url.host() + " is temporarily unavailable", this);
+    }
+
+    auto *reply = new ResilientReply(request, [this, request]() {
+        QNetworkReply *attempt = m_network->get(request);
+        connect(attempt, &QNetworkReply::finished, this, [this, attempt]() {
+            if (attempt->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 429) {
+                m_scheduler->onRateLimited(attempt->rawHeader("Retry-After").toInt());
+            }
+        });
+        return attempt;
+    }, policy, this);
+
+    // Every call, retries and hedges included, spends a token from the one bucket
+    reply->setAttemptGate([this]() { return m_scheduler->tryAcquire(RequestScheduler::Foreground); });
+    QPointer<ResilientReply> guard(reply);
+    m_scheduler->submit(RequestScheduler::Foreground, key,
+                        [guard]() { if (guard) guard->start(); },
+                        [guard]() { if (guard) guard->abort(); });
+    return reply;
+}
+
+void BatchExporter::writeRow(const City &city, const QJsonObject &weather, const QString &error)
+{
+    const QJsonObject main = weather["main"].toObject();
+    const QJsonObject condition = weather["weather"].toArray().at(0).toObject();
+    const QJsonObject coord = weather["coord"].toObject();
+    const int conditionId = condition["id"].toInt();
+    const QString description = WeatherConditions::isKnown(conditionId)
+                                    ? WeatherConditions::description(conditionId, u"en")
+                                    : condition["description"].toString();
+    const double latitude = city.located ? city.latitude : coord["lat"].toDouble();
+    const double longitude = city.located ? city.longitude : coord["lon"].toDouble();
+    const bool ok = error.isEmpty();
+
+    QByteArray row;
+    if (m_options.format == Ndjson) {
+        QJsonObject object{{"index", city.index}, {"query", city.query}, {"name", city.name}};
+        if (!city.country.isEmpty()) object["country"] = city.country;
+        if (ok) {
+            object["lat"] = latitude;
+            object["lon"] = longitude;
+            object["observedAt"] = weather["dt"].toInteger();
+            object["temperatureC"] = main["temp"].toDouble() - kZeroCelsiusKelvin;
+            object["feelsLikeC"] = main["feels_like"].toDouble() - kZeroCelsiusKelvin;
+            object["humidity"] = main["humidity"].toInt();
+            object["pressure"] = main["pressure"].toDouble();
+            object["windSpeed"] = weather["wind"].toObject()["speed"].toDouble();
+            object["conditionId"] = conditionId;
+            object["description"] = description;
+        } else {
+            object["error"] = error;
+        }
+        row = QJsonDocument(object).toJson(QJsonDocument::Compact);
+    } else {
+        QStringList fields{QString::number(city.index), csvField(city.query), csvField(city.name),
+                           csvField(city.country)};
+        if (ok) {
+            fields << QString::number(latitude, 'f', 4) << QString::number(longitude, 'f', 4)
+                   << QString::number(weather["dt"].toInteger()) << celsius(main["temp"].toDouble())
+                   << celsius(main["feels_like"].toDouble()) << QString::number(main["humidity"].toInt())
+                   << QString::number(main["pressure"].toDouble())
+                   << QString::number(weather["wind"].toObject()["speed"].toDouble())
+                   << QString::number(conditionId) << csvField(description) << QString();
+        } else {
+            fields << QString() << QString() << QString() << QString() << QString() << QString() << QString()
+                   << QString() << QString() << QString() << csvField(error);
+        }
+        row = fields.join(QLatin1Char(',')).toUtf8();
+    }
+    row.append('\n');
+    m_output->write(row);
+}
+
+void BatchExporter::finishCity(bool succeeded)
+{
+    ++(succeeded ? m_succeeded : m_failed);
+    --m_inFlight;
+    fill();
+}
+
+int runBatch(const QStringList &arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Writes current conditions for a list of cities, one name per line.");
+    parser.addHelpOption();
+    parser.addPositionalArgument("cities", "City list, one per line; - reads standard input.");
+    const QCommandLineOption formatOption("format", "ndjson (default) or csv.", "format", "ndjson");
+    const QCommandLineOption outputOption({"o", "output"}, "Output file; standard output by default.", "file");
+    const QCommandLineOption concurrencyOption("concurrency", "Cities in flight at once (default 8).", "n", "8");
+    const QCommandLineOption rateOption("rate", "OpenWeatherMap calls per minute; apiCallsPerMinute by default.", "n");
+    const QCommandLineOption noGeocodeOption("no-geocode", "Query weather by name, skipping the geocoder.");
+    parser.addOptions({formatOption, outputOption, concurrencyOption, rateOption, noGeocodeOption});
+
+    if (!parser.parse(QStringList{QCoreApplication::applicationFilePath()} + arguments)) {
+        std::fprintf(stderr, "%s\n", qPrintable(parser.errorText()));
+        return 2;
+    }
+    if (parser.isSet("help") || parser.positionalArguments().size() != 1) {
+        std::printf("%s", qPrintable(parser.helpText()));
+        return parser.isSet("help") ? 0 : 2;
+    }
+
+    AppSettings settings;
+    BatchExporter::Options options;
+    const QString baseUrl = qEnvironmentVariable("ELEGANTWEATHER_OWM_URL");
+    options.baseUrl = baseUrl.isEmpty() ? QString("https://api.openweathermap.org") : baseUrl;
+    options.apiKey = qEnvironmentVariable("ELEGANTWEATHER_API_KEY", settings.value("apiKey").toString());
+    options.concurrency = parser.value(concurrencyOption).toInt();
+    options.callsPerMinute = parser.isSet(rateOption) ? parser.value(rateOption).toInt()
+                                                      : settings.value("apiCallsPerMinute", 60).toInt();
+    options.geocode = !parser.isSet(noGeocodeOption);
+
+    const QString format = parser.value(formatOption);
+    if (format == "csv") {
+        options.format = BatchExporter::Csv;
+    } else if (format != "ndjson") {
+        std::fprintf(stderr, "Unknown format %s; use ndjson or csv\n", qPrintable(format));
+        return 2;
+    }
+    if (options.apiKey.isEmpty() && baseUrl.isEmpty()) {
+        std::fprintf(stderr, "No API key; set one in the app or in ELEGANTWEATHER_API_KEY\n");
+        return 2;
+    }
+    if (options.callsPerMinute <= 0) {
+        std::fprintf(stderr, "--rate must be positive\n");
+        return 2;
+    }
+
+    QFile input;
+    const QString inputPath = parser.positionalArguments().first();
+    bool opened = false;
+    if (inputPath == "-") {
+        opened = input.open(stdin, QIODevice::ReadOnly);
+    } else {
+        input.setFileName(inputPath);
+        opened = input.open(QIODevice::ReadOnly);
+    }
+    if (!opened) {
+        std::fprintf(stderr, "Can't read %s: %s\n", qPrintable(inputPath), qPrintable(input.errorString()));
+        return 1;
+    }
+    QFile output;
+    if (parser.isSet(outputOption)) {
+        output.setFileName(parser.value(outputOption));
+        opened = output.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    } else {
+        opened = output.open(stdout, QIODevice::WriteOnly);
+    }
+    if (!opened) {
+        std::fprintf(stderr, "Can't write %s: %s\n", qPrintable(output.fileName()), qPrintable(output.errorString()));
+        return 1;
+    }
+
+    BatchExporter exporter(options, &input, &output);
+    QEventLoop loop;
+    QObject::connect(&exporter, &BatchExporter::finished, &loop, &QEventLoop::quit);
+    exporter.start();
+    loop.exec();
+    output.flush();
+
+    const QVariantMap summary = exporter.summary();
+    std::fprintf(stderr, "%lld cities, %lld exported, %lld failed in %.1f s: %.1f cities/s\n",
+                 summary["cities"].toLongLong(), summary["succeeded"].toLongLong(), summary["failed"].toLongLong(),
+                 summary["wallMs"].toDouble() / 1000, summary["citiesPerSecond"].toDouble());
+    return summary["failed"].toLongLong() > 0 ? 1 : 0;
+}
@@ -0,0 +1,100 @@
+#ifndef BATCHEXPORTER_H
+#define BATCHEXPORTER_H
+
+#include <QObject>
+#include <QCache>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+#include "requestpolicy.h"
+
+// Forward declarations for faster compilation
+class QIODevice;
+class QJsonObject;
+class QNetworkAccessManager;
+class QUrlQuery;
+class RequestScheduler;
+class ResilientReply;
+
+// Current conditions for a list of cities, for reporting. Cities are read a
+// line at a time, renamed through the alias table, geocoded to coordinates
+// and fetched with at most `concurrency` cities in flight; every call goes
+// through one token bucket sized to the API plan and the same timeouts,
+// hedging and retries as the app. Each result is written as soon as it
+// arrives, so rows are in completion order and carry their input line
+// number. Only the cities in flight and the geocoder's last 10,000 answers
+// are kept, so memory is bounded however long the list is.
+class BatchExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Format { Ndjson, Csv };
+
+    struct Options {
+        QString baseUrl; // OpenWeatherMap or a stand-in for it
+        QString apiKey;
+        Format format = Ndjson;
+        int concurrency = 8;
+        int callsPerMinute = 60;
+        bool geocode = true; // Off: weather is queried by name, one call per city
+    };
+
+    // Reads city names from input and writes rows to output; neither is owned
+    BatchExporter(const Options &options, QIODevice *input, QIODevice *output, QObject *parent = nullptr);
+
+    // finished() follows once the last row is written
+    void start();
+
+    // {cities, succeeded, failed, geocodeCacheHits, wallMs, citiesPerSecond}
+    QVariantMap summary() const;
+
+signals:
+    void finished();
+
+private:
+    struct City {
+        qint64 index = 0; // Input line number
+        QString query; // As written in the input
+        QString apiName; // After the alias table
+        QString name; // As the geocoder has it
+        QString country;
+        double latitude = 0;
+        double longitude = 0;
+        bool located = false;
+    };
+
+    void fill();
+    void geocode(City city);
+    void fetchWeather(const City &city);
+    ResilientReply *get(const QString &path, QUrlQuery query, RequestPolicy *policy, const QString &key);
+    void writeRow(const City &city, const QJsonObject &weather, const QString &error);
+    void finishCity(bool succeeded);
+
+    Options m_options;
+    QIODevice *m_input;
+    QIODevice *m_output;
+    QNetworkAccessManager *m_network;
+    RequestScheduler *m_scheduler;
+    RequestPolicy m_geocodePolicy;
+    RequestPolicy m_weatherPolicy;
+    QCache<QString, City> m_geocoded; // By API name, so repeated cities cost one lookup
+    QHash<QString, QList<City>> m_geocoding; // Lookups in flight by API name, with the cities waiting on each
+    QElapsedTimer m_clock;
+    qint64 m_lineNumber = 0;
+    qint64 m_cities = 0;
+    qint64 m_succeeded = 0;
+    qint64 m_failed = 0;
+    qint64 m_geocodeCacheHits = 0;
+    qint64 m_wallMs = 0;
+    int m_inFlight = 0;
+    bool m_inputDone = false;
+};
+
+// `ElegantWeather --batch [options] cities.txt`; `--batch --help` lists the options
+int runBatch(const QStringList &arguments);
+
+#endif // BATCHEXPORTER_H
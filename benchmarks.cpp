@@ -0,0 +1,1285 @@
+#include "benchmarks.h"
+#include "aiagent.h"
+#include "appsettings.h"
+#include "backgroundimages.h"
+#include "batchexporter.h"
+#include "cityaliases.h"
+#include "cityindex.h"
+#include "forecaststore.h"
+#include "historystore.h"
+#include "logging.h"
+#include "memorybudget.h"
+#include "networktrace.h"
+#include "requestpolicy.h"
+#include "resilientreply.h"
+#include "sharedcache.h"
+#include "weatherconditions.h"
+#include "weatherservice.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QBuffer>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QRandomGenerator>
+#include <QScopeGuard>
+#include <QStandardPaths>
+#include <QTemporaryDir>
+#include <QTemporaryFile>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+#include <QUrlQuery>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMap>
+#include <QVector>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Benchmark {
+    const char *name;
+    const char *description;
+    int (*run)();
+};
+
+int envInt(const char *name, int defaultValue)
+{
+    bool ok = false;
+    const int value = qEnvironmentVariableIntValue(name, &ok);
+    return ok ? value : defaultValue;
+}
+
+void report(const char *benchmark, const char *metric, double value, const char *unit)
+{
+    std::printf("%-14s %-28s %14.3f %s\n", benchmark, metric, value, unit);
+    std::fflush(stdout);
+}
+
+// Nearest-rank percentile of an already sorted sample
+double percentileOf(const QVector<double> &sorted, double p)
+{
+    if (sorted.isEmpty()) return 0;
+    const qsizetype rank = qsizetype(p * (sorted.size() - 1) + 0.5);
+    return sorted.at(qBound<qsizetype>(0, rank, sorted.size() - 1));
+}
+
+void reportLatencies(const char *benchmark, const char *label, QVector<double> latencies)
+{
+    std::sort(latencies.begin(), latencies.end());
+    const QByteArray prefix(label);
+    report(benchmark, (prefix + ".p50").constData(), percentileOf(latencies, 0.50), "ms");
+    report(benchmark, (prefix + ".p95").constData(), percentileOf(latencies, 0.95), "ms");
+    report(benchmark, (prefix + ".p99").constData(), percentileOf(latencies, 0.99), "ms");
+    report(benchmark, (prefix + ".max").constData(), latencies.isEmpty() ? 0 : latencies.last(), "ms");
+}
+
+// Tail latency of sequential weather requests with and without hedging.
+// Run the mock server with e.g. --jitter-ms 30 --stall-rate 0.03 --stall-ms 2000
+int benchmarkHedging()
+{
+    const QString base = qEnvironmentVariable("ELEGANTWEATHER_OWM_URL");
+    if (base.isEmpty()) {
+        std::printf("hedging: skipped, set ELEGANTWEATHER_OWM_URL to the mock server\n");
+        return 0;
+    }
+
+    constexpr int kWarmup = 30; // Enough successes for the policy to start hedging
+    const int requests = envInt("ELEGANTWEATHER_BENCH_REQUESTS", 300);
+    QNetworkAccessManager manager;
+
+    for (bool hedging : {false, true}) {
+        RequestPolicy policy(hedging);
+        QVector<double> latencies;
+        int failures = 0;
+
+        for (int i = 0; i < kWarmup + requests; ++i) {
+            const QNetworkRequest request(QUrl(base + "/data/2.5/weather?q=Benchmark&appid=benchmark"));
+            QElapsedTimer timer;
+            timer.start();
+
+            ResilientReply reply(request, [&manager, request]() { return manager.get(request); }, &policy);
+            QEventLoop loop;
+            QObject::connect(&reply, &QNetworkReply::finished, &loop, &QEventLoop::quit);
+            reply.start();
+            loop.exec();
+
+            if (reply.error() != QNetworkReply::NoError) ++failures;
+            if (i >= kWarmup) latencies.append(timer.nsecsElapsed() / 1e6);
+        }
+
+        const char *label = hedging ? "hedged" : "plain";
+        reportLatencies("hedging", label, latencies);
+        const QVariantMap stats = policy.toVariantMap();
+        report("hedging", (QByteArray(label) + ".hedges").constData(), stats["hedges"].toDouble(), "");
+        report("hedging", (QByteArray(label) + ".timeouts").constData(), stats["timeouts"].toDouble(), "");
+        report("hedging", (QByteArray(label) + ".failures").constData(), failures, "");
+    }
+    return 0;
+}
+
+// Keeps the optimizer from discarding benchmark results
+volatile float g_sink = 0;
+
+// Best-of-N wall time in milliseconds
+template<typename Fn>
+double bestOf(int passes, Fn fn)
+{
+    double best = 0;
+    for (int pass = 0; pass < passes; ++pass) {
+        QElapsedTimer timer;
+        timer.start();
+        fn();
+        const double ms = timer.nsecsElapsed() / 1e6;
+        if (pass == 0 || ms < best) best = ms;
+    }
+    return best;
+}
+
+// Row-per-step layout, as the forecast would be held if kept like the JSON
+struct ForecastStep {
+    qint64 time;
+    double temperature;
+    double humidity;
+    double windSpeed;
+    double precipitation;
+    double pop;
+    int conditionId;
+    QString description;
+};
+
+// Daily aggregation over thousands of synthetic 40-step forecasts: the
+// columnar store and its kernels against a per-step struct layout
+int benchmarkForecast()
+{
+    constexpr int kSteps = 40;
+    constexpr int kPasses = 10;
+    const int cities = envInt("ELEGANTWEATHER_BENCH_CITIES", 5000);
+    const qint64 start = 1760000400; // 3-hour aligned
+
+    QStringList names;
+    std::vector<qint64> times(size_t(cities) * kSteps);
+    std::vector<float> temperature(times.size()), precipitation(times.size()), pop(times.size());
+    std::vector<quint16> conditions(times.size());
+    quint32 state = 12345;
+    auto next = [&state]() { state = state * 1664525u + 1013904223u; return (state >> 8) / float(1 << 24); };
+    for (int c = 0; c < cities; ++c) {
+        names.append(QString("City %1").arg(c));
+        for (int i = 0; i < kSteps; ++i) {
+            const size_t at = size_t(c) * kSteps + size_t(i);
+            times[at] = start + i * 10800;
+            temperature[at] = 260.0f + 40.0f * next();
+            precipitation[at] = next() < 0.3f ? 3.0f * next() : 0.0f;
+            pop[at] = next();
+            conditions[at] = quint16(precipitation[at] > 0 ? 500 : 800 + int(4 * next()));
+        }
+    }
+
+    ForecastStore store;
+    const double ingestMs = bestOf(1, [&]() {
+        for (int c = 0; c < cities; ++c) {
+            const size_t at = size_t(c) * kSteps;
+            store.setSeries(names.at(c), &times[at], &temperature[at], &precipitation[at], &pop[at],
+                            &conditions[at], kSteps, -3600 * (c % 12), 0);
+        }
+    });
+
+    QHash<QString, QVector<ForecastStep>> rows;
+    for (int c = 0; c < cities; ++c) {
+        QVector<ForecastStep> &steps = rows[names.at(c)];
+        for (int i = 0; i < kSteps; ++i) {
+            const size_t at = size_t(c) * kSteps + size_t(i);
+            steps.append({times[at], temperature[at], 50, 3, precipitation[at], pop[at],
+                          conditions[at], QString("scattered clouds")});
+        }
+    }
+
+    const double columnarMs = bestOf(kPasses, [&]() {
+        float total = 0;
+        for (const QString &name : std::as_const(names)) {
+            const QVector<ForecastDay> days = store.daily(name);
+            for (const ForecastDay &day : days) total += day.meanKelvin + day.precipitationMm;
+        }
+        g_sink = total;
+    });
+
+    const double rowMs = bestOf(kPasses, [&]() {
+        float total = 0;
+        for (int c = 0; c < cities; ++c) {
+            const QVector<ForecastStep> &steps = rows[names.at(c)];
+            const int utcOffset = -3600 * (c % 12);
+            QVector<ForecastDay> days;
+            for (const ForecastStep &step : steps) {
+                const qint64 midnight = (step.time + utcOffset) / 86400 * 86400;
+                if (days.isEmpty() || days.last().localMidnight != midnight) {
+                    days.append({midnight, float(step.temperature), float(step.temperature), 0, 0, 0, step.conditionId});
+                }
+                ForecastDay &day = days.last();
+                day.minKelvin = qMin(day.minKelvin, float(step.temperature));
+                day.maxKelvin = qMax(day.maxKelvin, float(step.temperature));
+                day.meanKelvin += float(step.temperature); // Left as a sum; only the checksum reads it
+                day.precipitationMm += float(step.precipitation);
+                day.maxPop = qMax(day.maxPop, float(step.pop));
+            }
+            for (const ForecastDay &day : std::as_const(days)) total += day.meanKelvin + day.precipitationMm;
+        }
+        g_sink = total;
+    });
+
+    std::vector<float> converted(temperature.size());
+    const double convertMs = bestOf(kPasses, [&]() {
+        ForecastKernels::affine(temperature.data(), converted.data(), qsizetype(temperature.size()),
+                                9.0f / 5.0f, -459.67f);
+        g_sink = converted.back();
+    });
+
+    report("forecast", "cities", cities, "");
+    report("forecast", "ingest.columnar", ingestMs, "ms");
+    report("forecast", "daily.columnar", columnarMs, "ms");
+    report("forecast", "daily.columnar.per_city", columnarMs * 1e6 / cities, "ns");
+    report("forecast", "daily.rows", rowMs, "ms");
+    report("forecast", "daily.rows.per_city", rowMs * 1e6 / cities, "ns");
+    report("forecast", "convert.throughput", temperature.size() / (convertMs * 1e3), "Mvalues/s");
+    return 0;
+}
+
+// Years of 10-minute observations for hundreds of cities: append rate in
+// real-time (city-interleaved) order, then full and short range scans,
+// chart downsampling and compaction. Writes to a temporary directory
+// unless ELEGANTWEATHER_HISTORY_DIR is set.
+int benchmarkHistory()
+{
+    constexpr qint64 kStepSeconds = 10 * 60;
+    const int cities = envInt("ELEGANTWEATHER_BENCH_HISTORY_CITIES", 200);
+    const int days = envInt("ELEGANTWEATHER_BENCH_HISTORY_DAYS", 365);
+    const qint64 steps = qint64(days) * 24 * 60 * 60 / kStepSeconds;
+    const qint64 start = 1700000400;
+    const qint64 end = start + steps * kStepSeconds;
+
+    QTemporaryDir scratch;
+    QString directory = qEnvironmentVariable("ELEGANTWEATHER_HISTORY_DIR");
+    if (directory.isEmpty()) {
+        if (!scratch.isValid()) {
+            std::printf("history: skipped, no temporary directory\n");
+            return 1;
+        }
+        directory = scratch.path();
+    }
+
+    QStringList names;
+    for (int c = 0; c < cities; ++c) {
+        names.append(QString("City %1").arg(c));
+    }
+
+    HistoryStore store(directory);
+    HistoryRecord record;
+    QElapsedTimer timer;
+    timer.start();
+    for (qint64 step = 0; step < steps; ++step) {
+        record.time = start + step * kStepSeconds;
+        for (int c = 0; c < cities; ++c) {
+            record.temperatureKelvin = 280.0f + float((step + c) % 144) * 0.1f;
+            record.humidity = float((step * 7 + c) % 100);
+            if (!store.append(names.at(c), record)) {
+                std::printf("history: append failed (disk full?)\n");
+                return 1;
+            }
+        }
+    }
+    const double appendMs = timer.nsecsElapsed() / 1e6;
+    const double records = double(steps) * cities;
+
+    // Whole history of every city
+    float checksum = 0;
+    timer.restart();
+    for (const QString &name : std::as_const(names)) {
+        store.scan(name, start, end, [&checksum](const HistoryRecord *r, qsizetype count) {
+            for (qsizetype i = 0; i < count; ++i) checksum += r[i].temperatureKelvin;
+        });
+    }
+    const double scanMs = timer.nsecsElapsed() / 1e6;
+    g_sink = checksum;
+
+    // One-day windows at random offsets, as a detail view would ask for
+    constexpr int kQueries = 2000;
+    QVector<double> rangeLatencies, chartLatencies;
+    QRandomGenerator random(42);
+    for (int q = 0; q < kQueries; ++q) {
+        const QString &name = names.at(int(random.bounded(cities)));
+        const qint64 from = start + random.bounded(qMax<qint64>(1, steps - 144)) * kStepSeconds;
+        timer.restart();
+        g_sink = float(store.range(name, from, from + 24 * 60 * 60).size());
+        rangeLatencies.append(timer.nsecsElapsed() / 1e3);
+
+        timer.restart();
+        g_sink = float(store.downsample(name, start, end, 500).size());
+        chartLatencies.append(timer.nsecsElapsed() / 1e3);
+    }
+
+    timer.restart();
+    int compacted = 0;
+    for (const QString &name : std::as_const(names)) {
+        compacted += store.compact(name, start + (end - start) / 2, 60 * 60);
+    }
+    const double compactMs = timer.nsecsElapsed() / 1e6;
+
+    std::sort(rangeLatencies.begin(), rangeLatencies.end());
+    std::sort(chartLatencies.begin(), chartLatencies.end());
+    report("history", "records", records, "");
+    report("history", "append.throughput", records / (appendMs * 1e3), "Mrecords/s");
+    report("history", "scan.throughput", records / (scanMs * 1e3), "Mrecords/s");
+    report("history", "scan.bandwidth", records * sizeof(HistoryRecord) / (scanMs * 1e6), "GB/s");
+    report("history", "range.1day.p50", percentileOf(rangeLatencies, 0.50), "us");
+    report("history", "range.1day.p99", percentileOf(rangeLatencies, 0.99), "us");
+    report("history", "chart.500pt.p50", percentileOf(chartLatencies, 0.50), "us");
+    report("history", "chart.500pt.p99", percentileOf(chartLatencies, 0.99), "us");
+    report("history", "compact.segments", compacted, "");
+    report("history", "compact.time", compactMs, "ms");
+    return 0;
+}
+
+// City alias lookups: the generated perfect hash (which also normalizes
+// case, accents and punctuation) against the exact-match QMap it replaced,
+// loaded with the same entries. Half the queries are aliases, half are
+// ordinary names that must miss, which is the common case.
+int benchmarkAliases()
+{
+    const int lookups = envInt("ELEGANTWEATHER_BENCH_LOOKUPS", 1000000);
+
+    QVector<QString> keys, values;
+    for (qsizetype slot = 0; slot < CityAliases::slotCount(); ++slot) {
+        QUtf8StringView key, value;
+        if (!CityAliases::entryAt(slot, &key, &value)) continue;
+        keys.append(key.toString());
+        values.append(value.toString());
+    }
+    if (keys.isEmpty()) {
+        std::printf("aliases: skipped, empty table\n");
+        return 1;
+    }
+
+    // What the old table cost at every startup
+    QMap<QString, QString> map;
+    const double buildMs = bestOf(5, [&] {
+        map.clear();
+        for (qsizetype i = 0; i < keys.size(); ++i) map.insert(keys.at(i), values.at(i));
+    });
+
+    QVector<QString> queries;
+    for (qsizetype i = 0; i < keys.size(); ++i) {
+        queries.append(keys.at(i));
+        queries.append(QString("Springfield %1").arg(i));
+    }
+
+    qsizetype found = 0;
+    const double mapMs = bestOf(3, [&] {
+        for (int i = 0; i < lookups; ++i) {
+            const QString &query = queries.at(i % queries.size());
+            found += map.value(query, query).size();
+        }
+    });
+    const double hashMs = bestOf(3, [&] {
+        for (int i = 0; i < lookups; ++i) {
+            found += CityAliases::lookup(queries.at(i % queries.size())).size();
+        }
+    });
+    g_sink = float(found);
+
+    report("aliases", "entries", keys.size(), "");
+    report("aliases", "slots", CityAliases::slotCount(), "");
+    report("aliases", "qmap.build", buildMs * 1e3, "us");
+    report("aliases", "perfecthash.build", 0, "us");
+    report("aliases", "qmap.lookup", mapMs * 1e6 / lookups, "ns");
+    report("aliases", "perfecthash.lookup", hashMs * 1e6 / lookups, "ns");
+    return 0;
+}
+
+// Condition rendering: the icon by string comparison on the API's "main"
+// group, as it was done before, against the generated table indexed by
+// condition id, and a full re-render (icon plus description) in every
+// language, which is all a language switch now costs.
+int benchmarkConditions()
+{
+    const int lookups = envInt("ELEGANTWEATHER_BENCH_LOOKUPS", 1000000);
+    const char *const languages[] = {"en", "es", "fr", "de", "it", "pt", "ru", "zh", "ja", "ko"};
+
+    QVector<int> ids;
+    QVector<QString> groups;
+    for (int id = 200; id < 900; ++id) {
+        if (!WeatherConditions::isKnown(id)) continue;
+        ids.append(id);
+        switch (id / 100) {
+            case 2: groups.append("Thunderstorm"); break;
+            case 3: groups.append("Drizzle"); break;
+            case 5: groups.append("Rain"); break;
+            case 6: groups.append("Snow"); break;
+            case 7: groups.append(id == 711 ? "Smoke" : id == 741 ? "Fog" : "Mist"); break;
+            default: groups.append(id == 800 ? "Clear" : "Clouds"); break;
+        }
+    }
+    if (ids.isEmpty()) {
+        std::printf("conditions: skipped, empty table\n");
+        return 1;
+    }
+
+    const auto iconByGroup = [](const QString &condition) -> QString {
+        if (condition == "Clear") return "☀️";
+        if (condition == "Clouds") return "☁️";
+        if (condition == "Rain") return "🌧️";
+        if (condition == "Drizzle") return "🌦️";
+        if (condition == "Thunderstorm") return "⛈️";
+        if (condition == "Snow") return "❄️";
+        if (condition == "Mist" || condition == "Fog") return "🌫️";
+        if (condition == "Haze") return "🌫️";
+        if (condition == "Smoke") return "💨";
+        return "🌤️";
+    };
+
+    qsizetype found = 0;
+    const double chainMs = bestOf(3, [&] {
+        for (int i = 0; i < lookups; ++i) found += iconByGroup(groups.at(i % groups.size())).size();
+    });
+    const double tableMs = bestOf(3, [&] {
+        for (int i = 0; i < lookups; ++i) found += WeatherConditions::icon(ids.at(i % ids.size())).size();
+    });
+    const double switchMs = bestOf(3, [&] {
+        for (const char *language : languages) {
+            const QString code = QString::fromLatin1(language);
+            for (int id : std::as_const(ids)) {
+                found += WeatherConditions::icon(id).size();
+                found += WeatherConditions::description(id, code).size();
+            }
+        }
+    });
+    g_sink = float(found);
+
+    report("conditions", "ids", ids.size(), "");
+    report("conditions", "stringchain.icon", chainMs * 1e6 / lookups, "ns");
+    report("conditions", "table.icon", tableMs * 1e6 / lookups, "ns");
+    report("conditions", "languageswitch", switchMs * 1e6 / (ids.size() * std::size(languages)), "ns/condition");
+    return 0;
+}
+
+Q_LOGGING_CATEGORY(lcBenchmark, "elegantweather.benchmark", QtInfoMsg)
+
+QFile *g_syncLog = nullptr;
+
+// What logging used to cost: format, then a write and flush on the caller's thread
+void writeLogSynchronously(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    g_syncLog->write(qFormatLogMessage(type, context, message).toUtf8().append('\n'));
+    g_syncLog->flush();
+}
+
+// Per-call cost of a debug statement like AIAgent's response logging: in a
+// disabled category, formatted but discarded, written synchronously, and
+// handed to the async ring-buffer sink (caller side, then the drain).
+int benchmarkLogging()
+{
+    const int messages = envInt("ELEGANTWEATHER_BENCH_LOG_MESSAGES", 100000);
+    QTemporaryDir dir;
+    if (!dir.isValid()) {
+        std::printf("logging: skipped, no temporary directory\n");
+        return 1;
+    }
+
+    const QJsonObject response{
+        {"status", "ok"},
+        {"command", "chat"},
+        {"response", QString(400, QLatin1Char('x'))},
+    };
+    const auto logResponse = [&](int i) {
+        qCDebug(lcBenchmark) << "Received response" << i << QJsonDocument(response).toJson(QJsonDocument::Compact);
+    };
+
+    QLoggingCategory::setFilterRules("elegantweather.benchmark.debug=false");
+    const double disabledMs = bestOf(3, [&] {
+        for (int i = 0; i < messages; ++i) logResponse(i);
+    });
+
+    QLoggingCategory::setFilterRules("elegantweather.benchmark.debug=true");
+    QtMessageHandler previous = qInstallMessageHandler([](QtMsgType, const QMessageLogContext &, const QString &) {});
+    const double discardedMs = bestOf(3, [&] {
+        for (int i = 0; i < messages; ++i) logResponse(i);
+    });
+
+    QFile syncFile(dir.filePath("sync.log"));
+    syncFile.open(QIODevice::WriteOnly);
+    g_syncLog = &syncFile;
+    qInstallMessageHandler(writeLogSynchronously);
+    const double syncMs = bestOf(1, [&] {
+        for (int i = 0; i < messages; ++i) logResponse(i);
+    });
+    qInstallMessageHandler(previous);
+    g_syncLog = nullptr;
+
+    double asyncMs = 0;
+    double drainMs = 0;
+    qint64 dropped = 0;
+    {
+        AsyncLogSink sink(dir.filePath("async.log"));
+        asyncMs = bestOf(1, [&] {
+            for (int i = 0; i < messages; ++i) logResponse(i);
+        });
+        drainMs = bestOf(1, [&] { sink.flush(); });
+        dropped = sink.droppedCount();
+    }
+    QLoggingCategory::setFilterRules(QString());
+
+    report("logging", "messages", messages, "");
+    report("logging", "disabled", disabledMs * 1e6 / messages, "ns");
+    report("logging", "formatted.discarded", discardedMs * 1e6 / messages, "ns");
+    report("logging", "sync.file", syncMs * 1e6 / messages, "ns");
+    report("logging", "async.caller", asyncMs * 1e6 / messages, "ns");
+    report("logging", "async.drain", drainMs, "ms");
+    report("logging", "async.dropped", dropped, "");
+    return 0;
+}
+
+// Reverse lookup over a synthetic world of places spread evenly over the
+// sphere: index build time, then nearest-1, nearest-10 and 50 km radius
+// queries, with a linear scan for scale. Also loads the bundled city list.
+int benchmarkCityIndex()
+{
+    const int places = envInt("ELEGANTWEATHER_BENCH_PLACES", 100000);
+    constexpr int kQueries = 10000;
+    constexpr int kLinearQueries = 200;
+
+    QRandomGenerator random(42);
+    auto randomPoint = [&random](double *latitude, double *longitude) {
+        *latitude = qRadiansToDegrees(std::asin(random.generateDouble() * 2 - 1));
+        *longitude = random.generateDouble() * 360 - 180;
+    };
+
+    QVector<CityLocation> cities(places);
+    for (CityLocation &city : cities) randomPoint(&city.latitude, &city.longitude);
+
+    CityIndex index;
+    const double buildMs = bestOf(3, [&] { index.build(cities); });
+
+    QVector<double> nearestLatencies, nearest10Latencies, radiusLatencies;
+    qsizetype found = 0;
+    QElapsedTimer timer;
+    for (int q = 0; q < kQueries; ++q) {
+        double latitude, longitude;
+        randomPoint(&latitude, &longitude);
+
+        timer.start();
+        found += index.nearest(latitude, longitude, 1).size();
+        nearestLatencies.append(timer.nsecsElapsed() / 1e3);
+
+        timer.restart();
+        found += index.nearest(latitude, longitude, 10).size();
+        nearest10Latencies.append(timer.nsecsElapsed() / 1e3);
+
+        timer.restart();
+        found += index.withinRadius(latitude, longitude, 50).size();
+        radiusLatencies.append(timer.nsecsElapsed() / 1e3);
+    }
+
+    // Haversine over every place, what a lookup costs without an index
+    timer.restart();
+    for (int q = 0; q < kLinearQueries; ++q) {
+        double latitude, longitude;
+        randomPoint(&latitude, &longitude);
+        const double lat = qDegreesToRadians(latitude);
+        double best = 2;
+        for (const CityLocation &city : std::as_const(cities)) {
+            const double dLat = std::sin((qDegreesToRadians(city.latitude) - lat) / 2);
+            const double dLon = std::sin(qDegreesToRadians(city.longitude - longitude) / 2);
+            best = std::min(best, dLat * dLat + std::cos(lat) * std::cos(qDegreesToRadians(city.latitude)) * dLon * dLon);
+        }
+        g_sink = float(best);
+    }
+    const double linearUs = timer.nsecsElapsed() / 1e3 / kLinearQueries;
+    g_sink = float(found);
+
+    CityIndex bundled;
+    timer.restart();
+    const bool loaded = bundled.loadCsv(":/data/cities.csv");
+    const double loadMs = timer.nsecsElapsed() / 1e6;
+
+    std::sort(nearestLatencies.begin(), nearestLatencies.end());
+    std::sort(nearest10Latencies.begin(), nearest10Latencies.end());
+    std::sort(radiusLatencies.begin(), radiusLatencies.end());
+    report("cityindex", "places", places, "");
+    report("cityindex", "build", buildMs, "ms");
+    report("cityindex", "nearest1.p50", percentileOf(nearestLatencies, 0.50), "us");
+    report("cityindex", "nearest1.p99", percentileOf(nearestLatencies, 0.99), "us");
+    report("cityindex", "nearest10.p50", percentileOf(nearest10Latencies, 0.50), "us");
+    report("cityindex", "nearest10.p99", percentileOf(nearest10Latencies, 0.99), "us");
+    report("cityindex", "radius50km.p50", percentileOf(radiusLatencies, 0.50), "us");
+    report("cityindex", "radius50km.p99", percentileOf(radiusLatencies, 0.99), "us");
+    report("cityindex", "linear.nearest1", linearUs, "us");
+    if (loaded) {
+        report("cityindex", "bundled.cities", bundled.size(), "");
+        report("cityindex", "bundled.load", loadMs, "ms");
+    }
+    return 0;
+}
+
+// The key WeatherService::requestWeather() files a city's weather under;
+// the app id is stripped from keys, so any value does
+QByteArray weatherCacheKey(const QString &base, const QString &city)
+{
+    QUrl url(base + "/data/2.5/weather");
+    QUrlQuery query;
+    query.addQueryItem("q", WeatherService::getApiCityName(city));
+    query.addQueryItem("appid", "bench");
+    query.addQueryItem("units", "standard");
+    url.setQuery(query);
+    return NetworkTrace::withoutSecrets(url).toString().toUtf8();
+}
+
+// Weather requests the mock server has answered so far, from its /__stats
+int upstreamWeatherRequests(QNetworkAccessManager &manager, const QString &base)
+{
+    std::unique_ptr<QNetworkReply> reply(manager.get(QNetworkRequest(QUrl(base + "/__stats"))));
+    QEventLoop loop;
+    QObject::connect(reply.get(), &QNetworkReply::finished, &loop, &QEventLoop::quit);
+    loop.exec();
+    if (reply->error() != QNetworkReply::NoError) return -1;
+    const QJsonObject requests = QJsonDocument::fromJson(reply->readAll()).object()["requests"].toObject();
+    return requests["/data/2.5/weather"].toInt();
+}
+
+// Runs the event loop until the condition holds or the time is up
+bool waitUntil(const std::function<bool()> &condition, qint64 timeoutMs)
+{
+    QElapsedTimer waited;
+    waited.start();
+    QEventLoop loop;
+    QTimer poll;
+    QObject::connect(&poll, &QTimer::timeout, &loop, [&]() {
+        if (condition() || waited.hasExpired(timeoutMs)) loop.quit();
+    });
+    poll.start(10);
+    if (!condition()) loop.exec();
+    return condition();
+}
+
+// Logical requests to an endpoint a service has completed, from its metrics
+qint64 completedRequests(const WeatherService &service, const QString &endpoint)
+{
+    const QVariantMap phases = service.metricsSnapshot()["endpoints"].toMap()[endpoint].toMap()["phases"].toMap();
+    return phases["request"].toMap()["count"].toLongLong();
+}
+
+// Sets an environment variable until the returned guard goes out of scope
+auto scopedEnvironment(const char *name, const QByteArray &value)
+{
+    const bool wasSet = qEnvironmentVariableIsSet(name);
+    const QByteArray previous = qgetenv(name);
+    qputenv(name, value);
+    return qScopeGuard([name, wasSet, previous]() {
+        if (wasSet) {
+            qputenv(name, previous);
+        } else {
+            qunsetenv(name);
+        }
+    });
+}
+
+// One instance for the sharedcache benchmark: a WeatherService with its own
+// settings and history (the parent gives each worker its own directories) that
+// refreshes every city in the list through the background refresh path, so
+// the shared cache is used exactly as the app uses it. Prints the extra
+// attempts (hedges and retries) its policy made, which upstream also sees.
+int sharedCacheWorker(const QStringList &arguments)
+{
+    if (arguments.size() != 1) return 2;
+    QFile list(arguments.at(0));
+    if (!list.open(QIODevice::ReadOnly)) return 2;
+    const QStringList cities = QString::fromUtf8(list.readAll()).split('\n', Qt::SkipEmptyParts);
+    // Never the user's own settings
+    if (qEnvironmentVariableIsEmpty("ELEGANTWEATHER_SETTINGS_DIR")) return 2;
+
+    QStandardPaths::setTestModeEnabled(true);
+    {
+        AppSettings settings;
+        settings.setValue("apiKey", "bench");
+        settings.setValue("apiCallsPerMinute", 600000); // The quota isn't what's measured
+        settings.setValue("autoRefresh", false);
+        settings.setValue("city", "Bench Home"); // Not in the list, so no city is the one on screen
+    }
+
+    WeatherService service;
+    service.setMetricsEnabled(true);
+    const auto completed = [&service]() { return completedRequests(service, "weather"); };
+
+    // Chunks stay under the scheduler's cap on queued background work
+    constexpr int kChunk = 16;
+    constexpr qint64 kChunkTimeoutMs = 60 * 1000;
+    for (qsizetype first = 0; first < cities.size(); first += kChunk) {
+        const QStringList chunk = cities.mid(first, kChunk);
+        const qint64 target = completed() + chunk.size();
+        // What the refresh engine's timer calls
+        QMetaObject::invokeMethod(&service, "onRefreshDue", Q_ARG(QStringList, chunk));
+        if (!waitUntil([&]() { return completed() >= target; }, kChunkTimeoutMs)) return 1;
+    }
+
+    const QVariantMap policy = service.metricsSnapshot()["resilience"].toMap()["weather"].toMap();
+    std::printf("%lld\n", policy["hedges"].toLongLong() + policy["retries"].toLongLong());
+    return 0;
+}
+
+// Several instances refreshing the same cities at once through the shared
+// cache: weather fetches counted by the mock server should stay at one per
+// city whatever the instance count. The cities are picked so none evicts
+// another from the segment; any extra fetch is then the sharing's fault.
+int benchmarkSharedCacheInstances(const QString &base, const QString &prefix)
+{
+    const int wanted = qMin(envInt("ELEGANTWEATHER_BENCH_SHARED_KEYS", 200),
+                            SharedCache::setCount() * SharedCache::waysPerSet());
+    QVector<int> perSet(SharedCache::setCount(), 0);
+    QStringList cities;
+    for (int n = 0; cities.size() < wanted; ++n) {
+        const QString city = QString("Bench City %1").arg(n);
+        int &used = perSet[SharedCache::setOf(weatherCacheKey(base, city))];
+        if (used == SharedCache::waysPerSet()) continue;
+        ++used;
+        cities.append(city);
+    }
+
+    QTemporaryDir scratch;
+    QFile list(scratch.filePath("cities.txt"));
+    if (!scratch.isValid() || !list.open(QIODevice::WriteOnly)) {
+        std::printf("sharedcache: can't write the city list\n");
+        return 1;
+    }
+    list.write(cities.join('\n').toUtf8());
+    list.close();
+
+    QNetworkAccessManager manager;
+    int status = 0;
+    for (int instances : {1, 2, 4, 8}) {
+        // Held open here so the segment outlives any one worker
+        const QString segmentName = prefix + QString::number(instances);
+        SharedCache segment(segmentName);
+        if (!segment.isAttached()) {
+            std::printf("sharedcache: instances skipped, shared memory unavailable\n");
+            return status;
+        }
+
+        const int before = upstreamWeatherRequests(manager, base);
+        if (before < 0) {
+            std::printf("sharedcache: no request counts at %s/__stats\n", qPrintable(base));
+            return 1;
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        QList<QProcess *> workers;
+        for (int i = 0; i < instances; ++i) {
+            const QString home = scratch.filePath(QString("home-%1-%2").arg(instances).arg(i));
+            QDir().mkpath(home);
+            QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+            environment.insert("HOME", home);
+            environment.insert("ELEGANTWEATHER_SETTINGS_DIR", home + "/settings");
+            environment.insert("ELEGANTWEATHER_HISTORY_DIR", home + "/history");
+            environment.insert("ELEGANTWEATHER_SHARED_CACHE", segmentName);
+
+            auto *worker = new QProcess;
+            worker->setProcessEnvironment(environment);
+            worker->start(QCoreApplication::applicationFilePath(),
+                          {"--benchmark-worker", "sharedcache", list.fileName()});
+            workers.append(worker);
+        }
+
+        int extraAttempts = 0;
+        for (QProcess *worker : std::as_const(workers)) {
+            if (!worker->waitForFinished(5 * 60 * 1000) || worker->exitCode() != 0) status = 1;
+            extraAttempts += worker->readAllStandardOutput().trimmed().toInt();
+            delete worker;
+        }
+        const double wallMs = timer.nsecsElapsed() / 1e6;
+        const int fetches = upstreamWeatherRequests(manager, base) - before;
+
+        const QByteArray label = QByteArray::number(instances) + (instances == 1 ? " instance" : " instances");
+        report("sharedcache", (label + ".fetches").constData(), fetches, "");
+        report("sharedcache", (label + ".hedges+retries").constData(), extraAttempts, "");
+        report("sharedcache", (label + ".unshared").constData(), double(instances) * cities.size(), "");
+        report("sharedcache", (label + ".wall").constData(), wallMs, "ms");
+        // Hedges and retries reach upstream too, unless aborted before they're sent
+        if (fetches < cities.size() || fetches > cities.size() + extraAttempts) {
+            std::printf("sharedcache: %d fetches for %lld cities with %d instances\n",
+                        fetches, qlonglong(cities.size()), instances);
+            status = 1;
+        }
+    }
+    return status;
+}
+
+// Upstream fetches as instances are added (against the mock server), then
+// the in-process cost of hits and inserts
+int benchmarkSharedCache()
+{
+    const QString prefix = QString("ElegantWeather.bench.%1.").arg(QCoreApplication::applicationPid());
+    const QString base = qEnvironmentVariable("ELEGANTWEATHER_OWM_URL");
+    int status = 0;
+    if (base.isEmpty()) {
+        std::printf("sharedcache: instances skipped, set ELEGANTWEATHER_OWM_URL to the mock server\n");
+    } else {
+        status = benchmarkSharedCacheInstances(base, prefix);
+    }
+
+    // Single-process cost of the cache itself
+    constexpr int kKeys = 200;
+    SharedCache cache(prefix + "latency");
+    const QByteArray body(2048, 'x');
+    QVector<QByteArray> keyNames;
+    for (int k = 0; k < kKeys; ++k) keyNames.append("/data/2.5/weather?q=City " + QByteArray::number(k));
+
+    constexpr int kRounds = 1000;
+    const double insertMs = bestOf(3, [&] {
+        for (const QByteArray &key : std::as_const(keyNames)) cache.insert(key, body);
+    });
+    qsizetype found = 0;
+    const double lookupMs = bestOf(3, [&] {
+        QByteArray out;
+        for (int round = 0; round < kRounds; ++round) {
+            found += cache.lookup(keyNames.at(round % keyNames.size()), 60 * 1000, &out) ? out.size() : 0;
+        }
+    });
+    g_sink = float(found);
+    report("sharedcache", "insert.2KB", insertMs * 1e6 / kKeys, "ns");
+    report("sharedcache", "lookup.hit.2KB", lookupMs * 1e6 / kRounds, "ns");
+    return status;
+}
+
+// Re-runs a recorded session (ELEGANTWEATHER_REPLAY) offline through the
+// same resilience layer the app uses. Each request is issued at its
+// recorded offset and answered from the trace, both scaled by
+// ELEGANTWEATHER_REPLAY_SPEED, so runs are repeatable from one build to the next.
+int benchmarkReplay()
+{
+    const QString path = qEnvironmentVariable("ELEGANTWEATHER_REPLAY");
+    if (path.isEmpty()) {
+        std::printf("replay: skipped, set ELEGANTWEATHER_REPLAY to a recorded trace\n");
+        return 0;
+    }
+    const QList<NetworkTrace::Entry> entries = NetworkTrace::load(path);
+    if (entries.isEmpty()) {
+        std::printf("replay: %s has no requests\n", qPrintable(path));
+        return 1;
+    }
+    bool ok = false;
+    double speed = qEnvironmentVariable("ELEGANTWEATHER_REPLAY_SPEED").toDouble(&ok);
+    if (!ok) speed = 1.0;
+
+    ReplayNetworkAccessManager manager(entries, speed);
+    RequestPolicy policy;
+    QVector<double> latencies, recorded;
+    int failures = 0;
+    qsizetype pending = entries.size();
+    QEventLoop loop;
+    QElapsedTimer wall;
+    wall.start();
+
+    for (const NetworkTrace::Entry &entry : entries) {
+        recorded.append(double(entry.durationMs));
+        const int offsetMs = speed > 0 ? int(entry.startMs / speed) : 0;
+        QTimer::singleShot(offsetMs, &loop, [&, entry]() {
+            QNetworkRequest request(entry.url);
+            for (const QNetworkReply::RawHeaderPair &header : entry.requestHeaders) {
+                request.setRawHeader(header.first, header.second);
+            }
+            const qint64 issuedNs = wall.nsecsElapsed();
+            const QByteArray method = entry.method;
+            auto *reply = new ResilientReply(request, [&manager, request, method]() {
+                return manager.sendCustomRequest(request, method);
+            }, &policy, &loop);
+            QObject::connect(reply, &QNetworkReply::finished, &loop, [&, reply, issuedNs]() {
+                // Back in recorded milliseconds, so runs at any speed compare
+                latencies.append((wall.nsecsElapsed() - issuedNs) / 1e6 * (speed > 0 ? speed : 1.0));
+                if (reply->error() != QNetworkReply::NoError) ++failures;
+                reply->deleteLater();
+                if (--pending == 0) loop.quit();
+            });
+            reply->start();
+        });
+    }
+    loop.exec();
+    const double wallMs = wall.nsecsElapsed() / 1e6;
+
+    report("replay", "requests", entries.size(), "");
+    reportLatencies("replay", "recorded", recorded);
+    reportLatencies("replay", "replayed", latencies);
+    report("replay", "failures", failures, "");
+    report("replay", "unmatched", manager.unmatchedCount(), "");
+    report("replay", "wall", wallMs, "ms");
+    return manager.unmatchedCount() > 0 ? 1 : 0;
+}
+
+// A week of kiosk use in one run, through the app's own objects. Every
+// simulated 15 minutes the user switches city (weather, forecast, UV and a
+// background photo, which is then decoded as the QML image loader would),
+// a rotating set of other cities is refreshed in the background, and the
+// chat gains an exchange with the AI service. WeatherService, AIAgent and
+// BackgroundImageProvider register their pools with a MemoryBudget exactly
+// as main() has them do, and enforce() runs every step. Resident memory is
+// sampled at the end of each day and must stop growing once the first day
+// has filled every pool to its budget. Needs the mock server and the mock
+// AI service; everything upstream comes from their canned bodies.
+int benchmarkMemory()
+{
+    constexpr int kStepsPerDay = 24 * 4;
+    constexpr int kWatchedCities = 10;
+    constexpr int kMaxRefreshesPerStep = 16; // Under the scheduler's cap on queued background work
+    constexpr qint64 kStepTimeoutMs = 10 * 1000;
+    constexpr qint64 kMiB = 1024 * 1024;
+    const int days = qMax(2, envInt("ELEGANTWEATHER_BENCH_SOAK_DAYS", 7));
+    const int cities = qMax(kWatchedCities + 1, envInt("ELEGANTWEATHER_BENCH_SOAK_CITIES", 300));
+    const int refreshesPerStep = qBound(0, envInt("ELEGANTWEATHER_BENCH_SOAK_REFRESHES", 10), kMaxRefreshesPerStep);
+
+    const QByteArray base = qgetenv("ELEGANTWEATHER_OWM_URL");
+    if (base.isEmpty() || qEnvironmentVariableIsEmpty("ELEGANTWEATHER_AI_SERVICE")) {
+        std::printf("memory: skipped, set ELEGANTWEATHER_OWM_URL to the mock server and "
+                    "ELEGANTWEATHER_AI_SERVICE to tools/mock_ai_service.py\n");
+        return 0;
+    }
+    QTemporaryDir scratch;
+    if (!scratch.isValid()) {
+        std::printf("memory: skipped, no temporary directory\n");
+        return 1;
+    }
+    if (MemoryBudget::residentBytes() < 0) {
+        std::printf("memory: skipped, resident memory can't be read on this platform\n");
+        return 0;
+    }
+
+    // Settings, history and shared cache of its own; photos come from the mock server too
+    QStandardPaths::setTestModeEnabled(true);
+    const auto testMode = qScopeGuard([]() { QStandardPaths::setTestModeEnabled(false); });
+    const auto historyDir = scopedEnvironment("ELEGANTWEATHER_HISTORY_DIR", scratch.filePath("history").toUtf8());
+    const auto sharedCache = scopedEnvironment("ELEGANTWEATHER_SHARED_CACHE",
+                                               "ElegantWeather.bench.memory." + QByteArray::number(QCoreApplication::applicationPid()));
+    const auto unsplash = scopedEnvironment("ELEGANTWEATHER_UNSPLASH_URL",
+                                            qEnvironmentVariableIsEmpty("ELEGANTWEATHER_UNSPLASH_URL")
+                                                ? base : qgetenv("ELEGANTWEATHER_UNSPLASH_URL"));
+    const auto settingsDir = scopedEnvironment("ELEGANTWEATHER_SETTINGS_DIR", scratch.filePath("settings").toUtf8());
+    QDir(QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation)).removeRecursively();
+
+    QStringList names;
+    for (int c = 0; c < cities; ++c) {
+        names.append(QString("City %1").arg(c));
+    }
+    {
+        AppSettings settings;
+        settings.setValue("apiKey", "bench");
+        settings.setValue("unsplashAccessKey", "bench");
+        settings.setValue("apiCallsPerMinute", 600000); // The quota isn't what's measured
+        settings.setValue("autoRefresh", false); // Refreshes are driven below, faster than real time
+        settings.setValue("city", names.first());
+        settings.setValue("watchedCities", names.mid(1, kWatchedCities));
+    }
+
+    // The app's objects, registered the way main() registers them
+    MemoryBudget budget;
+    budget.loadSettings();
+    BackgroundImageProvider backgrounds;
+    WeatherService service;
+    AIAgent agent;
+    service.registerMemory(&budget);
+    agent.registerMemory(&budget);
+    backgrounds.registerMemory(&budget);
+    service.setBackgroundImages(&backgrounds);
+    service.setMetricsEnabled(true);
+
+    agent.startService();
+    if (!waitUntil([&]() { return agent.isReady(); }, kStepTimeoutMs)) {
+        std::printf("memory: the AI service didn't start: %s\n", qPrintable(agent.error()));
+        return 1;
+    }
+    agent.setWeatherData(names.first(), QVariantMap{{"temperature", 20.0}, {"description", "few clouds"}});
+    waitUntil([&]() { return agent.currentLocation() == names.first(); }, kStepTimeoutMs);
+
+    bool backgroundShown = false;
+    QObject::connect(&service, &WeatherService::backgroundImageUrlChanged, [&]() { backgroundShown = true; });
+    const QString question(80, QLatin1Char('q'));
+    const QString imagePrefix = "image://backgrounds/";
+
+    QVector<double> rssMiB, enforceLatencies;
+    QElapsedTimer timer;
+    int timeouts = 0;
+    qint64 step = 0;
+    for (int day = 0; day < days; ++day) {
+        for (int s = 0; s < kStepsPerDay; ++s, ++step) {
+            // The user moves on to another city and its photo is shown
+            backgroundShown = false;
+            service.setCity(names.at(int(step % cities)));
+            service.fetchWeather();
+            if (!waitUntil([&]() { return !service.loading() && backgroundShown; }, kStepTimeoutMs)) ++timeouts;
+            const QString shown = service.backgroundImageUrl();
+            if (shown.startsWith(imagePrefix)) {
+                QSize size;
+                g_sink = float(backgrounds.requestImage(shown.mid(imagePrefix.size()), &size, QSize()).sizeInBytes());
+            }
+
+            // What the refresh engine's timer calls for the cities falling due
+            QStringList due;
+            for (int r = 0; r < refreshesPerStep; ++r) {
+                due.append(names.at(int((step * refreshesPerStep + r) % cities)));
+            }
+            const qint64 target = completedRequests(service, "weather") + due.size();
+            QMetaObject::invokeMethod(&service, "onRefreshDue", Q_ARG(QStringList, due));
+            if (!waitUntil([&]() { return completedRequests(service, "weather") >= target; }, kStepTimeoutMs)) ++timeouts;
+
+            agent.sendQuery(question);
+            if (!waitUntil([&]() { return !agent.isProcessing(); }, kStepTimeoutMs)) ++timeouts;
+
+            timer.start();
+            budget.enforce();
+            enforceLatencies.append(timer.nsecsElapsed() / 1e6);
+        }
+        rssMiB.append(double(MemoryBudget::residentBytes()) / kMiB);
+    }
+    agent.stopService();
+
+    const QVariantMap breakdown = budget.breakdown();
+    for (int day = 0; day < rssMiB.size(); ++day) {
+        report("memory", QByteArray("rss.day" + QByteArray::number(day + 1)).constData(), rssMiB.at(day), "MiB");
+    }
+    // Growth after the first day, when every pool has filled
+    const double growth = *std::max_element(rssMiB.cbegin() + 1, rssMiB.cend()) - rssMiB.first();
+    report("memory", "rss.growth.after.day1", growth, "MiB");
+    qint64 evicted = 0;
+    for (const QVariant &entry : breakdown.value("pools").toList()) {
+        const QVariantMap pool = entry.toMap();
+        evicted += pool.value("evictedBytes").toLongLong();
+        report("memory", QByteArray("pool." + pool.value("name").toByteArray()).constData(),
+               pool.value("bytes").toDouble() / 1024, "KiB");
+    }
+    report("memory", "pools.total", breakdown.value("totalBytes").toDouble() / kMiB, "MiB");
+    report("memory", "evicted", double(evicted) / kMiB, "MiB");
+    report("memory", "timeouts", timeouts, "");
+    reportLatencies("memory", "enforce", enforceLatencies);
+
+    if (timeouts > 0) {
+        std::printf("memory: %d steps timed out; is the mock server running?\n", timeouts);
+        return 1;
+    }
+    // Allocator noise aside, a bounded app doesn't grow after it has filled up
+    const double allowedMiB = qMax(8.0, rssMiB.first() * 0.1);
+    if (growth > allowedMiB) {
+        std::printf("memory: resident memory grew %.1f MiB after the first day, more than %.1f\n", growth, allowedMiB);
+        return 1;
+    }
+    return 0;
+}
+
+// Bulk export throughput against the mock server at 1, 8 and 32 cities in
+// flight. The rate limit is lifted so the pipeline, not the plan, is measured;
+// each name appears twice in a row, so repeats can skip the geocoder.
+// Run the mock server with --latency-ms to see concurrency hide round trips.
+int benchmarkBatch()
+{
+    const QString base = qEnvironmentVariable("ELEGANTWEATHER_OWM_URL");
+    if (base.isEmpty()) {
+        std::printf("batch: skipped, set ELEGANTWEATHER_OWM_URL to the mock server\n");
+        return 0;
+    }
+
+    const int cities = envInt("ELEGANTWEATHER_BENCH_BATCH_CITIES", 1000);
+    QByteArray list;
+    for (int i = 0; i < cities; ++i) {
+        list += "Bench City " + QByteArray::number(i / 2) + '\n';
+    }
+
+    int status = 0;
+    for (int concurrency : {1, 8, 32}) {
+        BatchExporter::Options options;
+        options.baseUrl = base;
+        options.apiKey = "bench";
+        options.concurrency = concurrency;
+        options.callsPerMinute = 1000000;
+
+        QBuffer input(&list);
+        input.open(QIODevice::ReadOnly);
+        QTemporaryFile output;
+        if (!output.open()) {
+            std::printf("batch: can't create a temporary file\n");
+            return 1;
+        }
+
+        BatchExporter exporter(options, &input, &output);
+        QEventLoop loop;
+        QObject::connect(&exporter, &BatchExporter::finished, &loop, &QEventLoop::quit);
+        exporter.start();
+        loop.exec();
+
+        const QVariantMap summary = exporter.summary();
+        const QByteArray label = "c" + QByteArray::number(concurrency);
+        report("batch", (label + ".throughput").constData(), summary["citiesPerSecond"].toDouble(), "cities/s");
+        report("batch", (label + ".failed").constData(), summary["failed"].toDouble(), "cities");
+        report("batch", (label + ".geocode.hits").constData(), summary["geocodeCacheHits"].toDouble(), "cities");
+        report("batch", (label + ".output").constData(), double(output.size()) / 1024, "KiB");
+        if (summary["failed"].toLongLong() > 0) status = 1;
+    }
+    return status;
+}
+
+// Response parsing on the app's own path. The city on screen changes for
+// every fetch, so each brings a weather body through parseWeatherData() and
+// a forecast through ForecastStore::ingest(), served by the mock server. The
+// parse phase of the request metrics times them with the network excluded.
+int benchmarkParse()
+{
+    constexpr qint64 kFetchTimeoutMs = 10 * 1000;
+    const int fetches = qMax(1, envInt("ELEGANTWEATHER_BENCH_PARSE_FETCHES", 100));
+    if (qEnvironmentVariableIsEmpty("ELEGANTWEATHER_OWM_URL")) {
+        std::printf("parse: skipped, set ELEGANTWEATHER_OWM_URL to the mock server\n");
+        return 0;
+    }
+    QTemporaryDir scratch;
+    if (!scratch.isValid()) {
+        std::printf("parse: skipped, no temporary directory\n");
+        return 1;
+    }
+
+    // Settings and history of its own, and no other instance's responses
+    QStandardPaths::setTestModeEnabled(true);
+    const auto testMode = qScopeGuard([]() { QStandardPaths::setTestModeEnabled(false); });
+    const auto historyDir = scopedEnvironment("ELEGANTWEATHER_HISTORY_DIR", scratch.filePath("history").toUtf8());
+    const auto sharedCache = scopedEnvironment("ELEGANTWEATHER_SHARED_CACHE",
+                                               "ElegantWeather.bench.parse." + QByteArray::number(QCoreApplication::applicationPid()));
+    const auto settingsDir = scopedEnvironment("ELEGANTWEATHER_SETTINGS_DIR", scratch.filePath("settings").toUtf8());
+    {
+        AppSettings settings;
+        settings.setValue("apiKey", "bench");
+        settings.setValue("apiCallsPerMinute", 600000); // The quota isn't what's measured
+        settings.setValue("autoRefresh", false);
+        settings.setValue("city", "Bench Home");
+    }
+
+    WeatherService service;
+    service.setMetricsEnabled(true);
+    int timeouts = 0;
+    for (int i = 0; i < fetches; ++i) {
+        const qint64 weatherTarget = completedRequests(service, "weather") + 1;
+        const qint64 forecastTarget = completedRequests(service, "forecast") + 1;
+        service.setCity(QString("Bench City %1").arg(i));
+        service.fetchWeather();
+        const bool done = waitUntil([&]() {
+            return completedRequests(service, "weather") >= weatherTarget
+                   && completedRequests(service, "forecast") >= forecastTarget && !service.loading();
+        }, kFetchTimeoutMs);
+        if (!done) ++timeouts;
+    }
+
+    const QVariantMap endpoints = service.metricsSnapshot()["endpoints"].toMap();
+    for (const char *endpoint : {"weather", "forecast"}) {
+        const QVariantMap parse = endpoints[endpoint].toMap()["phases"].toMap()["parse"].toMap();
+        const QByteArray label(endpoint);
+        report("parse", (label + ".count").constData(), parse["count"].toDouble(), "");
+        report("parse", (label + ".mean").constData(), parse["meanMs"].toDouble() * 1000, "us");
+        report("parse", (label + ".p50").constData(), parse["p50Ms"].toDouble() * 1000, "us");
+        report("parse", (label + ".p95").constData(), parse["p95Ms"].toDouble() * 1000, "us");
+    }
+    report("parse", "timeouts", timeouts, "");
+    return timeouts > 0 ? 1 : 0;
+}
+
+// Chat round trips through AIAgent as the chat dialog makes them: a JSON
+// line to the service's stdin, a JSON line back on its stdout. Against
+// tools/mock_ai_service.py the answer is immediate, so this is the cost of
+// the pipe, the framing and the chat history update.
+int benchmarkAiAgent()
+{
+    constexpr qint64 kReplyTimeoutMs = 10 * 1000;
+    const int queries = qMax(1, envInt("ELEGANTWEATHER_BENCH_AI_QUERIES", 500));
+    if (qEnvironmentVariableIsEmpty("ELEGANTWEATHER_AI_SERVICE")) {
+        std::printf("aiagent: skipped, set ELEGANTWEATHER_AI_SERVICE to tools/mock_ai_service.py\n");
+        return 0;
+    }
+
+    AIAgent agent;
+    QElapsedTimer timer;
+    timer.start();
+    agent.startService();
+    if (!waitUntil([&]() { return agent.isReady(); }, kReplyTimeoutMs)) {
+        std::printf("aiagent: the AI service didn't start: %s\n", qPrintable(agent.error()));
+        return 1;
+    }
+    const double startMs = timer.nsecsElapsed() / 1e6;
+    agent.setWeatherData("Bench City", QVariantMap{{"temperature", 20.0}, {"description", "few clouds"}});
+    waitUntil([&]() { return agent.currentLocation() == "Bench City"; }, kReplyTimeoutMs);
+
+    // Woken by the reply itself; polling would swamp a sub-millisecond round trip
+    QVector<double> latencies;
+    int failures = 0;
+    for (int i = 0; i < queries; ++i) {
+        timer.start();
+        agent.sendQuery(QString("What should I wear today? (%1)").arg(i));
+        if (agent.isProcessing()) {
+            QEventLoop loop;
+            QObject::connect(&agent, &AIAgent::isProcessingChanged, &loop, &QEventLoop::quit);
+            QTimer::singleShot(kReplyTimeoutMs, &loop, &QEventLoop::quit);
+            loop.exec();
+        }
+        if (agent.isProcessing() || !agent.error().isEmpty()) ++failures;
+        latencies.append(timer.nsecsElapsed() / 1e6);
+    }
+    agent.stopService();
+
+    report("aiagent", "start", startMs, "ms");
+    reportLatencies("aiagent", "roundtrip", latencies);
+    report("aiagent", "failures", failures, "");
+    return failures > 0 ? 1 : 0;
+}
+
+const Benchmark kBenchmarks[] = {
+    {"hedging", "p50/p95/p99 of weather requests against the mock server, hedged vs plain", benchmarkHedging},
+    {"forecast", "daily forecast aggregation over many cities, columnar vs per-step rows", benchmarkForecast},
+    {"history", "observation history append, range scan, downsample and compaction", benchmarkHistory},
+    {"aliases", "city alias lookup, generated perfect hash vs runtime QMap", benchmarkAliases},
+    {"conditions", "condition icon by string chain vs generated table; re-render per language", benchmarkConditions},
+    {"logging", "debug statement cost: disabled category, synchronous file write, async ring-buffer sink", benchmarkLogging},
+    {"cityindex", "reverse city lookup: k-d tree build, nearest-N and radius queries", benchmarkCityIndex},
+    {"replay", "a recorded session (ELEGANTWEATHER_REPLAY) re-run offline through the resilience layer", benchmarkReplay},
+    {"sharedcache", "upstream fetches with 1-8 instances sharing one cache; hit and insert cost", benchmarkSharedCache},
+    {"memory", "a simulated week of refreshes, chat and backgrounds under the memory budgets; RSS per day", benchmarkMemory},
+    {"batch", "bulk export through --batch's pipeline against the mock server at 1, 8 and 32 in flight", benchmarkBatch},
+    {"parse", "weather and forecast body parsing on the app's path, fed by the mock server", benchmarkParse},
+    {"aiagent", "chat round trips to the AI service over its stdin/stdout pipe (ELEGANTWEATHER_AI_SERVICE)", benchmarkAiAgent},
+};
+
+} // namespace
+
+int runBenchmarks(const QStringList &names)
+{
+    if (names == QStringList{"list"}) {
+        for (const Benchmark &benchmark : kBenchmarks) {
+            std::printf("%-14s %s\n", benchmark.name, benchmark.description);
+        }
+        return 0;
+    }
+
+    int status = 0;
+    for (const Benchmark &benchmark : kBenchmarks) {
+        if (!names.isEmpty() && !names.contains(QLatin1String(benchmark.name))) continue;
+        status |= benchmark.run();
+    }
+    return status;
+}
+
+int runBenchmarkWorker(const QStringList &arguments)
+{
+    if (arguments.value(0) == QLatin1String("sharedcache")) return sharedCacheWorker(arguments.mid(1));
+    return 2;
+}
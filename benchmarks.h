@@ -0,0 +1,16 @@
+#ifndef BENCHMARKS_H
+#define BENCHMARKS_H
+
+#include <QStringList>
+
+// Headless benchmark suite, run as `ElegantWeather --benchmark [name...]`.
+// With no names every benchmark runs; `--benchmark list` prints them.
+// Network benchmarks expect ELEGANTWEATHER_OWM_URL to point at
+// tools/mock_server.py and skip themselves otherwise.
+int runBenchmarks(const QStringList &names);
+
+// Child side of multi-process benchmarks, which re-launch this binary as
+// `ElegantWeather --benchmark-worker <name> [args...]`
+int runBenchmarkWorker(const QStringList &arguments);
+
+#endif // BENCHMARKS_H
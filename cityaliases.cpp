@@ -0,0 +1,135 @@
+#include "cityaliases.h"
+#include <QChar>
+#include <QtGlobal>
+#include <cstring>
+#include "city_aliases_table.h" // Generated from data/city_aliases.tsv
+
+namespace {
+
+// Longer input can't be an alias; every key in the table is far shorter
+constexpr qsizetype kMaxKeyBytes = 256;
+
+quint32 fnv1a(const char *data, qsizetype size, quint32 seed)
+{
+    quint32 hash = 0x811C9DC5u ^ seed;
+    for (qsizetype i = 0; i < size; ++i) {
+        hash ^= quint8(data[i]);
+        hash *= 0x01000193u;
+    }
+    return hash;
+}
+
+int encodeUtf8(char32_t cp, char *out)
+{
+    if (cp < 0x80) {
+        out[0] = char(cp);
+        return 1;
+    }
+    if (cp < 0x800) {
+        out[0] = char(0xC0 | (cp >> 6));
+        out[1] = char(0x80 | (cp & 0x3F));
+        return 2;
+    }
+    if (cp < 0x10000) {
+        out[0] = char(0xE0 | (cp >> 12));
+        out[1] = char(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = char(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = char(0xF0 | (cp >> 18));
+    out[1] = char(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = char(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = char(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Mirrors normalize() in tools/gen_city_aliases.py; the two must agree
+// byte for byte. Returns the key length, or -1 if it doesn't fit.
+qsizetype normalizedKey(QStringView name, char *out)
+{
+    qsizetype size = 0;
+    bool pendingSpace = false;
+
+    for (qsizetype i = 0; i < name.size(); ++i) {
+        char32_t cp = name[i].unicode();
+        if (QChar::isHighSurrogate(cp) && i + 1 < name.size() && name[i + 1].isLowSurrogate()) {
+            cp = QChar::surrogateToUcs4(name[i], name[i + 1]);
+            ++i;
+        }
+
+        char encoded[4];
+        const char *piece;
+        qsizetype length;
+        if (cp < CityAliasTable::kFoldLimit) {
+            piece = CityAliasTable::kFold[cp];
+            length = qsizetype(std::strlen(piece));
+        } else if (QChar::isSpace(cp)) {
+            piece = " ";
+            length = 1;
+        } else {
+            length = encodeUtf8(QChar::toLower(cp), encoded);
+            piece = encoded;
+        }
+
+        for (qsizetype j = 0; j < length; ++j) {
+            const char c = piece[j];
+            if (c == ' ') {
+                pendingSpace = size > 0;
+                continue;
+            }
+            if (c == '.') continue;
+            if (size + 2 > kMaxKeyBytes) return -1;
+            if (c == ',') {
+                out[size++] = ',';
+                pendingSpace = true;
+                continue;
+            }
+            if (pendingSpace) {
+                out[size++] = ' ';
+                pendingSpace = false;
+            }
+            out[size++] = c;
+        }
+    }
+    return size;
+}
+
+} // namespace
+
+namespace CityAliases {
+
+QUtf8StringView lookup(QStringView name)
+{
+    char key[kMaxKeyBytes];
+    const qsizetype size = normalizedKey(name, key);
+    if (size <= 0) return {};
+
+    const quint32 bucket = fnv1a(key, size, CityAliasTable::kSeed) % CityAliasTable::kBucketCount;
+    const quint32 slot = fnv1a(key, size, CityAliasTable::kDisplacements[bucket]) % CityAliasTable::kSlotCount;
+    const CityAliasTable::Entry &entry = CityAliasTable::kEntries[slot];
+
+    // A perfect hash only places known keys; anything else still lands somewhere
+    if (entry.keyLength != quint32(size)
+        || std::memcmp(CityAliasTable::kStrings + entry.keyOffset, key, size_t(size)) != 0) {
+        return {};
+    }
+    return QUtf8StringView(CityAliasTable::kStrings + entry.valueOffset, qsizetype(entry.valueLength));
+}
+
+qsizetype slotCount()
+{
+    return CityAliasTable::kSlotCount;
+}
+
+bool entryAt(qsizetype slot, QUtf8StringView *normalizedKey, QUtf8StringView *apiName)
+{
+    if (slot < 0 || slot >= qsizetype(CityAliasTable::kSlotCount)) return false;
+
+    const CityAliasTable::Entry &entry = CityAliasTable::kEntries[slot];
+    if (entry.keyLength == 0) return false;
+    *normalizedKey = QUtf8StringView(CityAliasTable::kStrings + entry.keyOffset, qsizetype(entry.keyLength));
+    *apiName = QUtf8StringView(CityAliasTable::kStrings + entry.valueOffset, qsizetype(entry.valueLength));
+    return true;
+}
+
+} // namespace CityAliases
@@ -0,0 +1,25 @@
+#ifndef CITYALIASES_H
+#define CITYALIASES_H
+
+#include <QStringView>
+#include <QUtf8StringView>
+
+// Alternate city spellings (historic names, exonyms, transliterations,
+// abbreviations) mapped to the name OpenWeatherMap knows. The table is a
+// minimal perfect hash generated at build time from data/city_aliases.tsv
+// by tools/gen_city_aliases.py: nothing is built at startup, and a lookup
+// normalizes into a stack buffer, hashes twice and compares once, without
+// touching the heap. Case, Latin diacritics, periods and the spacing around
+// commas are ignored when matching.
+namespace CityAliases {
+
+// Empty view if the name has no alias; otherwise points into static data
+QUtf8StringView lookup(QStringView name);
+
+// Table slots, some empty; for diagnostics and benchmarks
+qsizetype slotCount();
+bool entryAt(qsizetype slot, QUtf8StringView *normalizedKey, QUtf8StringView *apiName);
+
+} // namespace CityAliases
+
+#endif // CITYALIASES_H
@@ -0,0 +1,192 @@
+#include "cityindex.h"
+#include <QFile>
+#include <QStringList>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace {
+
+constexpr double kEarthRadiusKm = 6371.0088; // Mean radius
+
+void toUnitVector(double latitude, double longitude, float *out)
+{
+    const double lat = qDegreesToRadians(latitude);
+    const double lon = qDegreesToRadians(longitude);
+    out[0] = float(std::cos(lat) * std::cos(lon));
+    out[1] = float(std::cos(lat) * std::sin(lon));
+    out[2] = float(std::sin(lat));
+}
+
+double chordToKm(float squaredChord)
+{
+    const double half = std::sqrt(double(squaredChord)) / 2;
+    return 2 * kEarthRadiusKm * std::asin(std::min(1.0, half));
+}
+
+template<typename Node, typename Accept>
+void searchTree(const std::vector<Node> &nodes, qsizetype begin, qsizetype end,
+                const float *query, const float &bound, Accept &accept)
+{
+    // bound may shrink inside accept(); the far side is tested after the near one
+    while (begin < end) {
+        const qsizetype middle = begin + (end - begin) / 2;
+        const Node &node = nodes[middle];
+        const float dx = query[0] - node.position[0];
+        const float dy = query[1] - node.position[1];
+        const float dz = query[2] - node.position[2];
+        const float squared = dx * dx + dy * dy + dz * dz;
+        if (squared <= bound) accept(node, squared);
+
+        const float split = query[node.axis] - node.position[node.axis];
+        if (split < 0) {
+            searchTree(nodes, begin, middle, query, bound, accept);
+            if (split * split > bound) return;
+            begin = middle + 1;
+        } else {
+            searchTree(nodes, middle + 1, end, query, bound, accept);
+            if (split * split > bound) return;
+            end = middle;
+        }
+    }
+}
+
+} // namespace
+
+bool CityIndex::loadCsv(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) return false;
+
+    QVector<CityLocation> cities;
+    while (!file.atEnd()) {
+        const QString line = QString::fromUtf8(file.readLine()).trimmed();
+        if (line.isEmpty() || line.startsWith('#')) continue;
+
+        const QStringList fields = line.split(',');
+        if (fields.size() != 4) continue;
+        bool latitudeOk = false, longitudeOk = false;
+        CityLocation city;
+        city.name = fields.at(0).trimmed();
+        city.country = fields.at(1).trimmed();
+        city.latitude = fields.at(2).toDouble(&latitudeOk);
+        city.longitude = fields.at(3).toDouble(&longitudeOk);
+        if (city.name.isEmpty() || !latitudeOk || !longitudeOk
+            || qAbs(city.latitude) > 90 || qAbs(city.longitude) > 180) {
+            continue;
+        }
+        cities.append(std::move(city));
+    }
+    build(std::move(cities));
+    return true;
+}
+
+void CityIndex::build(QVector<CityLocation> cities)
+{
+    m_cities = std::move(cities);
+    m_nodes.resize(size_t(m_cities.size()));
+    for (qsizetype i = 0; i < m_cities.size(); ++i) {
+        Node &node = m_nodes[size_t(i)];
+        toUnitVector(m_cities.at(i).latitude, m_cities.at(i).longitude, node.position);
+        node.city = quint32(i);
+        node.axis = 0;
+    }
+    buildRange(0, qsizetype(m_nodes.size()));
+}
+
+void CityIndex::buildRange(qsizetype begin, qsizetype end)
+{
+    while (end - begin > 1) {
+        // Split on the widest axis; cities are far from uniform on the sphere
+        float low[3] = {2, 2, 2}, high[3] = {-2, -2, -2};
+        for (qsizetype i = begin; i < end; ++i) {
+            for (int a = 0; a < 3; ++a) {
+                low[a] = std::min(low[a], m_nodes[size_t(i)].position[a]);
+                high[a] = std::max(high[a], m_nodes[size_t(i)].position[a]);
+            }
+        }
+        int axis = 0;
+        for (int a = 1; a < 3; ++a) {
+            if (high[a] - low[a] > high[axis] - low[axis]) axis = a;
+        }
+
+        const qsizetype middle = begin + (end - begin) / 2;
+        std::nth_element(m_nodes.begin() + begin, m_nodes.begin() + middle, m_nodes.begin() + end,
+                         [axis](const Node &a, const Node &b) { return a.position[axis] < b.position[axis]; });
+        m_nodes[size_t(middle)].axis = axis;
+
+        buildRange(begin, middle);
+        begin = middle + 1;
+    }
+}
+
+qint64 CityIndex::byteSize() const
+{
+    qint64 bytes = qint64(m_cities.capacity()) * qint64(sizeof(CityLocation))
+                   + qint64(m_nodes.capacity()) * qint64(sizeof(Node));
+    for (const CityLocation &city : m_cities) {
+        bytes += qint64(city.name.capacity() + city.country.capacity()) * qint64(sizeof(QChar));
+    }
+    return bytes;
+}
+
+QVector<CityMatch> CityIndex::nearest(double latitude, double longitude, int count) const
+{
+    QVector<CityMatch> result;
+    if (count <= 0 || m_nodes.empty()) return result;
+    // Callable from QML; there are never more matches than cities
+    count = int(std::min(size_t(count), m_nodes.size()));
+
+    float query[3];
+    toUnitVector(latitude, longitude, query);
+
+    // Max-heap of the best candidates so far; the worst one bounds the search
+    std::vector<std::pair<float, quint32>> best;
+    best.reserve(size_t(count) + 1);
+    float bound = std::numeric_limits<float>::infinity();
+    auto accept = [&](const Node &node, float squared) {
+        best.emplace_back(squared, node.city);
+        std::push_heap(best.begin(), best.end());
+        if (best.size() > size_t(count)) {
+            std::pop_heap(best.begin(), best.end());
+            best.pop_back();
+        }
+        if (best.size() == size_t(count)) bound = best.front().first;
+    };
+    searchTree(m_nodes, 0, qsizetype(m_nodes.size()), query, bound, accept);
+
+    std::sort_heap(best.begin(), best.end());
+    result.reserve(qsizetype(best.size()));
+    for (const auto &[squared, city] : best) {
+        result.append({qsizetype(city), chordToKm(squared)});
+    }
+    return result;
+}
+
+QVector<CityMatch> CityIndex::withinRadius(double latitude, double longitude, double radiusKm) const
+{
+    QVector<CityMatch> result;
+    if (radiusKm < 0 || m_nodes.empty()) return result;
+
+    float query[3];
+    toUnitVector(latitude, longitude, query);
+
+    const double angle = std::min(radiusKm / kEarthRadiusKm, M_PI);
+    const double chord = 2 * std::sin(angle / 2);
+    const float bound = float(chord * chord);
+
+    std::vector<std::pair<float, quint32>> found;
+    auto accept = [&found](const Node &node, float squared) {
+        found.emplace_back(squared, node.city);
+    };
+    searchTree(m_nodes, 0, qsizetype(m_nodes.size()), query, bound, accept);
+
+    std::sort(found.begin(), found.end());
+    result.reserve(qsizetype(found.size()));
+    for (const auto &[squared, city] : found) {
+        result.append({qsizetype(city), chordToKm(squared)});
+    }
+    return result;
+}
@@ -0,0 +1,62 @@
+#ifndef CITYINDEX_H
+#define CITYINDEX_H
+
+#include <QString>
+#include <QVector>
+#include <vector>
+
+// A place the reverse lookup can answer with
+struct CityLocation {
+    QString name;
+    QString country; // ISO 3166-1 alpha-2, may be empty
+    double latitude = 0;
+    double longitude = 0;
+
+    QString displayName() const { return country.isEmpty() ? name : name + ", " + country; }
+};
+
+struct CityMatch {
+    qsizetype index = -1; // Into CityIndex::city()
+    double distanceKm = 0; // Great-circle
+};
+
+// Offline coordinates-to-city lookup. Cities are placed on the unit sphere
+// and kept in an implicit k-d tree (a median-split array, no node
+// pointers), so there are no seams at the date line or the poles, and
+// straight-line distance in 3D orders results exactly as great-circle
+// distance does. Building is O(n log n); queries touch O(log n) nodes.
+class CityIndex
+{
+public:
+    // Replaces the contents. One "name,country,latitude,longitude" per line;
+    // '#' starts a comment. False if the file can't be read.
+    bool loadCsv(const QString &path);
+    void build(QVector<CityLocation> cities);
+
+    qsizetype size() const { return m_cities.size(); }
+    bool isEmpty() const { return m_cities.isEmpty(); }
+    const CityLocation &city(qsizetype index) const { return m_cities.at(index); }
+
+    // Heap bytes of the city table and the tree
+    qint64 byteSize() const;
+
+    // The `count` closest cities, nearest first
+    QVector<CityMatch> nearest(double latitude, double longitude, int count) const;
+
+    // Every city within radiusKm, nearest first
+    QVector<CityMatch> withinRadius(double latitude, double longitude, double radiusKm) const;
+
+private:
+    struct Node {
+        float position[3]; // Unit vector
+        quint32 city; // Into m_cities
+        int axis; // Split axis of the subtree this node is the median of
+    };
+
+    void buildRange(qsizetype begin, qsizetype end);
+
+    QVector<CityLocation> m_cities;
+    std::vector<Node> m_nodes; // Median of [begin, end) at the midpoint, recursively
+};
+
+#endif // CITYINDEX_H
@@ -0,0 +1,110 @@
+#include "forecastmodel.h"
+#include <QDateTime>
+#include <QLocale>
+#include <QTimeZone>
+#include "weatherconditions.h"
+
+ForecastModel::ForecastModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_temperatureUnit("Fahrenheit")
+    , m_language("en")
+{
+}
+
+int ForecastModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_days.size());
+}
+
+QVariant ForecastModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_days.size()) return QVariant();
+
+    const int row = index.row();
+    const ForecastDay &day = m_days.at(row);
+    // localMidnight is already shifted into the city's timezone, so read it back as UTC
+    const QDate date = QDateTime::fromSecsSinceEpoch(day.localMidnight, QTimeZone::UTC).date();
+
+    switch (role) {
+        case DayNameRole: return QLocale(m_language).dayName(date.dayOfWeek(), QLocale::ShortFormat);
+        case DateRole: return date;
+        case HighRole: return m_high[size_t(row)];
+        case LowRole: return m_low[size_t(row)];
+        case MeanRole: return m_mean[size_t(row)];
+        case PrecipitationRole: return day.precipitationMm;
+        case PopRole: return day.maxPop;
+        case IconRole: return WeatherConditions::icon(day.conditionId);
+        case DescriptionRole: {
+            QString description = WeatherConditions::description(day.conditionId, m_language);
+            if (!description.isEmpty()) description[0] = description[0].toUpper();
+            return description;
+        }
+        default: return QVariant();
+    }
+}
+
+QHash<int, QByteArray> ForecastModel::roleNames() const
+{
+    return {
+        {DayNameRole, "dayName"},
+        {DateRole, "date"},
+        {HighRole, "high"},
+        {LowRole, "low"},
+        {MeanRole, "mean"},
+        {PrecipitationRole, "precipitation"},
+        {PopRole, "pop"},
+        {IconRole, "icon"},
+        {DescriptionRole, "description"},
+    };
+}
+
+void ForecastModel::setDays(const QVector<ForecastDay> &days)
+{
+    const bool countChanging = days.size() != m_days.size();
+    beginResetModel();
+    m_days = days;
+    convertTemperatures();
+    endResetModel();
+    if (countChanging) {
+        emit countChanged();
+    }
+}
+
+void ForecastModel::setTemperatureUnit(const QString &unit)
+{
+    if (m_temperatureUnit == unit) return;
+    m_temperatureUnit = unit;
+    convertTemperatures();
+    if (!m_days.isEmpty()) {
+        emit dataChanged(index(0), index(int(m_days.size()) - 1), {HighRole, LowRole, MeanRole});
+    }
+}
+
+void ForecastModel::setLanguage(const QString &language)
+{
+    if (m_language == language) return;
+    m_language = language;
+    if (!m_days.isEmpty()) {
+        emit dataChanged(index(0), index(int(m_days.size()) - 1), {DayNameRole, DescriptionRole});
+    }
+}
+
+void ForecastModel::convertTemperatures()
+{
+    // Kelvin is never displayed (see WeatherService::convertTemperature)
+    const float scale = m_temperatureUnit == "Celsius" ? 1.0f : 9.0f / 5.0f;
+    const float offset = m_temperatureUnit == "Celsius" ? -273.15f : -273.15f * 9.0f / 5.0f + 32.0f;
+
+    const size_t count = size_t(m_days.size());
+    m_high.resize(count);
+    m_low.resize(count);
+    m_mean.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        m_high[i] = m_days[qsizetype(i)].maxKelvin;
+        m_low[i] = m_days[qsizetype(i)].minKelvin;
+        m_mean[i] = m_days[qsizetype(i)].meanKelvin;
+    }
+    ForecastKernels::affine(m_high.data(), m_high.data(), qsizetype(count), scale, offset);
+    ForecastKernels::affine(m_low.data(), m_low.data(), qsizetype(count), scale, offset);
+    ForecastKernels::affine(m_mean.data(), m_mean.data(), qsizetype(count), scale, offset);
+}
@@ -0,0 +1,54 @@
+#ifndef FORECASTMODEL_H
+#define FORECASTMODEL_H
+
+#include <QAbstractListModel>
+#include <QString>
+#include <QVector>
+#include <vector>
+#include "forecaststore.h"
+
+// Daily forecast rows for QML. Temperatures are converted to the display
+// unit once per update, column-wise, rather than on every data() call.
+class ForecastModel : public QAbstractListModel
+{
+    Q_OBJECT
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+public:
+    enum Role {
+        DayNameRole = Qt::UserRole + 1,
+        DateRole,
+        HighRole,
+        LowRole,
+        MeanRole,
+        PrecipitationRole,
+        PopRole,
+        IconRole,
+        DescriptionRole,
+    };
+
+    explicit ForecastModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    void setDays(const QVector<ForecastDay> &days);
+    void setTemperatureUnit(const QString &unit);
+    void setLanguage(const QString &language);
+
+signals:
+    void countChanged();
+
+private:
+    void convertTemperatures();
+
+    QVector<ForecastDay> m_days;
+    std::vector<float> m_high; // Display unit
+    std::vector<float> m_low;
+    std::vector<float> m_mean;
+    QString m_temperatureUnit;
+    QString m_language;
+};
+
+#endif // FORECASTMODEL_H
@@ -0,0 +1,343 @@
+#include "forecaststore.h"
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QVarLengthArray>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
+namespace {
+
+// Lane count of the kernels: one AVX register of floats, two SSE/NEON ones.
+// It also happens to be one day of 3-hour steps
+constexpr int kLanes = 8;
+
+constexpr qint64 kSecondsPerDay = 24 * 60 * 60;
+
+// OpenWeatherMap's 5-day forecast is 40 steps; sized so ingest never allocates
+constexpr int kTypicalSteps = 40;
+
+// One step across all five columns
+constexpr qint64 kStepBytes = sizeof(qint64) + 3 * sizeof(float) + sizeof(quint16);
+
+// A Range, its QHash node and a short city name
+constexpr qint64 kCityBytes = sizeof(qint64) * 4 + 64;
+
+qint64 localDay(qint64 unixSeconds, int utcOffsetSeconds)
+{
+    const qint64 local = unixSeconds + utcOffsetSeconds;
+    return local >= 0 ? local / kSecondsPerDay : (local - kSecondsPerDay + 1) / kSecondsPerDay;
+}
+
+template<typename T>
+void appendColumn(std::vector<T> &column, const T *values, qsizetype count)
+{
+    column.insert(column.end(), values, values + count);
+}
+
+template<typename T>
+void copyColumn(std::vector<T> &column, qsizetype offset, const T *values, qsizetype count)
+{
+    std::copy(values, values + count, column.begin() + offset);
+}
+
+} // namespace
+
+namespace ForecastKernels {
+
+void minMaxSum(const float *values, qsizetype count, float *min, float *max, float *sum)
+{
+    float lo[kLanes], hi[kLanes], acc[kLanes];
+    for (int lane = 0; lane < kLanes; ++lane) {
+        lo[lane] = std::numeric_limits<float>::infinity();
+        hi[lane] = -std::numeric_limits<float>::infinity();
+        acc[lane] = 0;
+    }
+
+    qsizetype i = 0;
+    for (; i + kLanes <= count; i += kLanes) {
+        for (int lane = 0; lane < kLanes; ++lane) {
+            const float v = values[i + lane];
+            lo[lane] = v < lo[lane] ? v : lo[lane];
+            hi[lane] = v > hi[lane] ? v : hi[lane];
+            acc[lane] += v;
+        }
+    }
+    for (int lane = 0; i < count; ++i, ++lane) {
+        const float v = values[i];
+        lo[lane] = v < lo[lane] ? v : lo[lane];
+        hi[lane] = v > hi[lane] ? v : hi[lane];
+        acc[lane] += v;
+    }
+
+    float outLo = lo[0], outHi = hi[0], outSum = acc[0];
+    for (int lane = 1; lane < kLanes; ++lane) {
+        outLo = lo[lane] < outLo ? lo[lane] : outLo;
+        outHi = hi[lane] > outHi ? hi[lane] : outHi;
+        outSum += acc[lane];
+    }
+    *min = outLo;
+    *max = outHi;
+    *sum = outSum;
+}
+
+float sum(const float *values, qsizetype count)
+{
+    float acc[kLanes] = {};
+    qsizetype i = 0;
+    for (; i + kLanes <= count; i += kLanes) {
+        for (int lane = 0; lane < kLanes; ++lane) {
+            acc[lane] += values[i + lane];
+        }
+    }
+    for (int lane = 0; i < count; ++i, ++lane) {
+        acc[lane] += values[i];
+    }
+
+    float total = 0;
+    for (int lane = 0; lane < kLanes; ++lane) {
+        total += acc[lane];
+    }
+    return total;
+}
+
+float max(const float *values, qsizetype count)
+{
+    float hi[kLanes];
+    for (int lane = 0; lane < kLanes; ++lane) {
+        hi[lane] = -std::numeric_limits<float>::infinity();
+    }
+
+    qsizetype i = 0;
+    for (; i + kLanes <= count; i += kLanes) {
+        for (int lane = 0; lane < kLanes; ++lane) {
+            const float v = values[i + lane];
+            hi[lane] = v > hi[lane] ? v : hi[lane];
+        }
+    }
+    for (int lane = 0; i < count; ++i, ++lane) {
+        hi[lane] = values[i] > hi[lane] ? values[i] : hi[lane];
+    }
+
+    float out = hi[0];
+    for (int lane = 1; lane < kLanes; ++lane) {
+        out = hi[lane] > out ? hi[lane] : out;
+    }
+    return out;
+}
+
+void affine(const float *in, float *out, qsizetype count, float scale, float offset)
+{
+    for (qsizetype i = 0; i < count; ++i) {
+        out[i] = in[i] * scale + offset;
+    }
+}
+
+} // namespace ForecastKernels
+
+bool ForecastStore::ingest(const QString &city, const QJsonObject &forecast, qint64 fetchedAtMs)
+{
+    const QJsonArray list = forecast["list"].toArray();
+    if (list.isEmpty()) return false;
+
+    QVarLengthArray<qint64, kTypicalSteps> times;
+    QVarLengthArray<float, kTypicalSteps> temperature;
+    QVarLengthArray<float, kTypicalSteps> precipitation;
+    QVarLengthArray<float, kTypicalSteps> pop;
+    QVarLengthArray<quint16, kTypicalSteps> conditions;
+
+    for (const QJsonValue &value : list) {
+        const QJsonObject step = value.toObject();
+        const qint64 time = step["dt"].toInteger();
+        // Steps must be ascending for the per-day runs; drop anything out of order
+        if (!times.isEmpty() && time <= times.last()) continue;
+
+        times.append(time);
+        temperature.append(float(step["main"].toObject()["temp"].toDouble()));
+        precipitation.append(float(step["rain"].toObject()["3h"].toDouble()
+                                   + step["snow"].toObject()["3h"].toDouble()));
+        pop.append(float(step["pop"].toDouble()));
+        conditions.append(quint16(step["weather"].toArray().at(0).toObject()["id"].toInt()));
+    }
+
+    const int utcOffset = forecast["city"].toObject()["timezone"].toInt();
+    setSeries(city, times.constData(), temperature.constData(), precipitation.constData(),
+              pop.constData(), conditions.constData(), times.size(), utcOffset, fetchedAtMs);
+    return true;
+}
+
+void ForecastStore::setSeries(const QString &city, const qint64 *times, const float *temperatureKelvin,
+                              const float *precipitationMm, const float *pop, const quint16 *conditionIds,
+                              qsizetype count, int utcOffsetSeconds, qint64 fetchedAtMs)
+{
+    auto it = m_ranges.find(city);
+    if (it != m_ranges.end() && it->count == count) {
+        // Refreshes nearly always keep the step count; rewrite in place
+        copyColumn(m_times, it->offset, times, count);
+        copyColumn(m_temperature, it->offset, temperatureKelvin, count);
+        copyColumn(m_precipitation, it->offset, precipitationMm, count);
+        copyColumn(m_pop, it->offset, pop, count);
+        copyColumn(m_conditions, it->offset, conditionIds, count);
+    } else {
+        if (it == m_ranges.end()) {
+            it = m_ranges.insert(city, Range());
+        } else {
+            m_abandoned += it->count;
+        }
+        it->offset = qsizetype(m_times.size());
+        it->count = count;
+        appendColumn(m_times, times, count);
+        appendColumn(m_temperature, temperatureKelvin, count);
+        appendColumn(m_precipitation, precipitationMm, count);
+        appendColumn(m_pop, pop, count);
+        appendColumn(m_conditions, conditionIds, count);
+    }
+    it->utcOffsetSeconds = utcOffsetSeconds;
+    it->fetchedAtMs = fetchedAtMs;
+
+    if (m_abandoned * 2 > qsizetype(m_times.size())) {
+        compact();
+    }
+}
+
+void ForecastStore::remove(const QString &city)
+{
+    auto it = m_ranges.find(city);
+    if (it == m_ranges.end()) return;
+
+    m_abandoned += it->count;
+    m_ranges.erase(it);
+    if (m_abandoned * 2 > qsizetype(m_times.size())) {
+        compact();
+    }
+}
+
+void ForecastStore::clear()
+{
+    m_ranges.clear();
+    m_times.clear();
+    m_temperature.clear();
+    m_precipitation.clear();
+    m_pop.clear();
+    m_conditions.clear();
+    m_abandoned = 0;
+}
+
+qint64 ForecastStore::byteSize() const
+{
+    return qint64(m_times.capacity()) * qint64(sizeof(qint64))
+           + qint64(m_temperature.capacity() + m_precipitation.capacity() + m_pop.capacity()) * qint64(sizeof(float))
+           + qint64(m_conditions.capacity()) * qint64(sizeof(quint16))
+           + qint64(m_ranges.size()) * kCityBytes;
+}
+
+void ForecastStore::evictOldest(qint64 targetBytes, const QStringList &keep)
+{
+    QList<std::pair<qint64, QString>> candidates; // fetchedAtMs, city
+    for (auto it = m_ranges.cbegin(); it != m_ranges.cend(); ++it) {
+        if (!keep.contains(it.key())) candidates.append({it->fetchedAtMs, it.key()});
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    // What the store will take once compacted
+    qint64 live = qint64(stepCount()) * kStepBytes + qint64(m_ranges.size()) * kCityBytes;
+    for (const auto &candidate : std::as_const(candidates)) {
+        if (live <= targetBytes) break;
+        const Range &range = m_ranges.value(candidate.second);
+        live -= qint64(range.count) * kStepBytes + kCityBytes;
+        m_abandoned += range.count;
+        m_ranges.remove(candidate.second);
+    }
+    if (m_abandoned > 0) compact();
+}
+
+qint64 ForecastStore::fetchedAtMs(const QString &city) const
+{
+    auto it = m_ranges.constFind(city);
+    return it == m_ranges.cend() ? -1 : it->fetchedAtMs;
+}
+
+int ForecastStore::utcOffsetSeconds(const QString &city) const
+{
+    auto it = m_ranges.constFind(city);
+    return it == m_ranges.cend() ? 0 : it->utcOffsetSeconds;
+}
+
+QVector<ForecastDay> ForecastStore::daily(const QString &city) const
+{
+    QVector<ForecastDay> days;
+    auto it = m_ranges.constFind(city);
+    if (it == m_ranges.cend() || it->count == 0) return days;
+
+    const Range &range = *it;
+    const qint64 *times = m_times.data() + range.offset;
+    const float *temperature = m_temperature.data() + range.offset;
+    const float *precipitation = m_precipitation.data() + range.offset;
+    const float *pop = m_pop.data() + range.offset;
+    const quint16 *conditions = m_conditions.data() + range.offset;
+    days.reserve(int(range.count / kLanes) + 2);
+
+    qsizetype begin = 0;
+    while (begin < range.count) {
+        const qint64 day = localDay(times[begin], range.utcOffsetSeconds);
+        qsizetype end = begin + 1;
+        while (end < range.count && localDay(times[end], range.utcOffsetSeconds) == day) {
+            ++end;
+        }
+        const qsizetype steps = end - begin;
+
+        ForecastDay out;
+        out.localMidnight = day * kSecondsPerDay;
+        float total = 0;
+        ForecastKernels::minMaxSum(temperature + begin, steps, &out.minKelvin, &out.maxKelvin, &total);
+        out.meanKelvin = total / float(steps);
+        out.precipitationMm = ForecastKernels::sum(precipitation + begin, steps);
+        out.maxPop = ForecastKernels::max(pop + begin, steps);
+
+        // The midday step is the best single summary of the day's sky
+        const qint64 noon = out.localMidnight + kSecondsPerDay / 2;
+        qsizetype nearest = begin;
+        for (qsizetype i = begin + 1; i < end; ++i) {
+            if (qAbs(times[i] + range.utcOffsetSeconds - noon)
+                < qAbs(times[nearest] + range.utcOffsetSeconds - noon)) {
+                nearest = i;
+            }
+        }
+        out.conditionId = conditions[nearest];
+
+        days.append(out);
+        begin = end;
+    }
+    return days;
+}
+
+void ForecastStore::compact()
+{
+    std::vector<qint64> times;
+    std::vector<float> temperature, precipitation, pop;
+    std::vector<quint16> conditions;
+    const size_t live = m_times.size() - size_t(m_abandoned);
+    times.reserve(live);
+    temperature.reserve(live);
+    precipitation.reserve(live);
+    pop.reserve(live);
+    conditions.reserve(live);
+
+    for (Range &range : m_ranges) {
+        const qsizetype offset = range.offset;
+        range.offset = qsizetype(times.size());
+        appendColumn(times, m_times.data() + offset, range.count);
+        appendColumn(temperature, m_temperature.data() + offset, range.count);
+        appendColumn(precipitation, m_precipitation.data() + offset, range.count);
+        appendColumn(pop, m_pop.data() + offset, range.count);
+        appendColumn(conditions, m_conditions.data() + offset, range.count);
+    }
+
+    m_times.swap(times);
+    m_temperature.swap(temperature);
+    m_precipitation.swap(precipitation);
+    m_pop.swap(pop);
+    m_conditions.swap(conditions);
+    m_abandoned = 0;
+}
@@ -0,0 +1,91 @@
+#ifndef FORECASTSTORE_H
+#define FORECASTSTORE_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <vector>
+
+// Forward declarations for faster compilation
+class QJsonObject;
+
+// One local calendar day folded out of a city's 3-hour forecast steps
+struct ForecastDay {
+    qint64 localMidnight = 0; // Seconds since the epoch, shifted into the city's timezone
+    float minKelvin = 0;
+    float maxKelvin = 0;
+    float meanKelvin = 0;
+    float precipitationMm = 0; // Rain plus snow (water equivalent)
+    float maxPop = 0; // Highest probability of precipitation, 0-1
+    int conditionId = 0; // Condition of the step nearest local noon
+};
+
+// Straight-line float kernels over contiguous arrays. Each keeps eight
+// independent lane accumulators so the compiler can hold them in vector
+// registers without needing -ffast-math to reorder the reductions.
+namespace ForecastKernels {
+void minMaxSum(const float *values, qsizetype count, float *min, float *max, float *sum);
+float sum(const float *values, qsizetype count);
+float max(const float *values, qsizetype count);
+// out[i] = in[i] * scale + offset; in and out may be the same array
+void affine(const float *in, float *out, qsizetype count, float scale, float offset);
+} // namespace ForecastKernels
+
+// 5-day/3-hour forecasts for any number of cities, stored column-wise: one
+// contiguous array per variable shared by all cities, with each city owning
+// a contiguous range. Aggregation walks a few dense float arrays instead of
+// chasing per-step objects. A replaced forecast of the same length is
+// rewritten in place; otherwise the old range is abandoned and reclaimed
+// once abandoned steps make up half the store.
+class ForecastStore
+{
+public:
+    // Parses an OpenWeatherMap /data/2.5/forecast response; false if malformed
+    bool ingest(const QString &city, const QJsonObject &forecast, qint64 fetchedAtMs);
+
+    // Column-wise insert, used by ingest() and by the benchmark
+    void setSeries(const QString &city, const qint64 *times, const float *temperatureKelvin,
+                   const float *precipitationMm, const float *pop, const quint16 *conditionIds,
+                   qsizetype count, int utcOffsetSeconds, qint64 fetchedAtMs);
+
+    bool contains(const QString &city) const { return m_ranges.contains(city); }
+    void remove(const QString &city);
+    void clear();
+
+    // -1 if the city has no forecast
+    qint64 fetchedAtMs(const QString &city) const;
+    int utcOffsetSeconds(const QString &city) const;
+
+    QVector<ForecastDay> daily(const QString &city) const;
+
+    qsizetype cityCount() const { return m_ranges.size(); }
+    qsizetype stepCount() const { return qsizetype(m_times.size()) - m_abandoned; }
+
+    // Heap bytes held by the columns and the city table
+    qint64 byteSize() const;
+
+    // Removes the least recently fetched cities, except those in keep, until
+    // the store holds at most targetBytes, and compacts what remains
+    void evictOldest(qint64 targetBytes, const QStringList &keep);
+
+private:
+    struct Range {
+        qsizetype offset = 0;
+        qsizetype count = 0;
+        int utcOffsetSeconds = 0;
+        qint64 fetchedAtMs = 0;
+    };
+
+    void compact();
+
+    QHash<QString, Range> m_ranges;
+    std::vector<qint64> m_times; // Unix seconds, ascending within a range
+    std::vector<float> m_temperature; // Kelvin
+    std::vector<float> m_precipitation; // mm over the 3-hour step
+    std::vector<float> m_pop;
+    std::vector<quint16> m_conditions;
+    qsizetype m_abandoned = 0;
+};
+
+#endif // FORECASTSTORE_H
@@ -0,0 +1,209 @@
+#include "frameprofiler.h"
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMetaObject>
+#include <QQuickWindow>
+#include <QTimer>
+#include "logging.h"
+
+namespace {
+
+// Two frames at 60 Hz; anything slower shows as a hitch
+constexpr double kLongFrameMs = 33.4;
+// A signal that changes something visible has its frame under way within a
+// vsync or two; one with no frame by then caused none, and the next frame
+// (a hover, seconds later) isn't its to answer for
+constexpr qint64 kPendingFrameWindowNs = 2 * 16700000;
+
+constexpr int kPublishIntervalMs = 500;
+constexpr qsizetype kRecentFrames = 1024;
+constexpr qsizetype kMaxLongFrames = 64;
+
+} // namespace
+
+FrameProfiler::FrameProfiler(QObject *parent)
+    : QObject(parent)
+    , m_publishTimer(new QTimer(this))
+{
+    m_clock.start();
+    m_recentFrames.reserve(kRecentFrames);
+
+    // The overlay's own repaints count as frames; twice a second keeps that small
+    m_publishTimer->setInterval(kPublishIntervalMs);
+    connect(m_publishTimer, &QTimer::timeout, this, &FrameProfiler::publish);
+    m_publishTimer->start();
+}
+
+void FrameProfiler::attach(QQuickWindow *window)
+{
+    // Direct, so the timestamps are taken on the render thread as the frame happens
+    connect(window, &QQuickWindow::beforeSynchronizing, this, [this]() { onBeforeSynchronizing(); },
+            Qt::DirectConnection);
+    connect(window, &QQuickWindow::frameSwapped, this, [this]() { onFrameSwapped(); }, Qt::DirectConnection);
+}
+
+void FrameProfiler::watchSignal(QObject *sender, const char *signal, const std::function<int()> &receivers)
+{
+    // SIGNAL() puts a code digit in front of the signature
+    const QByteArray signature = QMetaObject::normalizedSignature(signal + 1);
+    const int index = sender->metaObject()->indexOfSignal(signature.constData());
+    if (index < 0) {
+        qCWarning(lcFrames) << "Can't watch" << signature << "on" << sender;
+        return;
+    }
+
+    WatchedSignal watched;
+    watched.sender = sender;
+    watched.signalIndex = index;
+    watched.name = signature.left(signature.indexOf('('));
+    watched.receivers = receivers;
+    {
+        QMutexLocker locker(&m_mutex);
+        m_signals.append(watched);
+    }
+    connect(sender, signal, this, SLOT(onWatchedSignal()));
+}
+
+void FrameProfiler::onWatchedSignal()
+{
+    // QML bindings are notified before ordinary connections, so by now they
+    // have re-evaluated; their cost shows in RequestMetrics' binding phase
+    const QObject *source = sender();
+    const int index = senderSignalIndex();
+
+    QMutexLocker locker(&m_mutex);
+    for (int i = 0; i < m_signals.size(); ++i) {
+        WatchedSignal &watched = m_signals[i];
+        if (watched.sender != source || watched.signalIndex != index) continue;
+
+        const int bindings = qMax(0, watched.receivers() - 1); // Less this connection
+        ++watched.emissions;
+        watched.bindings += bindings;
+        if (m_pending < 0) {
+            m_pending = i;
+            m_pendingSinceNs = m_clock.nsecsElapsed();
+            m_pendingBindings = bindings;
+        }
+        return;
+    }
+}
+
+void FrameProfiler::onBeforeSynchronizing()
+{
+    QMutexLocker locker(&m_mutex);
+    m_frameStartNs = m_clock.nsecsElapsed();
+    if (m_pending >= 0 && m_frameStartNs - m_pendingSinceNs > kPendingFrameWindowNs) {
+        ++m_signals[m_pending].withoutFrame;
+        m_pending = -1;
+    }
+}
+
+void FrameProfiler::onFrameSwapped()
+{
+    QMutexLocker locker(&m_mutex);
+    const qint64 now = m_clock.nsecsElapsed();
+    if (m_frameStartNs < 0) return; // Attached mid-frame
+
+    const qint64 frameNs = now - m_frameStartNs;
+    const float frameMs = float(frameNs / 1e6);
+    m_frames.record(frameNs / 1000);
+    ++m_frameCount;
+    if (m_recentFrames.size() < kRecentFrames) {
+        m_recentFrames.append(frameMs);
+    } else {
+        m_recentFrames[m_recentHead] = frameMs;
+        m_recentHead = (m_recentHead + 1) % kRecentFrames;
+    }
+
+    const auto noteLongFrame = [this, now](const QByteArray &cause, double ms, int bindings) {
+        m_longFrames.prepend({now / 1000000, cause, ms, bindings});
+        if (m_longFrames.size() > kMaxLongFrames) m_longFrames.removeLast();
+    };
+
+    // A signal that arrived after sync began only shows up in the next frame
+    if (m_pending >= 0 && m_pendingSinceNs < m_frameStartNs) {
+        WatchedSignal &watched = m_signals[m_pending];
+        const qint64 latencyNs = now - m_pendingSinceNs;
+        watched.latency.record(latencyNs / 1000);
+        if (latencyNs / 1e6 > kLongFrameMs) {
+            ++watched.longFrames;
+            noteLongFrame(watched.name, latencyNs / 1e6, m_pendingBindings);
+        }
+        m_pending = -1;
+    } else if (frameMs > kLongFrameMs) {
+        ++m_otherLongFrames;
+        noteLongFrame("other", frameMs, 0);
+    }
+    m_frameStartNs = -1;
+}
+
+void FrameProfiler::publish()
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        const qint64 now = m_clock.nsecsElapsed();
+        const qint64 frames = m_frameCount - m_publishedFrameCount;
+        m_fps = now > m_publishedAtNs ? frames * 1e9 / double(now - m_publishedAtNs) : 0.0;
+        m_publishedFrameCount = m_frameCount;
+        m_publishedAtNs = now;
+    }
+    emit statsChanged();
+}
+
+QVariantMap FrameProfiler::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    QVariantList signalStats;
+    for (const WatchedSignal &watched : m_signals) {
+        QVariantMap entry;
+        entry["name"] = QString::fromLatin1(watched.name);
+        entry["emissions"] = watched.emissions;
+        entry["bindingsPerEmission"] = watched.emissions ? double(watched.bindings) / watched.emissions : 0.0;
+        entry["latency"] = watched.latency.toVariantMap();
+        entry["longFrames"] = watched.longFrames;
+        entry["withoutFrame"] = watched.withoutFrame;
+        signalStats.append(entry);
+    }
+
+    QVariantMap map;
+    map["fps"] = m_fps;
+    map["frames"] = m_frames.toVariantMap();
+    map["signals"] = signalStats;
+    map["otherLongFrames"] = m_otherLongFrames;
+    map["longFrameMs"] = kLongFrameMs;
+    return map;
+}
+
+bool FrameProfiler::writeReport(const QString &path) const
+{
+    QJsonObject report = QJsonObject::fromVariantMap(stats());
+
+    QMutexLocker locker(&m_mutex);
+    QJsonArray longFrames;
+    for (const LongFrame &frame : m_longFrames) {
+        longFrames.append(QJsonObject{
+            {"atMs", frame.atMs},
+            {"cause", QString::fromLatin1(frame.cause)},
+            {"ms", frame.ms},
+            {"bindings", frame.bindings},
+        });
+    }
+    QJsonArray recentFrames; // Oldest first
+    for (qsizetype i = 0; i < m_recentFrames.size(); ++i) {
+        recentFrames.append(m_recentFrames.at((m_recentHead + i) % m_recentFrames.size()));
+    }
+    locker.unlock();
+
+    report["longFrameLog"] = longFrames;
+    report["recentFrameMs"] = recentFrames;
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(lcFrames) << "Can't write frame report" << path << file.errorString();
+        return false;
+    }
+    file.write(QJsonDocument(report).toJson());
+    return true;
+}
@@ -0,0 +1,100 @@
+#ifndef FRAMEPROFILER_H
+#define FRAMEPROFILER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QVariantMap>
+#include <QVector>
+#include <functional>
+#include "requestmetrics.h"
+
+// Forward declarations for faster compilation
+class QQuickWindow;
+class QTimer;
+
+// Opt-in rendering instrumentation (ELEGANTWEATHER_FRAMES=path). Each frame
+// of the attached window is timed from the start of scene graph sync to the
+// buffer swap. For each watched C++ signal it counts emissions, the
+// bindings each emission re-evaluates, and the latency from the emission to
+// the end of the next frame, which covers binding evaluation, polish and
+// the frame itself. A latency over kLongFrameMs is a long frame charged to
+// the first watched signal since the previous frame; long frames with no
+// signal before them are charged to "other". A signal whose frame doesn't
+// start within two vsyncs changed nothing on screen; it is counted as
+// without a frame and charged nothing.
+class FrameProfiler : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QVariantMap stats READ stats NOTIFY statsChanged)
+
+public:
+    explicit FrameProfiler(QObject *parent = nullptr);
+
+    void attach(QQuickWindow *window);
+
+    // signal is a SIGNAL() string. receivers returns the sender's
+    // QObject::receivers() for it, which counts the QML bindings that depend
+    // on it as well as ordinary connections (this profiler's included).
+    void watchSignal(QObject *sender, const char *signal, const std::function<int()> &receivers);
+
+    // Refreshed twice a second for the overlay: fps, frame time percentiles,
+    // per-signal emissions, bindings per emission, latency and long frames
+    QVariantMap stats() const;
+
+    // Histograms, per-signal stats, recent long frames and the last frame
+    // times, as JSON
+    Q_INVOKABLE bool writeReport(const QString &path) const;
+
+signals:
+    void statsChanged();
+
+private slots:
+    void onWatchedSignal();
+    void publish();
+
+private:
+    struct WatchedSignal {
+        QObject *sender = nullptr;
+        int signalIndex = -1;
+        QByteArray name;
+        std::function<int()> receivers;
+        qint64 emissions = 0;
+        qint64 bindings = 0; // Summed over emissions
+        qint64 longFrames = 0;
+        qint64 withoutFrame = 0; // Emissions no frame followed promptly
+        LatencyHistogram latency; // Emission to the end of the next frame
+    };
+
+    struct LongFrame {
+        qint64 atMs; // Since the profiler started
+        QByteArray cause;
+        double ms;
+        int bindings;
+    };
+
+    // Both run on the render thread
+    void onBeforeSynchronizing();
+    void onFrameSwapped();
+
+    mutable QMutex m_mutex; // The render thread and the GUI thread share everything below
+    QElapsedTimer m_clock;
+    QList<WatchedSignal> m_signals;
+    LatencyHistogram m_frames;
+    QVector<float> m_recentFrames; // Ring of frame times in ms, m_recentHead is the oldest
+    qsizetype m_recentHead = 0;
+    QList<LongFrame> m_longFrames; // Most recent first
+    qint64 m_frameStartNs = -1;
+    int m_pending = -1; // First watched signal since the last frame
+    qint64 m_pendingSinceNs = 0;
+    int m_pendingBindings = 0;
+    qint64 m_otherLongFrames = 0;
+    qint64 m_frameCount = 0;
+    qint64 m_publishedFrameCount = 0;
+    qint64 m_publishedAtNs = 0;
+    double m_fps = 0;
+    QTimer *m_publishTimer;
+};
+
+#endif // FRAMEPROFILER_H
@@ -0,0 +1,528 @@
+#include "historystore.h"
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+// ~114 days of 10-minute observations, 640 KB per segment
+constexpr quint32 kSegmentCapacity = 16384;
+
+// Each mapped segment holds a file descriptor; stay well under typical limits
+constexpr int kMaxMappedSegments = 256;
+
+constexpr char kMagic[4] = {'E', 'W', 'H', 'S'};
+constexpr quint32 kFormatVersion = 1;
+
+// Native byte order; the history is a local cache, not an interchange format
+struct SegmentHeader {
+    char magic[4];
+    quint32 version;
+    quint32 recordSize;
+    quint32 capacity;
+    quint32 count; // Bumped only after the record itself is written
+    quint32 resolutionSeconds; // 0 = as observed, otherwise set by compaction
+    qint64 firstTime;
+    qint64 lastTime;
+    char reserved[24];
+};
+static_assert(sizeof(SegmentHeader) == 64, "SegmentHeader is an on-disk format");
+
+qint64 segmentBytes(quint32 capacity)
+{
+    return qint64(sizeof(SegmentHeader)) + qint64(capacity) * qint64(sizeof(HistoryRecord));
+}
+
+// File names sort in time order
+QString segmentFileName(qint64 firstTime)
+{
+    return QString("%1.seg").arg(firstTime, 12, 10, QChar('0'));
+}
+
+// City names carry commas, spaces and non-Latin scripts; hex keeps them path-safe
+QString cityDirectoryName(const QString &city)
+{
+    return QString::fromLatin1(city.toUtf8().toHex());
+}
+
+bool readHeader(const QString &path, SegmentHeader *header)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+    if (file.read(reinterpret_cast<char *>(header), sizeof(SegmentHeader)) != qint64(sizeof(SegmentHeader))) {
+        return false;
+    }
+    return std::memcmp(header->magic, kMagic, sizeof(kMagic)) == 0
+           && header->version == kFormatVersion
+           && header->recordSize == sizeof(HistoryRecord)
+           && header->count <= header->capacity
+           && file.size() >= segmentBytes(header->capacity);
+}
+
+// Written once every replacement segment of a compaction is on disk; from
+// then on the compaction is finished on the next load if it's interrupted
+constexpr char kCompactionJournal[] = "compact.journal";
+
+// Moves each staged replacement ("r <name>") over its final name, then
+// removes the segments it superseded ("d <name>"). Every step can be
+// repeated, so a crash at any point is picked up where it stopped.
+void applyCompactionJournal(const QDir &dir)
+{
+    QFile journal(dir.filePath(kCompactionJournal));
+    if (!journal.open(QIODevice::ReadOnly)) return;
+    const QList<QByteArray> lines = journal.readAll().split('\n');
+    journal.close();
+
+    for (const QByteArray &line : lines) {
+        const QString name = QString::fromUtf8(line.mid(2));
+        if (line.startsWith("r ")) {
+            const QString staged = dir.filePath(name + ".compact");
+            if (!QFile::exists(staged)) continue; // Already moved
+            QFile::remove(dir.filePath(name));
+            QFile::rename(staged, dir.filePath(name));
+        } else if (line.startsWith("d ")) {
+            QFile::remove(dir.filePath(name));
+        }
+    }
+    journal.remove();
+}
+
+} // namespace
+
+HistoryStore::HistoryStore(const QString &directory)
+    : m_directory(directory)
+{
+}
+
+HistoryStore::~HistoryStore()
+{
+    for (auto &entry : m_cities) {
+        for (Segment &segment : entry.second.segments) {
+            unmapSegment(segment);
+        }
+    }
+}
+
+HistoryStore::CityHistory &HistoryStore::cityHistory(const QString &city)
+{
+    auto it = m_cities.find(city);
+    if (it != m_cities.end()) return it->second;
+
+    // First touch: index the city's segments from their headers
+    CityHistory &history = m_cities[city];
+    history.directory = m_directory + "/" + cityDirectoryName(city);
+
+    QDir dir(history.directory);
+    applyCompactionJournal(dir);
+    const QStringList files = dir.entryList({"*.seg"}, QDir::Files, QDir::Name);
+    for (const QString &name : files) {
+        Segment segment;
+        segment.path = dir.filePath(name);
+        SegmentHeader header;
+        if (!readHeader(segment.path, &header) || header.count == 0) continue;
+
+        segment.firstTime = header.firstTime;
+        segment.lastTime = header.lastTime;
+        segment.count = header.count;
+        segment.capacity = header.capacity;
+        segment.resolutionSeconds = header.resolutionSeconds;
+        history.segments.push_back(std::move(segment));
+    }
+
+    // Leftovers of a compaction that never committed its journal. Where the
+    // segments they were to replace are still here they're redundant; a
+    // complete one covering time no segment covers is all that's left of
+    // that range, so it's promoted.
+    const QStringList staged = dir.entryList({"*.compact"}, QDir::Files, QDir::Name);
+    bool promoted = false;
+    for (const QString &name : staged) {
+        const QString path = dir.filePath(name);
+        const QString finalPath = path.chopped(QLatin1String(".compact").size());
+        SegmentHeader header;
+        const auto overlaps = [&header](const Segment &segment) {
+            return segment.firstTime <= header.lastTime && header.firstTime <= segment.lastTime;
+        };
+        if (!readHeader(path, &header) || header.count == 0
+            || std::any_of(history.segments.cbegin(), history.segments.cend(), overlaps)
+            || QFile::exists(finalPath) || !QFile::rename(path, finalPath)) {
+            QFile::remove(path);
+            continue;
+        }
+
+        Segment segment;
+        segment.path = finalPath;
+        segment.firstTime = header.firstTime;
+        segment.lastTime = header.lastTime;
+        segment.count = header.count;
+        segment.capacity = header.capacity;
+        segment.resolutionSeconds = header.resolutionSeconds;
+        history.segments.push_back(std::move(segment));
+        promoted = true;
+    }
+    if (promoted) {
+        std::sort(history.segments.begin(), history.segments.end(),
+                  [](const Segment &a, const Segment &b) { return a.firstTime < b.firstTime; });
+    }
+    return history;
+}
+
+bool HistoryStore::createSegment(CityHistory &history, qint64 firstTime)
+{
+    if (!QDir().mkpath(history.directory)) return false;
+
+    Segment segment;
+    segment.path = history.directory + "/" + segmentFileName(firstTime);
+    segment.capacity = kSegmentCapacity;
+
+    QFile file(segment.path);
+    if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate)) return false;
+
+    SegmentHeader header = {};
+    std::memcpy(header.magic, kMagic, sizeof(kMagic));
+    header.version = kFormatVersion;
+    header.recordSize = sizeof(HistoryRecord);
+    header.capacity = kSegmentCapacity;
+    // Sparse on most filesystems; blocks are only allocated as records land
+    if (file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header))
+        || !file.resize(segmentBytes(kSegmentCapacity))) {
+        file.remove();
+        return false;
+    }
+    file.close();
+
+    history.segments.push_back(std::move(segment));
+    return true;
+}
+
+bool HistoryStore::mapSegment(Segment &segment)
+{
+    segment.lastUse = ++m_useClock;
+    if (segment.map) return true;
+
+    evictMappedSegments();
+
+    auto file = std::make_unique<QFile>(segment.path);
+    if (!file->open(QIODevice::ReadWrite)) return false;
+    uchar *map = file->map(0, segmentBytes(segment.capacity));
+    if (!map) return false;
+
+    segment.file = std::move(file);
+    segment.map = map;
+    ++m_mappedCount;
+    return true;
+}
+
+void HistoryStore::unmapSegment(Segment &segment)
+{
+    if (!segment.map) return;
+    segment.file->unmap(segment.map);
+    segment.file.reset();
+    segment.map = nullptr;
+    --m_mappedCount;
+}
+
+void HistoryStore::evictMappedSegments()
+{
+    if (m_mappedCount < kMaxMappedSegments) return;
+
+    Segment *oldest = nullptr;
+    for (auto &entry : m_cities) {
+        for (Segment &segment : entry.second.segments) {
+            if (segment.map && (!oldest || segment.lastUse < oldest->lastUse)) {
+                oldest = &segment;
+            }
+        }
+    }
+    if (oldest) unmapSegment(*oldest);
+}
+
+qint64 HistoryStore::mappedBytes() const
+{
+    qint64 bytes = 0;
+    for (const auto &entry : m_cities) {
+        for (const Segment &segment : entry.second.segments) {
+            if (segment.map) bytes += segmentBytes(segment.capacity);
+        }
+    }
+    return bytes;
+}
+
+void HistoryStore::trimMapped(qint64 targetBytes)
+{
+    std::vector<Segment *> mapped;
+    qint64 bytes = 0;
+    for (auto &entry : m_cities) {
+        for (Segment &segment : entry.second.segments) {
+            if (!segment.map) continue;
+            mapped.push_back(&segment);
+            bytes += segmentBytes(segment.capacity);
+        }
+    }
+    std::sort(mapped.begin(), mapped.end(),
+              [](const Segment *a, const Segment *b) { return a->lastUse < b->lastUse; });
+
+    for (Segment *segment : mapped) {
+        if (bytes <= targetBytes) break;
+        bytes -= segmentBytes(segment->capacity);
+        unmapSegment(*segment);
+    }
+}
+
+HistoryRecord *HistoryStore::records(Segment &segment)
+{
+    return reinterpret_cast<HistoryRecord *>(segment.map + sizeof(SegmentHeader));
+}
+
+bool HistoryStore::append(const QString &city, const HistoryRecord &record)
+{
+    CityHistory &history = cityHistory(city);
+    if (!history.segments.empty() && record.time <= history.segments.back().lastTime) {
+        return false;
+    }
+
+    if (history.segments.empty() || history.segments.back().count >= history.segments.back().capacity) {
+        if (!createSegment(history, record.time)) return false;
+    }
+
+    Segment &segment = history.segments.back();
+    if (!mapSegment(segment)) return false;
+
+    auto *header = reinterpret_cast<SegmentHeader *>(segment.map);
+    records(segment)[segment.count] = record;
+    if (segment.count == 0) {
+        header->firstTime = record.time;
+        segment.firstTime = record.time;
+    }
+    header->lastTime = record.time;
+    header->count = ++segment.count;
+    segment.lastTime = record.time;
+    return true;
+}
+
+bool HistoryStore::setLatestUvIndex(const QString &city, float uvIndex)
+{
+    CityHistory &history = cityHistory(city);
+    if (history.segments.empty()) return false;
+
+    Segment &segment = history.segments.back();
+    if (segment.count == 0 || !mapSegment(segment)) return false;
+    records(segment)[segment.count - 1].uvIndex = uvIndex;
+    return true;
+}
+
+void HistoryStore::scan(const QString &city, qint64 from, qint64 to,
+                        const std::function<void(const HistoryRecord *, qsizetype)> &visit)
+{
+    CityHistory &history = cityHistory(city);
+
+    // Skip straight to the first segment that can overlap the range
+    auto segment = std::lower_bound(history.segments.begin(), history.segments.end(), from,
+                                    [](const Segment &s, qint64 time) { return s.lastTime < time; });
+    for (; segment != history.segments.end() && segment->firstTime < to; ++segment) {
+        if (!mapSegment(*segment)) continue;
+
+        const HistoryRecord *begin = records(*segment);
+        const HistoryRecord *end = begin + segment->count;
+        const auto byTime = [](const HistoryRecord &r, qint64 time) { return r.time < time; };
+        const HistoryRecord *first = std::lower_bound(begin, end, from, byTime);
+        const HistoryRecord *last = std::lower_bound(first, end, to, byTime);
+        if (first != last) {
+            visit(first, last - first);
+        }
+    }
+}
+
+QVector<HistoryRecord> HistoryStore::range(const QString &city, qint64 from, qint64 to)
+{
+    QVector<HistoryRecord> result;
+    scan(city, from, to, [&result](const HistoryRecord *records, qsizetype count) {
+        const qsizetype at = result.size();
+        result.resize(at + count);
+        std::copy(records, records + count, result.begin() + at);
+    });
+    return result;
+}
+
+QVector<HistoryBucket> HistoryStore::downsample(const QString &city, qint64 from, qint64 to, int buckets)
+{
+    QVector<HistoryBucket> result;
+    if (buckets <= 0 || to <= from) return result;
+
+    const qint64 width = qMax<qint64>(1, (to - from + buckets - 1) / buckets);
+    std::vector<HistoryBucket> slices(size_t(buckets));
+    std::vector<double> temperatureSums(size_t(buckets)), humiditySums(size_t(buckets)), windSums(size_t(buckets));
+
+    scan(city, from, to, [&](const HistoryRecord *records, qsizetype count) {
+        for (qsizetype i = 0; i < count; ++i) {
+            const HistoryRecord &r = records[i];
+            const size_t index = size_t(qMin<qint64>((r.time - from) / width, buckets - 1));
+            HistoryBucket &slice = slices[index];
+            if (slice.count++ == 0) {
+                slice.minTemperatureKelvin = r.temperatureKelvin;
+                slice.maxTemperatureKelvin = r.temperatureKelvin;
+            } else {
+                slice.minTemperatureKelvin = qMin(slice.minTemperatureKelvin, r.temperatureKelvin);
+                slice.maxTemperatureKelvin = qMax(slice.maxTemperatureKelvin, r.temperatureKelvin);
+            }
+            slice.maxUvIndex = qMax(slice.maxUvIndex, r.uvIndex);
+            temperatureSums[index] += r.temperatureKelvin;
+            humiditySums[index] += r.humidity;
+            windSums[index] += r.windSpeed;
+        }
+    });
+
+    for (size_t i = 0; i < slices.size(); ++i) {
+        HistoryBucket &slice = slices[i];
+        if (slice.count == 0) continue;
+        slice.start = from + qint64(i) * width;
+        slice.meanTemperatureKelvin = float(temperatureSums[i] / slice.count);
+        slice.meanHumidity = float(humiditySums[i] / slice.count);
+        slice.meanWindSpeed = float(windSums[i] / slice.count);
+        result.append(slice);
+    }
+    return result;
+}
+
+int HistoryStore::compact(const QString &city, qint64 olderThan, qint64 resolutionSeconds)
+{
+    CityHistory &history = cityHistory(city);
+    if (resolutionSeconds <= 0) return 0;
+
+    // Sealed segments entirely before the cutoff; the newest segment is
+    // never touched since it's still being appended to
+    size_t eligible = 0;
+    bool finerThanTarget = false;
+    while (eligible + 1 < history.segments.size() && history.segments[eligible].lastTime < olderThan) {
+        finerThanTarget |= history.segments[eligible].resolutionSeconds < resolutionSeconds;
+        ++eligible;
+    }
+    if (eligible == 0 || !finerThanTarget) return 0;
+
+    // Average each resolution-sized slot into one record
+    std::vector<HistoryRecord> merged;
+    HistoryRecord slot;
+    double sums[5] = {};
+    int slotCount = 0;
+    qint64 slotKey = std::numeric_limits<qint64>::min();
+    const auto flush = [&]() {
+        if (slotCount == 0) return;
+        slot.temperatureKelvin = float(sums[0] / slotCount);
+        slot.feelsLikeKelvin = float(sums[1] / slotCount);
+        slot.humidity = float(sums[2] / slotCount);
+        slot.windSpeed = float(sums[3] / slotCount);
+        slot.pressure = float(sums[4] / slotCount);
+        merged.push_back(slot);
+    };
+
+    for (size_t s = 0; s < eligible; ++s) {
+        Segment &segment = history.segments[s];
+        if (!mapSegment(segment)) return 0;
+        const HistoryRecord *begin = records(segment);
+        for (const HistoryRecord *r = begin; r != begin + segment.count; ++r) {
+            const qint64 key = r->time / resolutionSeconds;
+            if (key != slotKey) {
+                flush();
+                slotKey = key;
+                slot = *r; // Time and condition of the slot's first observation
+                std::fill(std::begin(sums), std::end(sums), 0.0);
+                slotCount = 0;
+            }
+            sums[0] += r->temperatureKelvin;
+            sums[1] += r->feelsLikeKelvin;
+            sums[2] += r->humidity;
+            sums[3] += r->windSpeed;
+            sums[4] += r->pressure;
+            slot.uvIndex = qMax(slot.uvIndex, r->uvIndex);
+            ++slotCount;
+        }
+    }
+    flush();
+
+    // Stage the packed segments under temporary names, commit a journal,
+    // then swap them in; see applyCompactionJournal()
+    std::vector<Segment> replacements;
+    for (size_t offset = 0; offset < merged.size(); offset += kSegmentCapacity) {
+        const quint32 count = quint32(qMin<size_t>(kSegmentCapacity, merged.size() - offset));
+        Segment segment;
+        segment.path = history.directory + "/" + segmentFileName(merged[offset].time);
+        segment.firstTime = merged[offset].time;
+        segment.lastTime = merged[offset + count - 1].time;
+        segment.count = count;
+        segment.capacity = kSegmentCapacity;
+        segment.resolutionSeconds = quint32(resolutionSeconds);
+
+        SegmentHeader header = {};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kFormatVersion;
+        header.recordSize = sizeof(HistoryRecord);
+        header.capacity = kSegmentCapacity;
+        header.count = count;
+        header.resolutionSeconds = segment.resolutionSeconds;
+        header.firstTime = segment.firstTime;
+        header.lastTime = segment.lastTime;
+
+        // QSaveFile syncs on commit, so nothing is journaled before it's durable
+        QSaveFile file(segment.path + ".compact");
+        const qint64 recordBytes = qint64(count) * qint64(sizeof(HistoryRecord));
+        if (!file.open(QIODevice::WriteOnly)
+            || file.write(reinterpret_cast<const char *>(&header), sizeof(header)) != qint64(sizeof(header))
+            || file.write(reinterpret_cast<const char *>(merged.data() + offset), recordBytes) != recordBytes
+            || !file.resize(segmentBytes(kSegmentCapacity))
+            || !file.commit()) {
+            for (const Segment &written : replacements) QFile::remove(written.path + ".compact");
+            return 0;
+        }
+        replacements.push_back(std::move(segment));
+    }
+
+    QByteArray entries;
+    QStringList replacedNames;
+    for (const Segment &segment : replacements) {
+        replacedNames.append(QFileInfo(segment.path).fileName());
+        entries += "r " + replacedNames.last().toUtf8() + '\n';
+    }
+    for (size_t s = 0; s < eligible; ++s) {
+        const QString name = QFileInfo(history.segments[s].path).fileName();
+        if (!replacedNames.contains(name)) entries += "d " + name.toUtf8() + '\n';
+    }
+    const QDir dir(history.directory);
+    QSaveFile journal(dir.filePath(kCompactionJournal));
+    if (!journal.open(QIODevice::WriteOnly) || journal.write(entries) != entries.size() || !journal.commit()) {
+        for (const Segment &written : replacements) QFile::remove(written.path + ".compact");
+        return 0;
+    }
+
+    for (size_t s = 0; s < eligible; ++s) {
+        unmapSegment(history.segments[s]);
+    }
+    applyCompactionJournal(dir);
+
+    history.segments.erase(history.segments.begin(), history.segments.begin() + qptrdiff(eligible));
+    history.segments.insert(history.segments.begin(),
+                            std::make_move_iterator(replacements.begin()),
+                            std::make_move_iterator(replacements.end()));
+    return int(eligible);
+}
+
+QStringList HistoryStore::cities() const
+{
+    QStringList result;
+    const QStringList directories = QDir(m_directory).entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    for (const QString &name : directories) {
+        result.append(QString::fromUtf8(QByteArray::fromHex(name.toLatin1())));
+    }
+    return result;
+}
+
+qint64 HistoryStore::recordCount(const QString &city)
+{
+    qint64 total = 0;
+    for (const Segment &segment : cityHistory(city).segments) {
+        total += segment.count;
+    }
+    return total;
+}
@@ -0,0 +1,119 @@
+#ifndef HISTORYSTORE_H
+#define HISTORYSTORE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Forward declarations for faster compilation
+class QFile;
+
+// One observation as stored on disk. Fixed size, so a segment is a plain
+// array and the n-th record sits at a known offset.
+struct HistoryRecord {
+    qint64 time = 0; // Unix seconds of the observation
+    float temperatureKelvin = 0;
+    float feelsLikeKelvin = 0;
+    float humidity = 0; // Percent
+    float windSpeed = 0; // m/s
+    float pressure = 0; // hPa on Earth, Pa on Mars
+    float uvIndex = -1; // -1 until a UV reading arrives
+    quint16 conditionId = 0; // OpenWeatherMap condition code, 0 for Mars
+    quint16 reserved[3] = {};
+};
+static_assert(sizeof(HistoryRecord) == 40, "HistoryRecord is an on-disk format");
+
+// Aggregate of the records falling into one slice of a downsampled query
+struct HistoryBucket {
+    qint64 start = 0; // Unix seconds
+    int count = 0;
+    float minTemperatureKelvin = 0;
+    float maxTemperatureKelvin = 0;
+    float meanTemperatureKelvin = 0;
+    float meanHumidity = 0;
+    float meanWindSpeed = 0;
+    float maxUvIndex = -1;
+};
+
+// Append-only observation history, one directory per city. Each directory
+// holds fixed-capacity segment files that are memory-mapped on demand, so
+// appends are a store into mapped memory and range scans read records in
+// place. Records within a city must arrive in time order; a record that
+// isn't newer than the last one (e.g. a refetch of the same observation)
+// is dropped. Only a bounded number of segments stay mapped at once.
+class HistoryStore
+{
+public:
+    explicit HistoryStore(const QString &directory);
+    ~HistoryStore();
+
+    HistoryStore(const HistoryStore &) = delete;
+    HistoryStore &operator=(const HistoryStore &) = delete;
+
+    QString directory() const { return m_directory; }
+
+    // False if the record isn't newer than the city's latest or the write failed
+    bool append(const QString &city, const HistoryRecord &record);
+
+    // UV arrives in a separate reply; patch it into the newest record
+    bool setLatestUvIndex(const QString &city, float uvIndex);
+
+    // Calls visit with each contiguous run of records in [from, to), oldest
+    // first. The pointers are into mapped memory and only valid during the call.
+    void scan(const QString &city, qint64 from, qint64 to,
+              const std::function<void(const HistoryRecord *, qsizetype)> &visit);
+    QVector<HistoryRecord> range(const QString &city, qint64 from, qint64 to);
+
+    // [from, to) split into equal slices, empty slices omitted; for charts
+    QVector<HistoryBucket> downsample(const QString &city, qint64 from, qint64 to, int buckets);
+
+    // Rewrites sealed segments whose records all predate olderThan at one
+    // averaged record per resolutionSeconds, packed into full segments.
+    // Returns the number of segments removed. Journaled, so an interrupted
+    // compaction is finished on the next load rather than losing records.
+    int compact(const QString &city, qint64 olderThan, qint64 resolutionSeconds);
+
+    QStringList cities() const;
+    qint64 recordCount(const QString &city);
+
+    // Bytes of segment files mapped right now, and unmapping the least
+    // recently used segments until at most targetBytes are; they are mapped
+    // again when next touched
+    qint64 mappedBytes() const;
+    void trimMapped(qint64 targetBytes);
+
+private:
+    struct Segment {
+        QString path;
+        qint64 firstTime = 0;
+        qint64 lastTime = 0;
+        quint32 count = 0;
+        quint32 capacity = 0;
+        quint32 resolutionSeconds = 0;
+        std::unique_ptr<QFile> file; // Open only while mapped
+        uchar *map = nullptr;
+        quint64 lastUse = 0;
+    };
+    struct CityHistory {
+        QString directory;
+        std::vector<Segment> segments; // Ascending by time
+    };
+
+    CityHistory &cityHistory(const QString &city);
+    bool createSegment(CityHistory &history, qint64 firstTime);
+    bool mapSegment(Segment &segment);
+    void unmapSegment(Segment &segment);
+    void evictMappedSegments();
+    HistoryRecord *records(Segment &segment);
+
+    QString m_directory;
+    std::unordered_map<QString, CityHistory> m_cities; // Segments own files, so no QHash
+    int m_mappedCount = 0;
+    quint64 m_useClock = 0;
+};
+
+#endif // HISTORYSTORE_H
@@ -0,0 +1,144 @@
+#include "logging.h"
+#include <QThread>
+#include <atomic>
+#include <cstdio>
+#include <utility>
+
+Q_LOGGING_CATEGORY(lcAiAgent, "elegantweather.ai", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcCache, "elegantweather.cache", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcFrames, "elegantweather.frames", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcMemory, "elegantweather.memory", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcNetwork, "elegantweather.network", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcWeather, "elegantweather.weather", QtInfoMsg)
+
+namespace {
+
+// Lines moved out of the ring per lock, so a flood doesn't starve loggers
+constexpr qsizetype kWriteBatch = 256;
+
+std::atomic<AsyncLogSink *> g_installed{nullptr};
+
+} // namespace
+
+AsyncLogSink::AsyncLogSink(const QString &path, qsizetype capacity)
+{
+    m_ring.resize(qMax<qsizetype>(1, capacity));
+
+    m_file.setFileName(path);
+    if (path.isEmpty() || !m_file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+        if (!path.isEmpty()) std::fprintf(stderr, "Can't open log file %s; logging to stderr\n", qPrintable(path));
+        m_file.open(stderr, QIODevice::WriteOnly, QFileDevice::DontCloseHandle);
+    }
+
+    m_writer = QThread::create([this] { run(); });
+    m_writer->setObjectName("AsyncLogSink");
+    m_writer->start(QThread::LowPriority);
+
+    AsyncLogSink *installed = nullptr;
+    if (g_installed.compare_exchange_strong(installed, this)) {
+        m_previousHandler = qInstallMessageHandler(handleMessage);
+    } else {
+        qWarning() << "An AsyncLogSink is already installed; this one stays idle";
+    }
+}
+
+AsyncLogSink::~AsyncLogSink()
+{
+    AsyncLogSink *self = this;
+    if (g_installed.compare_exchange_strong(self, nullptr)) {
+        qInstallMessageHandler(m_previousHandler);
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stopping = true;
+        m_pending.wakeOne();
+    }
+    m_writer->wait(); // Drains the ring first
+    delete m_writer;
+}
+
+void AsyncLogSink::flush()
+{
+    QMutexLocker locker(&m_mutex);
+    const qint64 target = m_pushedTotal;
+    while (m_writtenTotal < target) {
+        m_written.wait(&m_mutex);
+    }
+}
+
+qint64 AsyncLogSink::droppedCount() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_dropped;
+}
+
+void AsyncLogSink::handleMessage(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    QString line = qFormatLogMessage(type, context, message);
+    AsyncLogSink *sink = g_installed.load(std::memory_order_acquire);
+    if (!sink) {
+        // Raced with the sink being removed
+        std::fprintf(stderr, "%s\n", qUtf8Printable(line));
+        return;
+    }
+
+    sink->push(std::move(line), type);
+    if (type == QtFatalMsg) sink->flush(); // Qt aborts as soon as this returns
+}
+
+void AsyncLogSink::push(QString line, QtMsgType type)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_count == m_ring.size()) {
+        ++m_dropped;
+        if (type != QtCriticalMsg && type != QtFatalMsg) return;
+
+        // An error outranks the oldest line; a fatal one is the reason Qt is about to abort
+        m_head = (m_head + 1) % m_ring.size();
+        --m_count;
+        ++m_writtenTotal; // Settled, as far as flush() is concerned
+    }
+
+    m_ring[(m_head + m_count) % m_ring.size()] = std::move(line);
+    ++m_count;
+    ++m_pushedTotal;
+    if (m_count == 1) m_pending.wakeOne(); // Otherwise the writer is already busy
+}
+
+void AsyncLogSink::run()
+{
+    QStringList batch;
+    batch.reserve(kWriteBatch);
+
+    QMutexLocker locker(&m_mutex);
+    for (;;) {
+        while (m_count == 0 && !m_stopping) {
+            m_pending.wait(&m_mutex);
+        }
+        if (m_count == 0) break; // Stopping, and everything is written
+
+        const qsizetype taken = qMin(m_count, kWriteBatch);
+        for (qsizetype i = 0; i < taken; ++i) {
+            batch.append(std::move(m_ring[m_head]));
+            m_head = (m_head + 1) % m_ring.size();
+        }
+        m_count -= taken;
+        const qint64 dropped = m_dropped - m_droppedReported;
+        m_droppedReported = m_dropped;
+        locker.unlock();
+
+        for (const QString &line : std::as_const(batch)) {
+            m_file.write(line.toUtf8().append('\n'));
+        }
+        if (dropped > 0) {
+            m_file.write(QByteArray::number(dropped) + " log messages dropped, buffer full\n");
+        }
+        m_file.flush();
+        batch.clear();
+
+        locker.relock();
+        m_writtenTotal += taken;
+        m_written.wakeAll();
+    }
+}
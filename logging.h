@@ -0,0 +1,68 @@
+#ifndef LOGGING_H
+#define LOGGING_H
+
+#include <QFile>
+#include <QLoggingCategory>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+#include <QWaitCondition>
+
+// Forward declarations for faster compilation
+class QThread;
+
+// Logging categories. Debug output is off by default; turn it on with e.g.
+// QT_LOGGING_RULES="elegantweather.ai.debug=true". qCDebug() evaluates its
+// arguments only when the category is enabled, so a disabled statement
+// costs one flag check.
+Q_DECLARE_LOGGING_CATEGORY(lcAiAgent)
+Q_DECLARE_LOGGING_CATEGORY(lcCache)
+Q_DECLARE_LOGGING_CATEGORY(lcFrames)
+Q_DECLARE_LOGGING_CATEGORY(lcMemory)
+Q_DECLARE_LOGGING_CATEGORY(lcNetwork)
+Q_DECLARE_LOGGING_CATEGORY(lcWeather)
+
+// Message handler that hands formatted lines to a writer thread through a
+// bounded ring buffer, so the logging thread pays for formatting and a
+// short lock but never for I/O. When the buffer is full new lines are
+// dropped and counted rather than blocking the caller, except critical and
+// fatal ones, which push out the oldest waiting line instead; fatal messages
+// are written out before Qt aborts. Only one sink can be installed at a time.
+class AsyncLogSink
+{
+public:
+    // Appends to path; stderr when path is empty or can't be opened
+    explicit AsyncLogSink(const QString &path = QString(), qsizetype capacity = 4096);
+    // Writes out whatever is buffered and restores the previous handler
+    ~AsyncLogSink();
+
+    AsyncLogSink(const AsyncLogSink &) = delete;
+    AsyncLogSink &operator=(const AsyncLogSink &) = delete;
+
+    // Blocks until every line logged so far has been written
+    void flush();
+    qint64 droppedCount() const;
+
+private:
+    static void handleMessage(QtMsgType type, const QMessageLogContext &context, const QString &message);
+    void push(QString line, QtMsgType type);
+    void run();
+
+    QFile m_file;
+    QThread *m_writer = nullptr;
+    QtMessageHandler m_previousHandler = nullptr;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_pending; // Wakes the writer
+    QWaitCondition m_written; // Wakes flush()
+    QStringList m_ring;
+    qsizetype m_head = 0; // Oldest unwritten line
+    qsizetype m_count = 0;
+    qint64 m_pushedTotal = 0;
+    qint64 m_writtenTotal = 0;
+    qint64 m_dropped = 0;
+    qint64 m_droppedReported = 0;
+    bool m_stopping = false;
+};
+
+#endif // LOGGING_H
@@ -1,19 +1,98 @@
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
 #include <QQmlContext>
+#include <QQuickWindow>
+#include <QSslConfiguration>
 #include "weatherservice.h"
 #include "aiagent.h"
+#include "benchmarks.h"
+#include "batchexporter.h"
+#include "logging.h"
+#include "startupprofiler.h"
+#include "frameprofiler.h"
+#include "memorybudget.h"
+#include "backgroundimages.h"
+#include <memory>
+
+// Extra trust anchors from ELEGANTWEATHER_CA_CERTS, e.g. for a local TLS stand-in server
+static void loadExtraCaCertificates()
+{
+#if QT_CONFIG(ssl)
+    const QString caCertificates = qEnvironmentVariable("ELEGANTWEATHER_CA_CERTS");
+    if (!caCertificates.isEmpty()) {
+        QSslConfiguration ssl = QSslConfiguration::defaultConfiguration();
+        ssl.addCaCertificates(caCertificates);
+        QSslConfiguration::setDefaultConfiguration(ssl);
+    }
+#endif
+}
 
 int main(int argc, char *argv[])
 {
+    // Headless benchmark suite: ElegantWeather --benchmark [name...]
+    if (argc > 1 && qstrcmp(argv[1], "--benchmark") == 0) {
+        QCoreApplication app(argc, argv);
+        loadExtraCaCertificates();
+        return runBenchmarks(app.arguments().mid(2));
+    }
+    // Bulk export: ElegantWeather --batch [options] cities.txt
+    if (argc > 1 && qstrcmp(argv[1], "--batch") == 0) {
+        QCoreApplication app(argc, argv);
+        loadExtraCaCertificates();
+        return runBatch(app.arguments().mid(2));
+    }
+    if (argc > 1 && qstrcmp(argv[1], "--benchmark-worker") == 0) {
+        QCoreApplication app(argc, argv);
+        loadExtraCaCertificates();
+        return runBenchmarkWorker(app.arguments().mid(2));
+    }
+
+    // Cold launch timings: ElegantWeather --startup-profile prints them and exits after the first frame
+    const bool profileStartup = argc > 1 && qstrcmp(argv[1], "--startup-profile") == 0;
+    StartupProfiler::start(profileStartup);
+
     QGuiApplication app(argc, argv);
+    StartupProfiler::mark("application");
+    // Log I/O happens off the GUI thread; ELEGANTWEATHER_LOG picks a file over stderr
+    AsyncLogSink logSink(qEnvironmentVariable("ELEGANTWEATHER_LOG"));
+    loadExtraCaCertificates();
+    StartupProfiler::mark("logging, certificates");
+
+    // Caches, mapped history, backgrounds and chat history, under budgets from the [memory] settings
+    MemoryBudget memoryBudget;
+    memoryBudget.loadSettings();
 
     WeatherService weatherService;
+    weatherService.registerMemory(&memoryBudget);
+    StartupProfiler::mark("weather service");
     AIAgent aiAgent;
+    aiAgent.registerMemory(&memoryBudget);
+    StartupProfiler::mark("ai agent");
+
+    // Frame timing overlay and report, only with ELEGANTWEATHER_FRAMES=path.
+    // Outlives the engine, so the window never signals a destroyed profiler.
+    const QString framesPath = qEnvironmentVariable("ELEGANTWEATHER_FRAMES");
+    std::unique_ptr<FrameProfiler> frameProfiler;
+    if (!framesPath.isEmpty()) {
+        frameProfiler = std::make_unique<FrameProfiler>();
+        const auto receivers = [&weatherService](const char *signal) {
+            return [&weatherService, signal]() { return weatherService.signalReceivers(signal); };
+        };
+        frameProfiler->watchSignal(&weatherService, SIGNAL(weatherDataChanged()), receivers(SIGNAL(weatherDataChanged())));
+        frameProfiler->watchSignal(&weatherService, SIGNAL(citySuggestionsChanged()),
+                                   receivers(SIGNAL(citySuggestionsChanged())));
+    }
 
     QQmlApplicationEngine engine;
+    auto *backgrounds = new BackgroundImageProvider; // Owned by the engine
+    backgrounds->registerMemory(&memoryBudget);
+    engine.addImageProvider("backgrounds", backgrounds);
+    weatherService.setBackgroundImages(backgrounds);
     engine.rootContext()->setContextProperty("weatherService", &weatherService);
     engine.rootContext()->setContextProperty("aiAgent", &aiAgent);
+    engine.rootContext()->setContextProperty("frameProfiler", frameProfiler.get());
+    engine.rootContext()->setContextProperty("memoryBudget", &memoryBudget);
+    StartupProfiler::mark("qml engine");
 
     const QUrl url(QStringLiteral("qrc:/main.qml"));
     QObject::connect(
@@ -26,6 +105,35 @@ int main(int argc, char *argv[])
         },
         Qt::QueuedConnection);
     engine.load(url);
+    StartupProfiler::mark("qml load");
+
+    // Network setup waits until the window has painted once
+    auto *window = qobject_cast<QQuickWindow *>(engine.rootObjects().value(0));
+    if (window && frameProfiler) {
+        frameProfiler->attach(window);
+    }
+    if (window) {
+        QObject::connect(
+            window,
+            &QQuickWindow::frameSwapped,
+            &weatherService,
+            [&weatherService]() {
+                StartupProfiler::mark("first frame");
+                weatherService.startNetwork();
+                StartupProfiler::mark("network setup");
+                if (StartupProfiler::isEnabled()) {
+                    StartupProfiler::report();
+                    QCoreApplication::quit();
+                }
+            },
+            Qt::SingleShotConnection);
+    } else {
+        weatherService.startNetwork();
+    }
 
-    return app.exec();
+    const int status = app.exec();
+    if (frameProfiler) {
+        frameProfiler->writeReport(framesPath);
+    }
+    return status;
 }
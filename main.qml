@@ -15,6 +15,26 @@ ApplicationWindow {
     // Toggle for detailed weather view
     property bool showDetailedWeather: false
 
+    // Blurs the background while either dialog is up
+    readonly property bool dialogVisible: (settingsLoader.item !== null && settingsLoader.item.visible)
+                                          || (chatLoader.item !== null && chatLoader.item.visible)
+
+    function openSettings() {
+        if (settingsLoader.item) {
+            settingsLoader.item.open()
+        } else {
+            settingsLoader.active = true
+        }
+    }
+
+    function openChat() {
+        if (chatLoader.item) {
+            chatLoader.item.open()
+        } else {
+            chatLoader.active = true
+        }
+    }
+
     // Main background container with rounded corners
     Rectangle {
         anchors.fill: parent
@@ -36,7 +56,7 @@ ApplicationWindow {
                 fillMode: Image.PreserveAspectCrop
                 opacity: 0
                 asynchronous: true
-                cache: true
+                cache: false // The backgrounds image provider keeps downloaded photos
                 visible: weatherService.currentPlanet === "Earth"
 
                 onStatusChanged: {
@@ -89,7 +109,7 @@ ApplicationWindow {
                          weatherService.currentPlanet === "Mars"
             }
 
-            layer.enabled: settingsDialog.visible || chatDialog.visible
+            layer.enabled: root.dialogVisible
             layer.effect: MultiEffect {
                 blurEnabled: true
                 blur: 1.0
@@ -99,20 +119,42 @@ ApplicationWindow {
         }
     }
 
-    // Settings Dialog
-    SettingsDialog {
-        id: settingsDialog
+    // Dialogs are created the first time they're opened, not before the first
+    // frame; the chat dialog also starts the AI service only then
+    Loader {
+        id: settingsLoader
+        active: false
+        source: "SettingsDialog.qml"
+        onLoaded: {
+            item.parent = root.contentItem
+            item.open()
+        }
+    }
+
+    Loader {
+        id: chatLoader
+        active: false
+        source: "ChatDialog.qml"
+        onLoaded: {
+            item.parent = root.contentItem
+            item.open()
+        }
     }
 
-    // Chat Dialog
-    ChatDialog {
-        id: chatDialog
+    // Frame profiler readout; frameProfiler is null unless ELEGANTWEATHER_FRAMES is set
+    Loader {
+        active: frameProfiler !== null
+        source: "FrameOverlay.qml"
+        anchors.left: parent.left
+        anchors.bottom: parent.bottom
+        anchors.margins: 8
+        z: 1000
     }
 
     // Show settings on first run or if API key not set
     Component.onCompleted: {
         if (!weatherService.apiKeySet) {
-            settingsDialog.open()
+            root.openSettings()
         }
     }
 
@@ -133,7 +175,7 @@ ApplicationWindow {
             // Glassmorphic AI Button
             Button {
                 text: "🗪"
-                onClicked: chatDialog.open()
+                onClicked: root.openChat()
 
                 background: Rectangle {
                     implicitWidth: 48
@@ -180,7 +222,7 @@ ApplicationWindow {
             // Glassmorphic Settings Button
             Button {
                 text: "⚙"
-                onClicked: settingsDialog.open()
+                onClicked: root.openSettings()
 
                 background: Rectangle {
                     implicitWidth: 48
@@ -743,6 +785,43 @@ ApplicationWindow {
                     }
                 }
 
+                // Five-day forecast strip
+                Row {
+                    Layout.alignment: Qt.AlignHCenter
+                    spacing: 18
+                    visible: !weatherService.showingPlanet && weatherService.forecast.count > 0
+
+                    Repeater {
+                        model: weatherService.forecast
+
+                        Column {
+                            spacing: 2
+
+                            Text {
+                                anchors.horizontalCenter: parent.horizontalCenter
+                                text: model.dayName
+                                font.pixelSize: 13
+                                font.weight: Font.Medium
+                                color: "white"
+                                opacity: 0.8
+                            }
+
+                            Text {
+                                anchors.horizontalCenter: parent.horizontalCenter
+                                text: model.icon
+                                font.pixelSize: 22
+                            }
+
+                            Text {
+                                anchors.horizontalCenter: parent.horizontalCenter
+                                text: Math.round(model.high) + "° " + Math.round(model.low) + "°"
+                                font.pixelSize: 13
+                                color: "white"
+                            }
+                        }
+                    }
+                }
+
                 Item { Layout.fillHeight: true }
 
                 // Premium Glassmorphic Details Card
@@ -0,0 +1,128 @@
+#include "marssolcache.h"
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+namespace {
+
+QByteArray contentHash(const QByteArray &bytes)
+{
+    return QCryptographicHash::hash(bytes, QCryptographicHash::Sha256).toHex();
+}
+
+bool writeAtomically(const QString &path, const QByteArray &bytes)
+{
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(bytes);
+    return file.commit();
+}
+
+} // namespace
+
+MarsSolCache::MarsSolCache(const QString &directory)
+    : m_directory(directory)
+{
+    loadIndex();
+}
+
+QString MarsSolCache::objectPath(const QByteArray &hash) const
+{
+    return m_directory + "/objects/" + QString::fromLatin1(hash) + ".json";
+}
+
+void MarsSolCache::loadIndex()
+{
+    QFile file(m_directory + "/index.json");
+    if (!file.open(QIODevice::ReadOnly)) return;
+
+    const QJsonObject index = QJsonDocument::fromJson(file.readAll()).object();
+    const QJsonObject sols = index["sols"].toObject();
+    for (auto it = sols.begin(); it != sols.end(); ++it) {
+        m_index.insert(it.key().toInt(), it.value().toString().toLatin1());
+    }
+    m_etag = index["etag"].toString().toLatin1();
+    m_fetchedAtMs = index["fetchedAt"].toInteger();
+}
+
+bool MarsSolCache::saveIndex() const
+{
+    QJsonObject sols;
+    for (auto it = m_index.cbegin(); it != m_index.cend(); ++it) {
+        sols[QString::number(it.key())] = QString::fromLatin1(it.value());
+    }
+
+    QJsonObject index;
+    index["sols"] = sols;
+    index["etag"] = QString::fromLatin1(m_etag);
+    index["fetchedAt"] = m_fetchedAtMs;
+    if (!QDir().mkpath(m_directory)) return false;
+    return writeAtomically(m_directory + "/index.json", QJsonDocument(index).toJson(QJsonDocument::Compact));
+}
+
+QJsonObject MarsSolCache::sol(const QString &sol)
+{
+    const int number = sol.toInt();
+    auto decoded = m_decoded.constFind(number);
+    if (decoded != m_decoded.cend()) return *decoded;
+
+    auto entry = m_index.constFind(number);
+    if (entry == m_index.cend()) return QJsonObject();
+
+    QFile file(objectPath(*entry));
+    const QByteArray bytes = file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+    if (contentHash(bytes) != *entry) {
+        // Missing or damaged; forget it so the next fetch stores it again
+        m_index.remove(number);
+        saveIndex();
+        return QJsonObject();
+    }
+
+    const QJsonObject report = QJsonDocument::fromJson(bytes).object();
+    m_decoded.insert(number, report);
+    m_decodedBytes += bytes.size();
+    return report;
+}
+
+bool MarsSolCache::insert(const QString &sol, const QJsonObject &report)
+{
+    const int number = sol.toInt();
+    if (m_index.contains(number)) return false;
+
+    const QByteArray bytes = QJsonDocument(report).toJson(QJsonDocument::Compact);
+    const QByteArray hash = contentHash(bytes);
+
+    // Identical reports share one object, so an existing file is already correct
+    if (!QDir().mkpath(m_directory + "/objects")) return false;
+    const QString path = objectPath(hash);
+    if (!QFile::exists(path) && !writeAtomically(path, bytes)) return false;
+
+    m_index.insert(number, hash);
+    m_decoded.insert(number, report);
+    m_decodedBytes += bytes.size();
+    return saveIndex();
+}
+
+QStringList MarsSolCache::sols() const
+{
+    QStringList result;
+    for (auto it = m_index.cbegin(); it != m_index.cend(); ++it) {
+        result.append(QString::number(it.key()));
+    }
+    return result;
+}
+
+void MarsSolCache::setFetched(const QByteArray &etag, qint64 fetchedAtMs)
+{
+    m_etag = etag;
+    m_fetchedAtMs = fetchedAtMs;
+    saveIndex();
+}
+
+void MarsSolCache::dropDecoded()
+{
+    m_decoded.clear();
+    m_decodedBytes = 0;
+}
@@ -0,0 +1,55 @@
+#ifndef MARSSOLCACHE_H
+#define MARSSOLCACHE_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+// Permanent store for InSight per-sol reports. A sol's report never changes
+// once published, so each one is written once as an object named by the
+// SHA-256 of its bytes, and a small index maps sol numbers to objects.
+// Objects are checked against their name when read back; a damaged one is
+// dropped from the index and will be fetched again.
+class MarsSolCache
+{
+public:
+    explicit MarsSolCache(const QString &directory);
+
+    bool contains(const QString &sol) const { return m_index.contains(sol.toInt()); }
+
+    // Empty if the sol isn't cached or its object is damaged
+    QJsonObject sol(const QString &sol);
+
+    // False if the sol was already cached (it is never overwritten) or the write failed
+    bool insert(const QString &sol, const QJsonObject &report);
+
+    // Cached sols in ascending order
+    QStringList sols() const;
+    bool isEmpty() const { return m_index.isEmpty(); }
+
+    // Validators from the last successful fetch, for conditional requests
+    QByteArray etag() const { return m_etag; }
+    qint64 fetchedAtMs() const { return m_fetchedAtMs; }
+    void setFetched(const QByteArray &etag, qint64 fetchedAtMs);
+
+    // Reports kept decoded in memory (their JSON size), and dropping them;
+    // they are read back from disk when next asked for
+    qint64 decodedBytes() const { return m_decodedBytes; }
+    void dropDecoded();
+
+private:
+    void loadIndex();
+    bool saveIndex() const;
+    QString objectPath(const QByteArray &hash) const;
+
+    QString m_directory;
+    QMap<int, QByteArray> m_index; // Sol number -> hex SHA-256 of its object
+    QHash<int, QJsonObject> m_decoded; // Objects already read back this session
+    qint64 m_decodedBytes = 0;
+    QByteArray m_etag;
+    qint64 m_fetchedAtMs = 0;
+};
+
+#endif // MARSSOLCACHE_H
@@ -0,0 +1,199 @@
+#include "memorybudget.h"
+#include <QTimer>
+#include <cstdio>
+#include "appsettings.h"
+#include "logging.h"
+
+#if defined(Q_OS_LINUX)
+#include <unistd.h>
+#elif defined(Q_OS_MACOS)
+#include <mach/mach.h>
+#elif defined(Q_OS_WIN)
+#include <windows.h>
+#include <psapi.h>
+#endif
+
+namespace {
+
+constexpr int kEnforceIntervalMs = 5000;
+
+// Sum of the pool defaults, plus headroom for one decoded background
+constexpr qint64 kDefaultTotalBudget = 96 * 1024 * 1024;
+
+// Per-element overhead of QList and QString's allocation header
+constexpr qint64 kStringOverhead = qint64(sizeof(QString)) + 16;
+
+} // namespace
+
+MemoryBudget::MemoryBudget(QObject *parent)
+    : QObject(parent)
+    , m_totalBudget(kDefaultTotalBudget)
+    , m_enforceTimer(new QTimer(this))
+{
+    m_enforceTimer->setInterval(kEnforceIntervalMs);
+    connect(m_enforceTimer, &QTimer::timeout, this, &MemoryBudget::enforce);
+    m_enforceTimer->start();
+}
+
+void MemoryBudget::loadSettings()
+{
+    AppSettings settings;
+    settings.beginGroup("memory");
+    const QStringList keys = settings.childKeys();
+    for (const QString &key : keys) {
+        const qint64 bytes = settings.value(key).toLongLong() * 1024;
+        if (bytes <= 0) continue;
+        if (key == "total") {
+            m_totalBudget = bytes;
+        } else {
+            m_configured.insert(key, bytes);
+            setBudget(key, bytes);
+        }
+    }
+}
+
+void MemoryBudget::addPool(const QString &name, QObject *owner, qint64 defaultBudgetBytes, Usage usage, Trim trim)
+{
+    Pool pool;
+    pool.name = name;
+    pool.owner = owner;
+    pool.budget = m_configured.value(name, defaultBudgetBytes);
+    pool.usage = std::move(usage);
+    pool.trim = std::move(trim);
+    m_pools.append(std::move(pool));
+
+    if (owner) {
+        connect(owner, &QObject::destroyed, this, [this, owner]() {
+            m_pools.removeIf([owner](const Pool &pool) { return pool.owner == owner; });
+        });
+    }
+}
+
+qint64 MemoryBudget::budget(const QString &name) const
+{
+    for (const Pool &pool : m_pools) {
+        if (pool.name == name) return pool.budget;
+    }
+    return m_configured.value(name, 0);
+}
+
+void MemoryBudget::setBudget(const QString &name, qint64 bytes)
+{
+    for (Pool &pool : m_pools) {
+        if (pool.name == name) pool.budget = bytes;
+    }
+}
+
+void MemoryBudget::enforce()
+{
+    qint64 total = 0;
+    for (Pool &pool : m_pools) {
+        qint64 bytes = pool.usage();
+        if (bytes > pool.budget && pool.trim) {
+            bytes = trimPool(pool, pool.budget, bytes);
+        }
+        total += bytes;
+    }
+
+    // Still over: everyone who can shrink gives up the same share
+    if (total > m_totalBudget) {
+        const double keep = double(m_totalBudget) / double(total);
+        qCDebug(lcMemory) << "Over the total budget," << total << "of" << m_totalBudget << "bytes; trimming every pool";
+        for (Pool &pool : m_pools) {
+            if (!pool.trim) continue;
+            const qint64 bytes = pool.usage();
+            trimPool(pool, qint64(bytes * keep), bytes);
+        }
+    }
+
+    emit breakdownChanged();
+}
+
+qint64 MemoryBudget::trimPool(Pool &pool, qint64 targetBytes, qint64 currentBytes)
+{
+    pool.trim(targetBytes);
+    const qint64 after = pool.usage();
+    if (after < currentBytes) {
+        pool.evictedBytes += currentBytes - after;
+        ++pool.trims;
+        qCDebug(lcMemory) << pool.name << "trimmed from" << currentBytes << "to" << after << "bytes";
+    }
+    return after;
+}
+
+QVariantMap MemoryBudget::breakdown() const
+{
+    QVariantList pools;
+    qint64 total = 0;
+    for (const Pool &pool : m_pools) {
+        const qint64 bytes = pool.usage();
+        total += bytes;
+
+        QVariantMap entry;
+        entry["name"] = pool.name;
+        entry["bytes"] = bytes;
+        entry["budget"] = pool.budget;
+        entry["evictedBytes"] = pool.evictedBytes;
+        entry["trims"] = pool.trims;
+        pools.append(entry);
+    }
+
+    QVariantMap map;
+    map["pools"] = pools;
+    map["totalBytes"] = total;
+    map["totalBudget"] = m_totalBudget;
+    map["residentBytes"] = residentBytes();
+    return map;
+}
+
+qint64 MemoryBudget::residentBytes()
+{
+#if defined(Q_OS_LINUX)
+    FILE *statm = std::fopen("/proc/self/statm", "r");
+    if (!statm) return -1;
+    long long size = 0, resident = 0;
+    const bool ok = std::fscanf(statm, "%lld %lld", &size, &resident) == 2;
+    std::fclose(statm);
+    return ok ? resident * sysconf(_SC_PAGESIZE) : -1;
+#elif defined(Q_OS_MACOS)
+    mach_task_basic_info_data_t info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count)
+        != KERN_SUCCESS) {
+        return -1;
+    }
+    return qint64(info.resident_size);
+#elif defined(Q_OS_WIN)
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return -1;
+    return qint64(counters.WorkingSetSize);
+#else
+    return -1;
+#endif
+}
+
+qint64 MemoryAccounting::bytes(const QString &string)
+{
+    return kStringOverhead + qint64(string.capacity()) * qint64(sizeof(QChar));
+}
+
+qint64 MemoryAccounting::bytes(const QStringList &list)
+{
+    qint64 total = 0;
+    for (const QString &string : list) {
+        total += bytes(string);
+    }
+    return total;
+}
+
+qsizetype MemoryAccounting::trimFront(QStringList &list, qint64 targetBytes)
+{
+    qint64 total = bytes(list);
+    qsizetype dropped = 0;
+    while (dropped < list.size() && total > targetBytes) {
+        total -= bytes(list.at(dropped));
+        ++dropped;
+    }
+    list.remove(0, dropped);
+    return dropped;
+}
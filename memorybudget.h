@@ -0,0 +1,81 @@
+#ifndef MEMORYBUDGET_H
+#define MEMORYBUDGET_H
+
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVariantMap>
+#include <functional>
+
+// Forward declarations for faster compilation
+class QTimer;
+
+// Central account of the memory held by caches, mapped files and histories.
+// Each subsystem registers a pool with a function reporting its bytes and,
+// if it can shed memory, one that evicts its least recently used entries
+// until it is at or under a target. Every few seconds enforce() trims pools
+// over their own budget; if the total is still over the overall budget,
+// every pool that can shrink gives up the same fraction.
+class MemoryBudget : public QObject
+{
+    Q_OBJECT
+    Q_PROPERTY(QVariantMap breakdown READ breakdown NOTIFY breakdownChanged)
+
+public:
+    using Usage = std::function<qint64()>;
+    using Trim = std::function<void(qint64 targetBytes)>;
+
+    explicit MemoryBudget(QObject *parent = nullptr);
+
+    // Budgets from the [memory] group of the settings, in KiB: one key per
+    // pool name, plus "total"
+    void loadSettings();
+
+    // The pool goes away with owner. Without trim it is reported but never evicted.
+    void addPool(const QString &name, QObject *owner, qint64 defaultBudgetBytes, Usage usage, Trim trim = Trim());
+
+    qint64 budget(const QString &name) const;
+    void setBudget(const QString &name, qint64 bytes);
+
+    // {totalBytes, totalBudget, residentBytes, pools: [{name, bytes, budget, evictedBytes, trims}]}
+    QVariantMap breakdown() const;
+
+    Q_INVOKABLE void enforce();
+
+    // The process's resident set size, or -1 where it can't be read
+    static qint64 residentBytes();
+
+signals:
+    void breakdownChanged();
+
+private:
+    struct Pool {
+        QString name;
+        QObject *owner = nullptr;
+        qint64 budget = 0;
+        Usage usage;
+        Trim trim;
+        qint64 evictedBytes = 0;
+        int trims = 0;
+    };
+
+    qint64 trimPool(Pool &pool, qint64 targetBytes, qint64 currentBytes);
+
+    QList<Pool> m_pools;
+    QHash<QString, qint64> m_configured; // Budgets from the settings, by pool name
+    qint64 m_totalBudget;
+    QTimer *m_enforceTimer;
+};
+
+// Byte counts for the simple containers the pools are made of
+namespace MemoryAccounting {
+qint64 bytes(const QString &string);
+qint64 bytes(const QStringList &list);
+// Drops entries from the front, the oldest in an append-only list, until
+// the list takes at most targetBytes; returns the number dropped
+qsizetype trimFront(QStringList &list, qint64 targetBytes);
+} // namespace MemoryAccounting
+
+#endif // MEMORYBUDGET_H
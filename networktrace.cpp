@@ -0,0 +1,314 @@
+#include "networktrace.h"
+#include <QDateTime>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTimer>
+#include <QUrlQuery>
+#include "logging.h"
+#include <climits>
+#include <cstring>
+#include <memory>
+
+namespace {
+
+constexpr const char *kFormat = "elegantweather-network-trace";
+constexpr int kVersion = 1;
+
+const char *const kSecretQueryItems[] = {"appid", "api_key", "client_id", "key", "token", "access_token"};
+const char *const kSecretHeaders[] = {"authorization", "proxy-authorization", "cookie", "set-cookie", "x-api-key"};
+
+QByteArray methodName(QNetworkAccessManager::Operation op, const QNetworkRequest &request)
+{
+    switch (op) {
+        case QNetworkAccessManager::HeadOperation: return "HEAD";
+        case QNetworkAccessManager::GetOperation: return "GET";
+        case QNetworkAccessManager::PutOperation: return "PUT";
+        case QNetworkAccessManager::PostOperation: return "POST";
+        case QNetworkAccessManager::DeleteOperation: return "DELETE";
+        case QNetworkAccessManager::CustomOperation:
+            return request.attribute(QNetworkRequest::CustomVerbAttribute).toByteArray();
+        default: return "UNKNOWN";
+    }
+}
+
+QString entryKey(const QByteArray &method, const QUrl &url)
+{
+    return QString::fromLatin1(method) + ' ' + NetworkTrace::withoutSecrets(url).toString(QUrl::FullyEncoded);
+}
+
+QJsonArray headersToJson(const QList<QNetworkReply::RawHeaderPair> &headers)
+{
+    QJsonArray array;
+    for (const QNetworkReply::RawHeaderPair &header : headers) {
+        array.append(QJsonArray{QString::fromLatin1(header.first), QString::fromLatin1(header.second)});
+    }
+    return array;
+}
+
+QList<QNetworkReply::RawHeaderPair> headersFromJson(const QJsonArray &array)
+{
+    QList<QNetworkReply::RawHeaderPair> headers;
+    for (const QJsonValue &value : array) {
+        const QJsonArray pair = value.toArray();
+        headers.append(QNetworkReply::RawHeaderPair(pair.at(0).toString().toLatin1(), pair.at(1).toString().toLatin1()));
+    }
+    return headers;
+}
+
+} // namespace
+
+QUrl NetworkTrace::withoutSecrets(const QUrl &url)
+{
+    QUrl stripped(url);
+    QUrlQuery query(stripped);
+    for (const char *item : kSecretQueryItems) {
+        query.removeAllQueryItems(QString::fromLatin1(item));
+    }
+    stripped.setQuery(query);
+    stripped.setUserInfo(QString());
+    return stripped;
+}
+
+bool NetworkTrace::isSecretHeader(const QByteArray &name)
+{
+    for (const char *secret : kSecretHeaders) {
+        if (name.compare(secret, Qt::CaseInsensitive) == 0) return true;
+    }
+    return false;
+}
+
+QList<NetworkTrace::Entry> NetworkTrace::load(const QString &path)
+{
+    QList<Entry> entries;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(lcNetwork) << "Can't read network trace" << path << file.errorString();
+        return entries;
+    }
+
+    const QJsonObject header = QJsonDocument::fromJson(file.readLine()).object();
+    if (header["format"].toString() != QLatin1String(kFormat) || header["version"].toInt() != kVersion) {
+        qCWarning(lcNetwork) << path << "is not a version" << kVersion << "network trace";
+        return entries;
+    }
+
+    while (!file.atEnd()) {
+        const QJsonObject line = QJsonDocument::fromJson(file.readLine()).object();
+        if (line.isEmpty()) continue; // Blank, or cut short when the recording process died
+
+        Entry entry;
+        entry.method = line["method"].toString().toLatin1();
+        entry.url = QUrl(line["url"].toString());
+        entry.requestHeaders = headersFromJson(line["requestHeaders"].toArray());
+        entry.status = line["status"].toInt();
+        entry.reason = line["reason"].toString().toLatin1();
+        entry.headers = headersFromJson(line["headers"].toArray());
+        entry.body = QByteArray::fromBase64(line["body"].toString().toLatin1());
+        entry.error = QNetworkReply::NetworkError(line["error"].toInt());
+        entry.errorString = line["errorString"].toString();
+        entry.startMs = line["startMs"].toInteger();
+        entry.firstByteMs = line["firstByteMs"].toInteger();
+        entry.durationMs = line["durationMs"].toInteger();
+        entries.append(entry);
+    }
+    return entries;
+}
+
+RecordingNetworkAccessManager::RecordingNetworkAccessManager(const QString &path, QObject *parent)
+    : QNetworkAccessManager(parent)
+    , m_file(path)
+{
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        qCWarning(lcNetwork) << "Not recording network traffic:" << path << m_file.errorString();
+        return;
+    }
+
+    QJsonObject header;
+    header["format"] = QLatin1String(kFormat);
+    header["version"] = kVersion;
+    header["recordedAt"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+    m_file.write(QJsonDocument(header).toJson(QJsonDocument::Compact) + '\n');
+    m_file.flush();
+    m_clock.start();
+}
+
+QNetworkReply *RecordingNetworkAccessManager::createRequest(Operation op, const QNetworkRequest &request,
+                                                            QIODevice *outgoingData)
+{
+    QNetworkReply *reply = QNetworkAccessManager::createRequest(op, request, outgoingData);
+    if (!isRecording()) return reply;
+
+    auto entry = std::make_shared<NetworkTrace::Entry>();
+    entry->method = methodName(op, request);
+    entry->url = NetworkTrace::withoutSecrets(request.url());
+    const QList<QByteArray> headerNames = request.rawHeaderList();
+    for (const QByteArray &name : headerNames) {
+        if (!NetworkTrace::isSecretHeader(name)) {
+            entry->requestHeaders.append(QNetworkReply::RawHeaderPair(name, request.rawHeader(name)));
+        }
+    }
+    entry->startMs = m_clock.elapsed();
+
+    // Connected before the caller sees the reply, so these run ahead of its own slots
+    connect(reply, &QNetworkReply::metaDataChanged, this, [this, entry]() {
+        if (entry->firstByteMs == 0) entry->firstByteMs = m_clock.elapsed() - entry->startMs;
+    });
+    connect(reply, &QNetworkReply::finished, this, [this, reply, entry]() {
+        if (reply->error() == QNetworkReply::OperationCanceledError) return;
+
+        entry->durationMs = m_clock.elapsed() - entry->startMs;
+        if (entry->firstByteMs == 0) entry->firstByteMs = entry->durationMs;
+        entry->status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        entry->reason = reply->attribute(QNetworkRequest::HttpReasonPhraseAttribute).toByteArray();
+        for (const QNetworkReply::RawHeaderPair &header : reply->rawHeaderPairs()) {
+            if (!NetworkTrace::isSecretHeader(header.first)) entry->headers.append(header);
+        }
+        // Peek, so the caller still reads the whole body in its finished() slot
+        entry->body = reply->peek(reply->bytesAvailable());
+        if (reply->error() != QNetworkReply::NoError) {
+            entry->error = reply->error();
+            entry->errorString = reply->errorString();
+        }
+        write(*entry);
+    });
+    return reply;
+}
+
+void RecordingNetworkAccessManager::write(const NetworkTrace::Entry &entry)
+{
+    QJsonObject line;
+    line["method"] = QString::fromLatin1(entry.method);
+    line["url"] = entry.url.toString(QUrl::FullyEncoded);
+    line["requestHeaders"] = headersToJson(entry.requestHeaders);
+    line["status"] = entry.status;
+    line["reason"] = QString::fromLatin1(entry.reason);
+    line["headers"] = headersToJson(entry.headers);
+    line["error"] = int(entry.error);
+    line["errorString"] = entry.errorString;
+    line["startMs"] = entry.startMs;
+    line["firstByteMs"] = entry.firstByteMs;
+    line["durationMs"] = entry.durationMs;
+    line["body"] = QString::fromLatin1(entry.body.toBase64());
+
+    // One flushed line per request, so a crash loses at most the one in progress
+    m_file.write(QJsonDocument(line).toJson(QJsonDocument::Compact) + '\n');
+    m_file.flush();
+}
+
+ReplayNetworkAccessManager::ReplayNetworkAccessManager(const QList<NetworkTrace::Entry> &entries, double speed,
+                                                       QObject *parent)
+    : QNetworkAccessManager(parent)
+    , m_speed(speed)
+    , m_entryCount(int(entries.size()))
+{
+    for (const NetworkTrace::Entry &entry : entries) {
+        m_entries[entryKey(entry.method, entry.url)].append(entry);
+    }
+}
+
+QNetworkReply *ReplayNetworkAccessManager::createRequest(Operation op, const QNetworkRequest &request,
+                                                         QIODevice *outgoingData)
+{
+    Q_UNUSED(outgoingData);
+
+    const QString key = entryKey(methodName(op, request), request.url());
+    const auto recorded = m_entries.constFind(key);
+    if (recorded == m_entries.cend() || recorded->isEmpty()) {
+        ++m_unmatched;
+        qCWarning(lcNetwork) << "Replay: no recorded response for" << key;
+        return new ReplayReply(request, op, this);
+    }
+
+    int &served = m_served[key];
+    const NetworkTrace::Entry &entry = recorded->at(qMin(served, int(recorded->size()) - 1));
+    ++served;
+    return new ReplayReply(request, op, entry, m_speed, this);
+}
+
+ReplayReply::ReplayReply(const QNetworkRequest &request, QNetworkAccessManager::Operation op,
+                         const NetworkTrace::Entry &entry, double speed, QObject *parent)
+    : QNetworkReply(parent)
+    , m_entry(entry)
+{
+    setRequest(request);
+    setUrl(request.url());
+    setOperation(op);
+    open(QIODevice::ReadOnly);
+
+    const auto scaled = [speed](qint64 ms) {
+        return speed > 0 ? int(qMin<double>(ms / speed, INT_MAX)) : 0;
+    };
+    QTimer::singleShot(scaled(entry.firstByteMs), this, &ReplayReply::deliverHeaders);
+    QTimer::singleShot(scaled(entry.durationMs), this, &ReplayReply::deliverBody);
+}
+
+ReplayReply::ReplayReply(const QNetworkRequest &request, QNetworkAccessManager::Operation op, QObject *parent)
+    : QNetworkReply(parent)
+{
+    setRequest(request);
+    setUrl(request.url());
+    setOperation(op);
+    open(QIODevice::ReadOnly);
+
+    m_entry.error = ContentNotFoundError;
+    m_entry.errorString = tr("Not in the replayed trace");
+    QTimer::singleShot(0, this, &ReplayReply::deliverBody);
+}
+
+void ReplayReply::deliverHeaders()
+{
+    if (m_headersDelivered || isFinished()) return;
+    m_headersDelivered = true;
+
+    if (m_entry.status > 0) setAttribute(QNetworkRequest::HttpStatusCodeAttribute, m_entry.status);
+    if (!m_entry.reason.isEmpty()) setAttribute(QNetworkRequest::HttpReasonPhraseAttribute, m_entry.reason);
+    for (const RawHeaderPair &header : std::as_const(m_entry.headers)) {
+        setRawHeader(header.first, header.second);
+    }
+    emit metaDataChanged();
+}
+
+void ReplayReply::deliverBody()
+{
+    if (isFinished()) return;
+    deliverHeaders();
+
+    m_bodyReady = true;
+    if (m_entry.error != NoError) {
+        setError(m_entry.error, m_entry.errorString);
+        emit errorOccurred(m_entry.error);
+    }
+    setFinished(true);
+    if (!m_entry.body.isEmpty()) {
+        emit downloadProgress(m_entry.body.size(), m_entry.body.size());
+        emit readyRead();
+    }
+    emit finished();
+}
+
+void ReplayReply::abort()
+{
+    if (isFinished()) return;
+
+    setError(OperationCanceledError, tr("Operation canceled"));
+    setFinished(true);
+    emit errorOccurred(OperationCanceledError);
+    emit finished();
+}
+
+qint64 ReplayReply::bytesAvailable() const
+{
+    const qint64 body = m_bodyReady ? m_entry.body.size() - m_readPos : 0;
+    return body + QNetworkReply::bytesAvailable();
+}
+
+qint64 ReplayReply::readData(char *data, qint64 maxSize)
+{
+    const qint64 count = m_bodyReady ? qMin(maxSize, qint64(m_entry.body.size()) - m_readPos) : 0;
+    if (count <= 0) return isFinished() ? -1 : 0;
+
+    std::memcpy(data, m_entry.body.constData() + m_readPos, size_t(count));
+    m_readPos += count;
+    return count;
+}
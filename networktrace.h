@@ -0,0 +1,126 @@
+#ifndef NETWORKTRACE_H
+#define NETWORKTRACE_H
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QUrl>
+
+// Record-and-replay of HTTP traffic, so a field session can be re-run
+// offline with the same responses and (optionally scaled) timing.
+//
+// A trace is JSON lines: a header line, then one line per finished request
+// with the method, URL and request headers minus credentials, the response
+// status, headers and base64 body, and when it started, got its first byte
+// and finished (ms since recording began). Aborted attempts, such as hedges
+// that lost the race, carry no response and aren't recorded.
+namespace NetworkTrace {
+
+// Query items and headers that carry credentials never reach a trace
+QUrl withoutSecrets(const QUrl &url);
+bool isSecretHeader(const QByteArray &name);
+
+struct Entry {
+    QByteArray method;
+    QUrl url; // Secrets stripped
+    QList<QNetworkReply::RawHeaderPair> requestHeaders;
+    int status = 0;
+    QByteArray reason;
+    QList<QNetworkReply::RawHeaderPair> headers;
+    QByteArray body;
+    QNetworkReply::NetworkError error = QNetworkReply::NoError;
+    QString errorString;
+    qint64 startMs = 0;
+    qint64 firstByteMs = 0; // After startMs
+    qint64 durationMs = 0; // After startMs
+};
+
+// Empty, with a warning, if the file can't be read or isn't a trace
+QList<Entry> load(const QString &path);
+
+} // namespace NetworkTrace
+
+// Passes every request through to the network and appends each finished
+// one to a trace file
+class RecordingNetworkAccessManager : public QNetworkAccessManager
+{
+    Q_OBJECT
+
+public:
+    explicit RecordingNetworkAccessManager(const QString &path, QObject *parent = nullptr);
+
+    bool isRecording() const { return m_file.isOpen(); }
+
+protected:
+    QNetworkReply *createRequest(Operation op, const QNetworkRequest &request,
+                                 QIODevice *outgoingData = nullptr) override;
+
+private:
+    void write(const NetworkTrace::Entry &entry);
+
+    QFile m_file;
+    QElapsedTimer m_clock;
+};
+
+// Answers requests from a trace instead of the network. Requests are
+// matched on method and URL (credentials ignored); repeats of the same
+// request get the recorded responses in order, then the last one again.
+// Responses are delivered after their recorded delays divided by speed;
+// a speed of 0 delivers them on the next event loop pass.
+class ReplayNetworkAccessManager : public QNetworkAccessManager
+{
+    Q_OBJECT
+
+public:
+    ReplayNetworkAccessManager(const QList<NetworkTrace::Entry> &entries, double speed,
+                               QObject *parent = nullptr);
+
+    int entryCount() const { return m_entryCount; }
+    int unmatchedCount() const { return m_unmatched; }
+
+protected:
+    QNetworkReply *createRequest(Operation op, const QNetworkRequest &request,
+                                 QIODevice *outgoingData = nullptr) override;
+
+private:
+    QHash<QString, QList<NetworkTrace::Entry>> m_entries; // By method and URL, in recorded order
+    QHash<QString, int> m_served;
+    double m_speed;
+    int m_entryCount = 0;
+    int m_unmatched = 0;
+};
+
+// A recorded response played back on a timer
+class ReplayReply : public QNetworkReply
+{
+    Q_OBJECT
+
+public:
+    ReplayReply(const QNetworkRequest &request, QNetworkAccessManager::Operation op,
+                const NetworkTrace::Entry &entry, double speed, QObject *parent = nullptr);
+
+    // For requests missing from the trace
+    ReplayReply(const QNetworkRequest &request, QNetworkAccessManager::Operation op,
+                QObject *parent = nullptr);
+
+    void abort() override;
+    qint64 bytesAvailable() const override;
+    bool isSequential() const override { return true; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+
+private:
+    void deliverHeaders();
+    void deliverBody();
+
+    NetworkTrace::Entry m_entry;
+    qint64 m_readPos = 0;
+    bool m_headersDelivered = false;
+    bool m_bodyReady = false;
+};
+
+#endif // NETWORKTRACE_H
@@ -0,0 +1,272 @@
+#include "refreshengine.h"
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QEvent>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QTimer>
+#include <QWindow>
+#include <utility>
+
+namespace {
+
+// OpenWeatherMap refreshes its model roughly every ten minutes
+constexpr qint64 kMinIntervalMs = 10 * 60 * 1000;
+constexpr qint64 kMaxIntervalMs = 60 * 60 * 1000;
+constexpr qint64 kMaxNightIntervalMs = 90 * 60 * 1000;
+constexpr qint64 kFailureRetryMs = 2 * 60 * 1000;
+
+// Cities due within this share of their interval ride along with an earlier batch
+constexpr qint64 kMaxBatchWindowMs = 5 * 60 * 1000;
+
+constexpr qint64 kUserIdleMs = 15 * 60 * 1000;
+constexpr qint64 kSuspendedPollMs = 60 * 1000;
+
+// Weight of the newest sample in the volatility average
+constexpr double kVolatilityAlpha = 0.4;
+
+} // namespace
+
+RefreshEngine::RefreshEngine(QObject *parent)
+    : QObject(parent)
+    , m_timer(new QTimer(this))
+{
+    m_clock.start();
+    m_timer->setSingleShot(true);
+    connect(m_timer, &QTimer::timeout, this, &RefreshEngine::onTimer);
+
+    // User input resets the idle clock; coming back to the window catches up
+    // on anything that went stale while it was hidden
+    QCoreApplication::instance()->installEventFilter(this);
+    if (auto *guiApp = qobject_cast<QGuiApplication *>(QCoreApplication::instance())) {
+        connect(guiApp, &QGuiApplication::applicationStateChanged, this, [this](Qt::ApplicationState state) {
+            if (state == Qt::ApplicationActive) onTimer();
+        });
+    }
+}
+
+void RefreshEngine::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+    if (enabled) {
+        reschedule();
+    } else {
+        m_timer->stop();
+    }
+}
+
+void RefreshEngine::watch(const QString &city)
+{
+    if (!m_cities.contains(city)) {
+        m_cities.insert(city, CityState());
+    }
+}
+
+void RefreshEngine::unwatch(const QString &city)
+{
+    m_cities.remove(city);
+    reschedule();
+}
+
+void RefreshEngine::recordObservation(const QString &city, const QJsonObject &weather)
+{
+    // A late reply for a city no longer watched must not bring it back
+    auto it = m_cities.find(city);
+    if (it == m_cities.end()) return;
+    CityState &state = *it;
+    const qint64 now = m_clock.elapsed();
+
+    const QJsonObject main = weather["main"].toObject();
+    const double temperature = main["temp"].toDouble();
+    const double humidity = main["humidity"].toDouble();
+    const double windSpeed = weather["wind"].toObject()["speed"].toDouble();
+    const int conditionId = weather["weather"].toArray().at(0).toObject()["id"].toInt();
+
+    if (state.hasObservation) {
+        // 1 K, 10 % humidity, 2 m/s of wind or a new condition each count as
+        // one unit of change; normalize per hour so fetch spacing doesn't matter
+        double change = qAbs(temperature - state.temperature)
+                        + qAbs(humidity - state.humidity) / 10.0
+                        + qAbs(windSpeed - state.windSpeed) / 2.0
+                        + (conditionId != state.conditionId ? 1.0 : 0.0);
+        const double hours = qMax((now - state.lastObservationMs) / 3600000.0, 1.0 / 6.0);
+        state.volatility = (1.0 - kVolatilityAlpha) * state.volatility + kVolatilityAlpha * (change / hours);
+    }
+
+    state.temperature = temperature;
+    state.humidity = humidity;
+    state.windSpeed = windSpeed;
+    state.conditionId = conditionId;
+    state.utcOffsetSeconds = weather["timezone"].toInt();
+    state.hasObservation = true;
+    state.lastObservationMs = now;
+    state.lastFetchMs = now;
+
+    updateInterval(state);
+    reschedule();
+}
+
+void RefreshEngine::recordFailure(const QString &city)
+{
+    auto it = m_cities.find(city);
+    if (it == m_cities.end()) return;
+
+    // Come back soon rather than waiting out a full interval on stale data
+    it->lastFetchMs = m_clock.elapsed() - it->intervalMs + kFailureRetryMs;
+    reschedule();
+}
+
+void RefreshEngine::setCacheMaxAge(const QString &city, qint64 seconds)
+{
+    auto it = m_cities.find(city);
+    if (it == m_cities.end()) return;
+    it->cacheMaxAgeMs = qMax<qint64>(0, seconds) * 1000;
+}
+
+void RefreshEngine::updateInterval(CityState &state) const
+{
+    double interval = qBound(double(kMinIntervalMs),
+                             kMaxIntervalMs / (1.0 + state.volatility),
+                             double(kMaxIntervalMs));
+
+    // Overnight conditions settle; around sunrise and sunset they move fastest
+    const int hour = QDateTime::currentDateTimeUtc().addSecs(state.utcOffsetSeconds).time().hour();
+    if (hour < 6) {
+        interval *= 1.5;
+    } else if ((hour >= 6 && hour < 9) || (hour >= 17 && hour < 20)) {
+        interval *= 0.8;
+    }
+
+    interval = qBound(double(kMinIntervalMs), interval, double(kMaxNightIntervalMs));
+    state.intervalMs = qMax(qint64(interval), state.cacheMaxAgeMs);
+}
+
+double RefreshEngine::activityFactor() const
+{
+    double factor = 1.0;
+
+    if (auto *guiApp = qobject_cast<QGuiApplication *>(QCoreApplication::instance())) {
+        const Qt::ApplicationState state = guiApp->applicationState();
+        if (state == Qt::ApplicationSuspended) return 0; // Paused outright
+
+        bool anyVisible = false;
+        const QWindowList windows = QGuiApplication::topLevelWindows();
+        for (const QWindow *window : windows) {
+            const QWindow::Visibility visibility = window->visibility();
+            if (visibility != QWindow::Hidden && visibility != QWindow::Minimized) {
+                anyVisible = true;
+                break;
+            }
+        }
+
+        if (!anyVisible || state == Qt::ApplicationHidden) {
+            factor *= 4.0;
+        } else if (state == Qt::ApplicationInactive) {
+            factor *= 1.5;
+        }
+    }
+
+    if (m_clock.elapsed() - m_lastInputMs > kUserIdleMs) {
+        factor *= 3.0;
+    }
+    return qMin(factor, 8.0);
+}
+
+void RefreshEngine::onTimer()
+{
+    if (!m_enabled) return;
+
+    const double factor = activityFactor();
+    if (factor <= 0) {
+        m_timer->start(int(kSuspendedPollMs));
+        return;
+    }
+
+    const qint64 now = m_clock.elapsed();
+    QStringList due;
+    for (auto it = m_cities.cbegin(); it != m_cities.cend(); ++it) {
+        const CityState &state = it.value();
+        if (state.lastFetchMs < 0) continue;
+
+        const qint64 effective = qint64(state.intervalMs * factor);
+        const qint64 window = qMin(kMaxBatchWindowMs, effective / 5);
+        if (state.lastFetchMs + effective - window <= now) {
+            due.append(it.key());
+        }
+    }
+
+    // Mark the batch in flight; each observation restarts its city's interval
+    for (const QString &city : due) {
+        m_cities[city].lastFetchMs = now;
+    }
+    if (!due.isEmpty()) {
+        emit refreshDue(due);
+    }
+    reschedule();
+}
+
+void RefreshEngine::reschedule()
+{
+    if (!m_enabled) return;
+
+    const double factor = activityFactor();
+    const qint64 now = m_clock.elapsed();
+    qint64 earliest = -1;
+    for (const CityState &state : std::as_const(m_cities)) {
+        if (state.lastFetchMs < 0) continue;
+        const qint64 dueAt = state.lastFetchMs + qint64(state.intervalMs * qMax(factor, 1.0));
+        if (earliest < 0 || dueAt < earliest) earliest = dueAt;
+    }
+
+    if (earliest < 0) {
+        m_timer->stop();
+    } else {
+        m_timer->start(int(qMax<qint64>(1000, earliest - now)));
+    }
+}
+
+bool RefreshEngine::eventFilter(QObject *watched, QEvent *event)
+{
+    switch (event->type()) {
+        case QEvent::KeyPress:
+        case QEvent::MouseButtonPress:
+        case QEvent::MouseMove:
+        case QEvent::Wheel:
+        case QEvent::TouchBegin: {
+            const qint64 now = m_clock.elapsed();
+            const bool wasIdle = now - m_lastInputMs > kUserIdleMs;
+            m_lastInputMs = now;
+            // Intervals were stretched while idle; catch up right away
+            if (wasIdle && m_enabled) QTimer::singleShot(0, this, &RefreshEngine::onTimer);
+            break;
+        }
+        default:
+            break;
+    }
+    return QObject::eventFilter(watched, event);
+}
+
+QVariantMap RefreshEngine::toVariantMap() const
+{
+    const qint64 now = m_clock.elapsed();
+    const double factor = activityFactor();
+
+    QVariantMap cities;
+    for (auto it = m_cities.cbegin(); it != m_cities.cend(); ++it) {
+        const CityState &state = it.value();
+        QVariantMap city;
+        city["intervalSeconds"] = state.intervalMs / 1000;
+        city["volatility"] = state.volatility;
+        city["cacheMaxAgeSeconds"] = state.cacheMaxAgeMs / 1000;
+        city["dueInSeconds"] = state.lastFetchMs < 0
+            ? -1 : (state.lastFetchMs + qint64(state.intervalMs * qMax(factor, 1.0)) - now) / 1000;
+        cities[it.key()] = city;
+    }
+
+    QVariantMap map;
+    map["enabled"] = m_enabled;
+    map["activityFactor"] = factor;
+    map["cities"] = cities;
+    return map;
+}
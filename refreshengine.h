@@ -0,0 +1,73 @@
+#ifndef REFRESHENGINE_H
+#define REFRESHENGINE_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QStringList>
+#include <QVariantMap>
+
+// Forward declarations for faster compilation
+class QJsonObject;
+class QTimer;
+
+// Decides when each watched city is worth another API call. A city's
+// interval shrinks while its observations are changing quickly and grows
+// while they're steady, never undercuts the server's Cache-Control max-age,
+// and is stretched overnight. Intervals are stretched further while the
+// window is hidden or minimized or the user is idle. Cities that come due
+// within a short window of each other are released as one batch.
+class RefreshEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit RefreshEngine(QObject *parent = nullptr);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled; }
+
+    void watch(const QString &city);
+    void unwatch(const QString &city);
+
+    // Feed every successful fetch in; this starts the city's next interval
+    void recordObservation(const QString &city, const QJsonObject &weather);
+    void recordFailure(const QString &city);
+    void setCacheMaxAge(const QString &city, qint64 seconds);
+
+    QVariantMap toVariantMap() const;
+
+signals:
+    void refreshDue(const QStringList &cities);
+
+protected:
+    bool eventFilter(QObject *watched, QEvent *event) override;
+
+private:
+    struct CityState {
+        qint64 lastFetchMs = -1; // -1 until the first observation arrives
+        qint64 lastObservationMs = 0;
+        qint64 intervalMs = 0;
+        qint64 cacheMaxAgeMs = 0;
+        double volatility = 0; // EWMA of normalized change per hour
+        double temperature = 0;
+        double humidity = 0;
+        double windSpeed = 0;
+        int conditionId = 0;
+        int utcOffsetSeconds = 0;
+        bool hasObservation = false;
+    };
+
+    void updateInterval(CityState &state) const;
+    double activityFactor() const;
+    void onTimer();
+    void reschedule();
+
+    QHash<QString, CityState> m_cities;
+    QTimer *m_timer;
+    QElapsedTimer m_clock;
+    qint64 m_lastInputMs = 0;
+    bool m_enabled = true;
+};
+
+#endif // REFRESHENGINE_H
@@ -0,0 +1,315 @@
+#include "requestmetrics.h"
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkReply>
+#include <QFile>
+#include <QtAlgorithms>
+#include <memory>
+
+namespace {
+
+const char *const kPhaseNames[RequestMetrics::PhaseCount] = {
+    "lookup", "connect", "server", "download", "parse", "binding", "total", "request"
+};
+
+const char *const kOutcomeNames[RequestMetrics::OutcomeCount] = {
+    "success", "networkError", "httpError", "aborted"
+};
+
+double toMs(qint64 micros)
+{
+    return micros / 1000.0;
+}
+
+} // namespace
+
+void LatencyHistogram::record(qint64 micros)
+{
+    if (micros < 0) micros = 0;
+
+    // Bucket index is the bit width of the sample
+    int bucket = micros == 0 ? 0 : 64 - qCountLeadingZeroBits(quint64(micros));
+    if (bucket >= BucketCount) bucket = BucketCount - 1;
+    ++m_buckets[bucket];
+
+    if (m_count == 0 || micros < m_min) m_min = micros;
+    if (micros > m_max) m_max = micros;
+    m_sum += micros;
+    ++m_count;
+}
+
+void LatencyHistogram::reset()
+{
+    *this = LatencyHistogram();
+}
+
+void LatencyHistogram::halve()
+{
+    qint64 count = 0;
+    for (quint32 &bucket : m_buckets) {
+        bucket /= 2;
+        count += bucket;
+    }
+    m_sum = m_count ? m_sum / m_count * count : 0;
+    m_count = count;
+}
+
+qint64 LatencyHistogram::percentile(double p) const
+{
+    if (m_count == 0) return 0;
+
+    const double target = qBound(0.0, p, 1.0) * m_count;
+    double seen = 0;
+    for (int bucket = 0; bucket < BucketCount; ++bucket) {
+        const quint32 inBucket = m_buckets[bucket];
+        if (inBucket == 0) continue;
+        if (seen + inBucket >= target) {
+            // Interpolate linearly inside the bucket's [lower, upper) range
+            const double lower = bucket == 0 ? 0.0 : double(qint64(1) << (bucket - 1));
+            const double upper = double(qint64(1) << bucket);
+            const double fraction = (target - seen) / inBucket;
+            const qint64 estimate = qint64(lower + (upper - lower) * fraction);
+            return qBound(m_min, estimate, m_max);
+        }
+        seen += inBucket;
+    }
+    return m_max;
+}
+
+QVariantMap LatencyHistogram::toVariantMap() const
+{
+    QVariantMap map;
+    map["count"] = m_count;
+    map["minMs"] = toMs(m_min);
+    map["meanMs"] = m_count ? toMs(m_sum / m_count) : 0.0;
+    map["p50Ms"] = toMs(percentile(0.50));
+    map["p95Ms"] = toMs(percentile(0.95));
+    map["p99Ms"] = toMs(percentile(0.99));
+    map["maxMs"] = toMs(m_max);
+    return map;
+}
+
+RequestMetrics::RequestMetrics(QObject *parent)
+    : QObject(parent)
+{
+    m_clock.start();
+}
+
+void RequestMetrics::setEnabled(bool enabled)
+{
+    m_enabled = enabled;
+}
+
+void RequestMetrics::setTracing(bool tracing)
+{
+    m_tracing = tracing;
+    if (!tracing) {
+        m_traceEvents = QJsonArray();
+        m_traceHead = 0;
+    }
+}
+
+const char *RequestMetrics::endpointName(Endpoint endpoint)
+{
+    switch (endpoint) {
+        case Weather: return "weather";
+        case Uv: return "uvi";
+        case Forecast: return "forecast";
+        case Geocoding: return "geo";
+        case Unsplash: return "unsplash";
+        case Mars: return "nasa";
+        default: return "unknown";
+    }
+}
+
+void RequestMetrics::track(QNetworkReply *reply, Endpoint endpoint)
+{
+    if (!m_enabled || !reply) return;
+
+    // Timestamps of the signals QNetworkReply emits along the way; -1 means
+    // the phase never happened (e.g. no connect on a reused connection)
+    struct Marks {
+        qint64 start = 0;
+        qint64 connecting = -1;
+        qint64 encrypted = -1;
+        qint64 sent = -1;
+        qint64 headers = -1;
+    };
+    auto marks = std::make_shared<Marks>();
+    marks->start = nowNs();
+
+    connect(reply, &QNetworkReply::socketStartedConnecting, this, [this, marks]() {
+        marks->connecting = nowNs();
+    });
+    connect(reply, &QNetworkReply::encrypted, this, [this, marks]() {
+        marks->encrypted = nowNs();
+    });
+    connect(reply, &QNetworkReply::requestSent, this, [this, marks]() {
+        marks->sent = nowNs();
+    });
+    connect(reply, &QNetworkReply::metaDataChanged, this, [this, marks]() {
+        if (marks->headers < 0) marks->headers = nowNs();
+    });
+    connect(reply, &QNetworkReply::finished, this, [this, reply, endpoint, marks]() {
+        const qint64 end = nowNs();
+        EndpointStats &stats = m_stats[endpoint];
+
+        if (marks->connecting >= 0) {
+            recordPhase(endpoint, Lookup, marks->start, marks->connecting - marks->start);
+            const qint64 connected = marks->encrypted >= 0 ? marks->encrypted : marks->sent;
+            if (connected >= 0)
+                recordPhase(endpoint, Connect, marks->connecting, connected - marks->connecting);
+        }
+        const qint64 sent = marks->sent >= 0 ? marks->sent : marks->start;
+        if (marks->headers >= 0) {
+            recordPhase(endpoint, Server, sent, marks->headers - sent);
+            recordPhase(endpoint, Download, marks->headers, end - marks->headers);
+        }
+        recordPhase(endpoint, Total, marks->start, end - marks->start);
+
+        // Nothing has read the body yet, so what's buffered is what arrived
+        stats.bytesReceived += reply->bytesAvailable();
+
+        // A reply that neither connected nor handshook was multiplexed or
+        // kept alive on a connection opened earlier (possibly by a prewarm)
+        ConnectionStats &connection = m_connections[reply->url().host()];
+        ++connection.requests;
+        if (marks->connecting >= 0) ++connection.newConnections;
+        if (marks->encrypted >= 0) ++connection.tlsHandshakes;
+        if (marks->connecting < 0 && marks->encrypted < 0) ++connection.reused;
+        if (reply->attribute(QNetworkRequest::Http2WasUsedAttribute).toBool()) ++connection.http2;
+
+        const int httpStatus = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        if (reply->error() == QNetworkReply::NoError) {
+            ++stats.outcomes[Success];
+        } else if (reply->error() == QNetworkReply::OperationCanceledError) {
+            ++stats.outcomes[Aborted];
+        } else if (httpStatus >= 400) {
+            ++stats.outcomes[HttpError];
+        } else {
+            ++stats.outcomes[NetworkError];
+        }
+
+        emit updated();
+    });
+}
+
+void RequestMetrics::trackRequest(QNetworkReply *reply, Endpoint endpoint)
+{
+    if (!m_enabled || !reply) return;
+
+    const qint64 start = nowNs();
+    connect(reply, &QNetworkReply::finished, this, [this, endpoint, start]() {
+        recordPhase(endpoint, Request, start, nowNs() - start);
+    });
+}
+
+void RequestMetrics::recordPhase(Endpoint endpoint, Phase phase, qint64 startNs, qint64 durationNs)
+{
+    m_stats[endpoint].phases[phase].record(durationNs / 1000);
+    if (m_tracing)
+        appendTraceEvent(endpoint, kPhaseNames[phase], startNs, durationNs);
+}
+
+void RequestMetrics::recordPrewarm(const QString &host)
+{
+    if (!m_enabled) return;
+    ++m_connections[host].prewarms;
+}
+
+const LatencyHistogram &RequestMetrics::histogram(Endpoint endpoint, Phase phase) const
+{
+    return m_stats[endpoint].phases[phase];
+}
+
+void RequestMetrics::appendTraceEvent(Endpoint endpoint, const char *name, qint64 startNs, qint64 durationNs)
+{
+    // Chrome/Perfetto "complete" event; one thread lane per endpoint
+    QJsonObject event;
+    event["name"] = QString::fromLatin1(name);
+    event["cat"] = QString::fromLatin1(endpointName(endpoint));
+    event["ph"] = QStringLiteral("X");
+    event["ts"] = startNs / 1000.0;
+    event["dur"] = durationNs / 1000.0;
+    event["pid"] = QCoreApplication::applicationPid();
+    event["tid"] = int(endpoint);
+
+    if (m_traceEvents.size() < MaxTraceEvents) {
+        m_traceEvents.append(event);
+    } else {
+        m_traceEvents.replace(m_traceHead, event);
+        m_traceHead = (m_traceHead + 1) % MaxTraceEvents;
+    }
+}
+
+QVariantMap RequestMetrics::snapshot() const
+{
+    QVariantMap endpoints;
+    for (int e = 0; e < EndpointCount; ++e) {
+        const EndpointStats &stats = m_stats[e];
+
+        QVariantMap phases;
+        for (int p = 0; p < PhaseCount; ++p)
+            phases[kPhaseNames[p]] = stats.phases[p].toVariantMap();
+
+        QVariantMap outcomes;
+        for (int o = 0; o < OutcomeCount; ++o)
+            outcomes[kOutcomeNames[o]] = stats.outcomes[o];
+
+        QVariantMap endpoint;
+        endpoint["requests"] = stats.phases[Total].count();
+        endpoint["bytesReceived"] = stats.bytesReceived;
+        endpoint["outcomes"] = outcomes;
+        endpoint["phases"] = phases;
+        endpoints[endpointName(Endpoint(e))] = endpoint;
+    }
+
+    QVariantMap connections;
+    for (auto it = m_connections.cbegin(); it != m_connections.cend(); ++it) {
+        const ConnectionStats &stats = it.value();
+        QVariantMap host;
+        host["requests"] = stats.requests;
+        host["prewarms"] = stats.prewarms;
+        host["newConnections"] = stats.newConnections;
+        host["tlsHandshakes"] = stats.tlsHandshakes;
+        host["reused"] = stats.reused;
+        host["http2"] = stats.http2;
+        host["reuseRatio"] = stats.requests ? double(stats.reused) / stats.requests : 0.0;
+        connections[it.key()] = host;
+    }
+
+    QVariantMap map;
+    map["enabled"] = m_enabled;
+    map["tracing"] = m_tracing;
+    map["endpoints"] = endpoints;
+    map["connections"] = connections;
+    return map;
+}
+
+bool RequestMetrics::writeTrace(const QString &path) const
+{
+    // Unroll the ring so events come out oldest first
+    QJsonArray ordered;
+    for (int i = 0; i < m_traceEvents.size(); ++i)
+        ordered.append(m_traceEvents.at((m_traceHead + i) % m_traceEvents.size()));
+
+    QJsonObject root;
+    root["traceEvents"] = ordered;
+    root["displayTimeUnit"] = QStringLiteral("ms");
+
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+    file.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    return true;
+}
+
+void RequestMetrics::reset()
+{
+    m_stats = {};
+    m_connections.clear();
+    m_traceEvents = QJsonArray();
+    m_traceHead = 0;
+    emit updated();
+}
@@ -0,0 +1,138 @@
+#ifndef REQUESTMETRICS_H
+#define REQUESTMETRICS_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QVariantMap>
+#include <QHash>
+#include <array>
+
+// Forward declarations for faster compilation
+class QNetworkReply;
+
+// Fixed-size latency histogram. Bucket n holds samples in [2^(n-1), 2^n)
+// microseconds, so 32 buckets cover everything from 1us to ~35 minutes
+// without ever allocating.
+class LatencyHistogram
+{
+public:
+    static constexpr int BucketCount = 32;
+
+    void record(qint64 micros);
+    void reset();
+    void halve(); // Ages old samples so percentiles track recent behaviour
+
+    qint64 count() const { return m_count; }
+    qint64 percentile(double p) const; // Interpolated, in microseconds
+    QVariantMap toVariantMap() const;
+
+private:
+    std::array<quint32, BucketCount> m_buckets{};
+    qint64 m_count = 0;
+    qint64 m_sum = 0;
+    qint64 m_min = 0;
+    qint64 m_max = 0;
+};
+
+class RequestMetrics : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Endpoint { Weather, Uv, Forecast, Geocoding, Unsplash, Mars, EndpointCount };
+    Q_ENUM(Endpoint)
+
+    // Lookup covers queueing and DNS up to the socket connecting; Connect is
+    // TCP plus TLS; Server is request sent to first response headers. Total
+    // is one network attempt, Request the logical request including any
+    // hedged or retried attempts.
+    enum Phase { Lookup, Connect, Server, Download, Parse, Binding, Total, Request, PhaseCount };
+    Q_ENUM(Phase)
+
+    enum Outcome { Success, NetworkError, HttpError, Aborted, OutcomeCount };
+    Q_ENUM(Outcome)
+
+    explicit RequestMetrics(QObject *parent = nullptr);
+
+    bool isEnabled() const { return m_enabled; }
+    void setEnabled(bool enabled);
+    bool isTracing() const { return m_tracing; }
+    void setTracing(bool tracing);
+
+    // Attach phase timers to a reply. Must be called before any other slot is
+    // connected to finished() so the body size is still readable.
+    void track(QNetworkReply *reply, Endpoint endpoint);
+    void trackRequest(QNetworkReply *reply, Endpoint endpoint);
+    void recordPhase(Endpoint endpoint, Phase phase, qint64 startNs, qint64 durationNs);
+    void recordPrewarm(const QString &host);
+
+    qint64 nowNs() const { return m_clock.nsecsElapsed(); }
+    const LatencyHistogram &histogram(Endpoint endpoint, Phase phase) const;
+
+    QVariantMap snapshot() const;
+    bool writeTrace(const QString &path) const;
+    void reset();
+
+    static const char *endpointName(Endpoint endpoint);
+
+    // Times a parse or binding phase; costs one branch when metrics are off
+    class Scope
+    {
+    public:
+        Scope(RequestMetrics *metrics, Endpoint endpoint, Phase phase)
+            : m_metrics(metrics->isEnabled() ? metrics : nullptr)
+            , m_endpoint(endpoint)
+            , m_phase(phase)
+            , m_start(m_metrics ? m_metrics->nowNs() : 0) {}
+        ~Scope() { finish(); }
+        void finish()
+        {
+            if (m_metrics)
+                m_metrics->recordPhase(m_endpoint, m_phase, m_start, m_metrics->nowNs() - m_start);
+            m_metrics = nullptr;
+        }
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        RequestMetrics *m_metrics;
+        Endpoint m_endpoint;
+        Phase m_phase;
+        qint64 m_start;
+    };
+
+signals:
+    void updated();
+
+private:
+    struct EndpointStats {
+        std::array<LatencyHistogram, PhaseCount> phases;
+        std::array<qint64, OutcomeCount> outcomes{};
+        qint64 bytesReceived = 0;
+    };
+
+    // Per-host view of how often replies rode an existing connection
+    struct ConnectionStats {
+        qint64 requests = 0;
+        qint64 prewarms = 0;
+        qint64 newConnections = 0;
+        qint64 tlsHandshakes = 0;
+        qint64 reused = 0;
+        qint64 http2 = 0;
+    };
+
+    void appendTraceEvent(Endpoint endpoint, const char *name, qint64 startNs, qint64 durationNs);
+
+    static constexpr int MaxTraceEvents = 4096;
+
+    QElapsedTimer m_clock;
+    std::array<EndpointStats, EndpointCount> m_stats;
+    QHash<QString, ConnectionStats> m_connections;
+    QJsonArray m_traceEvents; // Ring buffer, m_traceHead is the oldest slot
+    int m_traceHead = 0;
+    bool m_enabled = false;
+    bool m_tracing = false;
+};
+
+#endif // REQUESTMETRICS_H
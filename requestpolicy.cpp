@@ -0,0 +1,110 @@
+#include "requestpolicy.h"
+#include <QRandomGenerator>
+
+namespace {
+
+// Until enough successes are seen the budgets fall back to fixed defaults
+constexpr qint64 kMinSamples = 20;
+constexpr qint64 kMaxSamples = 512;
+
+constexpr int kDefaultTimeoutMs = 15000;
+constexpr int kMinTimeoutMs = 2000;
+constexpr int kMaxTimeoutMs = 30000;
+constexpr int kMinHedgeDelayMs = 100;
+
+constexpr int kBackoffBaseMs = 400;
+constexpr int kBackoffCapMs = 8000;
+
+constexpr int kBreakerFailureThreshold = 5;
+constexpr qint64 kBreakerCooldownMs = 30000;
+
+// Longest a probe can take: every attempt timing out, plus backoff
+constexpr qint64 kProbeDeadlineMs = 3 * kMaxTimeoutMs + 2 * kBackoffCapMs;
+
+const char *breakerName(RequestPolicy::BreakerState state)
+{
+    switch (state) {
+        case RequestPolicy::BreakerState::Open: return "open";
+        case RequestPolicy::BreakerState::HalfOpen: return "halfOpen";
+        default: return "closed";
+    }
+}
+
+} // namespace
+
+RequestPolicy::RequestPolicy(bool hedgingAllowed)
+    : m_hedgingAllowed(hedgingAllowed)
+{
+}
+
+int RequestPolicy::timeoutMs() const
+{
+    if (m_latency.count() < kMinSamples) return kDefaultTimeoutMs;
+
+    // Generous multiple of p99 so only genuinely stuck attempts are cut
+    const qint64 p99Ms = m_latency.percentile(0.99) / 1000;
+    return int(qBound<qint64>(kMinTimeoutMs, p99Ms * 4, kMaxTimeoutMs));
+}
+
+int RequestPolicy::hedgeDelayMs() const
+{
+    if (!m_hedgingAllowed || m_latency.count() < kMinSamples) return -1;
+
+    // Hedging at p95 costs at most ~5% extra requests
+    const qint64 p95Ms = m_latency.percentile(0.95) / 1000;
+    return int(qMax<qint64>(kMinHedgeDelayMs, p95Ms));
+}
+
+int RequestPolicy::retryDelayMs(int retry) const
+{
+    const int ceiling = qMin(kBackoffCapMs, kBackoffBaseMs << qMin(retry, 8));
+    return int(QRandomGenerator::global()->bounded(ceiling)) + 1;
+}
+
+bool RequestPolicy::allowRequest()
+{
+    if (m_state == BreakerState::Open && m_openedAt.hasExpired(kBreakerCooldownMs)) {
+        m_state = BreakerState::HalfOpen;
+        m_probeSentAt.invalidate();
+    }
+    if (m_state != BreakerState::HalfOpen) return m_state == BreakerState::Closed;
+
+    // Let a single probe through; its outcome closes or re-opens the breaker.
+    // A probe that never reports (aborted, superseded) is replaced eventually.
+    if (m_probeSentAt.isValid() && !m_probeSentAt.hasExpired(kProbeDeadlineMs)) return false;
+    m_probeSentAt.start();
+    return true;
+}
+
+void RequestPolicy::recordSuccess(qint64 latencyMs)
+{
+    m_latency.record(latencyMs * 1000);
+    if (m_latency.count() >= kMaxSamples) m_latency.halve();
+
+    m_consecutiveFailures = 0;
+    m_state = BreakerState::Closed;
+}
+
+void RequestPolicy::recordFailure()
+{
+    ++m_consecutiveFailures;
+    if (m_state == BreakerState::HalfOpen || m_consecutiveFailures >= kBreakerFailureThreshold) {
+        m_state = BreakerState::Open;
+        m_openedAt.start();
+    }
+}
+
+QVariantMap RequestPolicy::toVariantMap() const
+{
+    QVariantMap map;
+    map["timeoutMs"] = timeoutMs();
+    map["hedgeDelayMs"] = hedgeDelayMs();
+    map["breaker"] = breakerName(m_state);
+    map["consecutiveFailures"] = m_consecutiveFailures;
+    map["hedges"] = m_hedges;
+    map["retries"] = m_retries;
+    map["timeouts"] = m_timeouts;
+    map["servedFromCache"] = m_servedFromCache;
+    map["latency"] = m_latency.toVariantMap();
+    return map;
+}
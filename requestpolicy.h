@@ -0,0 +1,51 @@
+#ifndef REQUESTPOLICY_H
+#define REQUESTPOLICY_H
+
+#include <QElapsedTimer>
+#include <QVariantMap>
+#include "requestmetrics.h"
+
+// Per-endpoint timeout, hedging, retry and circuit-breaker decisions. Budgets
+// adapt to the latency of recent successful attempts, which is recorded here
+// regardless of whether RequestMetrics is enabled.
+class RequestPolicy
+{
+public:
+    enum class BreakerState { Closed, Open, HalfOpen };
+
+    explicit RequestPolicy(bool hedgingAllowed = true);
+
+    // Budgets derived from the latency distribution; hedgeDelayMs() is -1
+    // until enough samples exist or when hedging is not allowed
+    int timeoutMs() const;
+    int hedgeDelayMs() const;
+    int retryDelayMs(int retry) const; // Full-jitter exponential backoff
+    int maxRetries() const { return 2; }
+
+    // Circuit breaker; false means serve cached data instead of calling upstream
+    bool allowRequest();
+    BreakerState breakerState() const { return m_state; }
+
+    void recordSuccess(qint64 latencyMs);
+    void recordFailure();
+    void noteHedge() { ++m_hedges; }
+    void noteRetry() { ++m_retries; }
+    void noteTimeout() { ++m_timeouts; }
+    void noteServedFromCache() { ++m_servedFromCache; }
+
+    QVariantMap toVariantMap() const;
+
+private:
+    LatencyHistogram m_latency;
+    bool m_hedgingAllowed;
+    BreakerState m_state = BreakerState::Closed;
+    int m_consecutiveFailures = 0;
+    QElapsedTimer m_openedAt;
+    QElapsedTimer m_probeSentAt; // Invalid while no half-open probe is out
+    qint64 m_hedges = 0;
+    qint64 m_retries = 0;
+    qint64 m_timeouts = 0;
+    qint64 m_servedFromCache = 0;
+};
+
+#endif // REQUESTPOLICY_H
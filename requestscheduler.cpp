@@ -0,0 +1,176 @@
+#include "requestscheduler.h"
+#include <QTimer>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Share of the bucket each class must leave untouched for the classes above it
+constexpr double kReserve[RequestScheduler::PriorityCount] = {0.0, 0.1, 0.25, 0.25};
+
+// Queued work older than this is no longer worth a call; 0 means never shed
+constexpr qint64 kMaxQueueAgeMs[RequestScheduler::PriorityCount] = {0, 0, 5 * 60 * 1000, 2000};
+constexpr size_t kMaxSheddableQueue = 32;
+
+// Pause after a 429 that didn't say how long to wait
+constexpr int kDefaultRetryAfterSeconds = 10;
+
+const char *const kPriorityNames[RequestScheduler::PriorityCount] = {
+    "foreground", "watchlist", "prefetch", "autocomplete"
+};
+
+} // namespace
+
+RequestScheduler::RequestScheduler(QObject *parent)
+    : QObject(parent)
+    , m_pumpTimer(new QTimer(this))
+{
+    m_clock.start();
+    m_pumpTimer->setSingleShot(true);
+    connect(m_pumpTimer, &QTimer::timeout, this, &RequestScheduler::pump);
+
+    setCallsPerMinute(60); // OpenWeatherMap free plan
+    m_tokens = m_capacity;
+}
+
+void RequestScheduler::setCallsPerMinute(int callsPerMinute)
+{
+    refill();
+    m_callsPerMinute = qMax(1, callsPerMinute);
+    m_capacity = qMax(1.0, m_callsPerMinute / 6.0);
+    m_tokensPerMs = m_callsPerMinute / 60000.0;
+    m_tokens = qMin(m_tokens, m_capacity);
+}
+
+void RequestScheduler::submit(Priority priority, const QString &key,
+                              std::function<void()> start, std::function<void()> dropped)
+{
+    std::deque<Job> &queue = m_queues[priority];
+    std::function<void()> superseded;
+
+    auto existing = std::find_if(queue.begin(), queue.end(), [&key](const Job &job) { return job.key == key; });
+    if (existing != queue.end()) {
+        // Keep the queue position but run the newer work
+        superseded = std::move(existing->dropped);
+        existing->start = std::move(start);
+        existing->dropped = std::move(dropped);
+        ++m_superseded;
+    } else {
+        queue.push_back({key, std::move(start), std::move(dropped), m_clock.elapsed()});
+        if (kMaxQueueAgeMs[priority] > 0 && queue.size() > kMaxSheddableQueue) {
+            superseded = std::move(queue.front().dropped);
+            queue.pop_front();
+            ++m_shed;
+        }
+    }
+
+    if (superseded) superseded();
+    pump();
+}
+
+bool RequestScheduler::tryAcquire(Priority priority)
+{
+    // Don't let follow-up attempts jump ahead of queued work of equal or higher priority
+    for (int p = 0; p <= priority; ++p) {
+        if (!m_queues[p].empty()) return false;
+    }
+    return take(priority);
+}
+
+void RequestScheduler::onRateLimited(int retryAfterSeconds)
+{
+    ++m_rateLimited;
+    const int seconds = retryAfterSeconds > 0 ? retryAfterSeconds : kDefaultRetryAfterSeconds;
+    const qint64 pauseMs = qint64(seconds) * 1000;
+    m_tokens = 0;
+    m_pausedUntilMs = m_clock.elapsed() + pauseMs;
+    m_lastRefillMs = m_pausedUntilMs;
+    m_pumpTimer->start(int(pauseMs));
+}
+
+void RequestScheduler::refill()
+{
+    const qint64 now = m_clock.elapsed();
+    if (now <= m_lastRefillMs) return; // Also covers a 429 pause in progress
+
+    m_tokens = qMin(m_capacity, m_tokens + (now - m_lastRefillMs) * m_tokensPerMs);
+    m_lastRefillMs = now;
+}
+
+bool RequestScheduler::take(Priority priority)
+{
+    refill();
+    const double needed = qMin(m_capacity, 1.0 + kReserve[priority] * m_capacity);
+    if (m_tokens < needed) return false;
+
+    m_tokens -= 1.0;
+    return true;
+}
+
+void RequestScheduler::pump()
+{
+    shedStale();
+
+    // Strict priority: once a class can't get a token, lower classes (which
+    // need a larger reserve) can't either
+    for (int p = 0; p < PriorityCount; ++p) {
+        std::deque<Job> &queue = m_queues[p];
+        while (!queue.empty()) {
+            if (!take(Priority(p))) {
+                // Wake up when enough tokens have accrued for this class
+                const double needed = qMin(m_capacity, 1.0 + kReserve[p] * m_capacity);
+                const qint64 pauseLeft = qMax<qint64>(0, m_pausedUntilMs - m_clock.elapsed());
+                const qint64 waitMs = pauseLeft + qint64(std::ceil((needed - m_tokens) / m_tokensPerMs));
+                m_pumpTimer->start(int(qMax<qint64>(1, waitMs)));
+                return;
+            }
+
+            // start() may submit more work, so detach the job first
+            Job job = std::move(queue.front());
+            queue.pop_front();
+            ++m_dispatched;
+            job.start();
+        }
+    }
+}
+
+void RequestScheduler::shedStale()
+{
+    const qint64 now = m_clock.elapsed();
+    QVector<std::function<void()>> dropped;
+
+    for (int p = 0; p < PriorityCount; ++p) {
+        if (kMaxQueueAgeMs[p] == 0) continue;
+        std::deque<Job> &queue = m_queues[p];
+        while (!queue.empty() && now - queue.front().enqueuedMs > kMaxQueueAgeMs[p]) {
+            dropped.append(std::move(queue.front().dropped));
+            queue.pop_front();
+            ++m_shed;
+        }
+    }
+
+    for (const std::function<void()> &callback : dropped) {
+        if (callback) callback();
+    }
+}
+
+QVariantMap RequestScheduler::toVariantMap() const
+{
+    QVariantMap queued;
+    for (int p = 0; p < PriorityCount; ++p) {
+        queued[kPriorityNames[p]] = qint64(m_queues[p].size());
+    }
+
+    QVariantMap map;
+    map["callsPerMinute"] = m_callsPerMinute;
+    map["capacity"] = m_capacity;
+    map["tokens"] = m_tokens;
+    map["paused"] = m_pausedUntilMs > m_clock.elapsed();
+    map["queued"] = queued;
+    map["dispatched"] = m_dispatched;
+    map["shed"] = m_shed;
+    map["superseded"] = m_superseded;
+    map["rateLimited"] = m_rateLimited;
+    return map;
+}
@@ -0,0 +1,76 @@
+#ifndef REQUESTSCHEDULER_H
+#define REQUESTSCHEDULER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QString>
+#include <QVariantMap>
+#include <array>
+#include <deque>
+#include <functional>
+
+// Forward declarations for faster compilation
+class QTimer;
+
+// Central gate for calls that count against the OpenWeatherMap per-minute
+// quota. Work is queued by priority class and released by a token bucket
+// sized from the API plan. Lower classes only run while a reserve of tokens
+// is left for foreground work, stale low-priority work is shed rather than
+// sent late, and a queued job is replaced by a newer one with the same key.
+class RequestScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Priority { Foreground, Watchlist, Prefetch, Autocomplete, PriorityCount };
+    Q_ENUM(Priority)
+
+    explicit RequestScheduler(QObject *parent = nullptr);
+
+    // Bucket holds ten seconds' worth of calls, refilled continuously
+    void setCallsPerMinute(int callsPerMinute);
+    int callsPerMinute() const { return m_callsPerMinute; }
+
+    // start() runs once a token is granted; dropped() runs instead if the job
+    // is shed or superseded by a newer job with the same key
+    void submit(Priority priority, const QString &key,
+                std::function<void()> start, std::function<void()> dropped);
+
+    // Non-queuing token grab for follow-up attempts (retries, hedges)
+    bool tryAcquire(Priority priority);
+
+    // Upstream answered 429: stop issuing until the quota window has passed
+    // (retryAfterSeconds <= 0 means the server didn't say)
+    void onRateLimited(int retryAfterSeconds);
+
+    QVariantMap toVariantMap() const;
+
+private:
+    struct Job {
+        QString key;
+        std::function<void()> start;
+        std::function<void()> dropped;
+        qint64 enqueuedMs;
+    };
+
+    void refill();
+    bool take(Priority priority);
+    void pump();
+    void shedStale();
+
+    std::array<std::deque<Job>, PriorityCount> m_queues;
+    QTimer *m_pumpTimer;
+    QElapsedTimer m_clock;
+    int m_callsPerMinute = 0;
+    double m_capacity = 0;
+    double m_tokens = 0;
+    double m_tokensPerMs = 0;
+    qint64 m_lastRefillMs = 0;
+    qint64 m_pausedUntilMs = 0;
+    qint64 m_dispatched = 0;
+    qint64 m_shed = 0;
+    qint64 m_superseded = 0;
+    qint64 m_rateLimited = 0;
+};
+
+#endif // REQUESTSCHEDULER_H
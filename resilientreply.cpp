@@ -0,0 +1,258 @@
+#include "resilientreply.h"
+#include "requestpolicy.h"
+#include <QNetworkAccessManager>
+#include <QPointer>
+#include <QTimer>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+// 429 and 5xx are worth another try, as are transport failures that tend to
+// be transient; anything else (e.g. a 404 for an unknown city) is an answer
+bool isRetryable(QNetworkReply *attempt)
+{
+    if (attempt->error() == QNetworkReply::NoError) return false;
+
+    const int status = attempt->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (status > 0) return status == 429 || status >= 500;
+
+    switch (attempt->error()) {
+        case QNetworkReply::ConnectionRefusedError:
+        case QNetworkReply::RemoteHostClosedError:
+        case QNetworkReply::HostNotFoundError:
+        case QNetworkReply::TimeoutError:
+        case QNetworkReply::TemporaryNetworkFailureError:
+        case QNetworkReply::NetworkSessionFailedError:
+        case QNetworkReply::ProxyTimeoutError:
+        case QNetworkReply::UnknownNetworkError:
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+ResilientReply::ResilientReply(const QNetworkRequest &request, QObject *parent)
+    : QNetworkReply(parent)
+{
+    setRequest(request);
+    setUrl(request.url());
+    setOperation(QNetworkAccessManager::GetOperation);
+    open(QIODevice::ReadOnly);
+    m_clock.start();
+}
+
+ResilientReply::ResilientReply(const QNetworkRequest &request, AttemptFactory startAttempt,
+                               RequestPolicy *policy, QObject *parent)
+    : ResilientReply(request, parent)
+{
+    m_startAttempt = std::move(startAttempt);
+    m_policy = policy;
+
+    m_hedgeTimer = new QTimer(this);
+    m_hedgeTimer->setSingleShot(true);
+    connect(m_hedgeTimer, &QTimer::timeout, this, &ResilientReply::onHedgeTimeout);
+}
+
+ResilientReply::~ResilientReply()
+{
+    cancelAttempts();
+}
+
+ResilientReply *ResilientReply::completed(const QNetworkRequest &request, const QByteArray &body,
+                                          NetworkError error, const QString &errorString,
+                                          QObject *parent)
+{
+    auto *reply = new ResilientReply(request, parent);
+    reply->m_body = body;
+    if (error == NoError) {
+        reply->setAttribute(QNetworkRequest::HttpStatusCodeAttribute, 200);
+        reply->setAttribute(QNetworkRequest::SourceIsFromCacheAttribute, true);
+    } else {
+        reply->setError(error, errorString);
+    }
+    QTimer::singleShot(0, reply, [reply]() { reply->complete(); });
+    return reply;
+}
+
+void ResilientReply::abort()
+{
+    if (m_done) return;
+    setError(OperationCanceledError, tr("Operation canceled"));
+    complete();
+}
+
+qint64 ResilientReply::bytesAvailable() const
+{
+    return m_body.size() - m_readPos + QNetworkReply::bytesAvailable();
+}
+
+qint64 ResilientReply::readData(char *data, qint64 maxSize)
+{
+    const qint64 count = qMin(maxSize, qint64(m_body.size()) - m_readPos);
+    if (count <= 0) return m_done ? -1 : 0;
+
+    std::memcpy(data, m_body.constData() + m_readPos, size_t(count));
+    m_readPos += count;
+    return count;
+}
+
+void ResilientReply::start()
+{
+    // Network replies never finish synchronously, so a caller that connects
+    // to finished() right after start() won't miss it
+    startRound();
+}
+
+void ResilientReply::serveFromCache(const QByteArray &body)
+{
+    if (m_done) return;
+    finishWithBody(body, true);
+}
+
+void ResilientReply::startRound()
+{
+    if (m_done) return;
+
+    m_hedgedThisRound = false;
+    launchAttempt();
+
+    const int hedgeDelay = m_policy->hedgeDelayMs();
+    if (hedgeDelay >= 0) {
+        m_hedgeTimer->start(hedgeDelay);
+    }
+}
+
+void ResilientReply::retryRound()
+{
+    if (m_done) return;
+
+    if (m_attemptGate && !m_attemptGate()) {
+        QTimer::singleShot(m_policy->retryDelayMs(m_retries), this, &ResilientReply::retryRound);
+        return;
+    }
+    startRound();
+}
+
+void ResilientReply::launchAttempt()
+{
+    QNetworkReply *attempt = m_startAttempt();
+    m_inFlight.append(attempt);
+    m_attemptStart.insert(attempt, m_clock.elapsed());
+    connect(attempt, &QNetworkReply::finished, this, [this, attempt]() { onAttemptFinished(attempt); });
+
+    // Cut off a stuck attempt at the adaptive budget; the abort lands in
+    // onAttemptFinished like any other failure
+    QPointer<QNetworkReply> guard(attempt);
+    QTimer::singleShot(m_policy->timeoutMs(), this, [this, guard]() {
+        if (!guard || !m_inFlight.contains(guard.data())) return;
+        m_timedOut.append(guard.data());
+        m_policy->noteTimeout();
+        guard->abort();
+    });
+}
+
+void ResilientReply::onAttemptFinished(QNetworkReply *attempt)
+{
+    m_inFlight.removeOne(attempt);
+    const bool timedOut = m_timedOut.removeOne(attempt);
+    const qint64 latencyMs = m_clock.elapsed() - m_attemptStart.take(attempt);
+    attempt->deleteLater();
+
+    // Losers of a hedge race are aborted after we're done; nothing to do
+    if (m_done) return;
+
+    if (!timedOut && !isRetryable(attempt)) {
+        m_policy->recordSuccess(latencyMs);
+        finishFrom(attempt);
+        return;
+    }
+
+    // The hedged twin may still come through
+    if (!m_inFlight.isEmpty()) return;
+
+    m_policy->recordFailure();
+    m_hedgeTimer->stop();
+
+    if (m_retries < m_policy->maxRetries()) {
+        m_policy->noteRetry();
+        QTimer::singleShot(m_policy->retryDelayMs(m_retries++), this, &ResilientReply::retryRound);
+        return;
+    }
+
+    if (!m_fallbackBody.isEmpty()) {
+        m_policy->noteServedFromCache();
+        finishWithBody(m_fallbackBody, true);
+    } else if (timedOut) {
+        setError(TimeoutError, tr("Request timed out after %1 attempts").arg(m_retries + 1));
+        complete();
+    } else {
+        finishFrom(attempt);
+    }
+}
+
+void ResilientReply::onHedgeTimeout()
+{
+    if (m_done || m_hedgedThisRound || m_inFlight.size() != 1) return;
+    if (m_attemptGate && !m_attemptGate()) return;
+
+    m_hedgedThisRound = true;
+    m_policy->noteHedge();
+    launchAttempt();
+}
+
+void ResilientReply::finishFrom(QNetworkReply *attempt)
+{
+    m_body = attempt->readAll();
+
+    const QNetworkRequest::Attribute copied[] = {
+        QNetworkRequest::HttpStatusCodeAttribute,
+        QNetworkRequest::HttpReasonPhraseAttribute,
+        QNetworkRequest::Http2WasUsedAttribute,
+    };
+    for (QNetworkRequest::Attribute code : copied) {
+        setAttribute(code, attempt->attribute(code));
+    }
+    for (const RawHeaderPair &header : attempt->rawHeaderPairs()) {
+        setRawHeader(header.first, header.second);
+    }
+    if (attempt->error() != NoError) {
+        setError(attempt->error(), attempt->errorString());
+    }
+    complete();
+}
+
+void ResilientReply::finishWithBody(const QByteArray &body, bool fromCache)
+{
+    m_body = body;
+    setAttribute(QNetworkRequest::HttpStatusCodeAttribute, 200);
+    setAttribute(QNetworkRequest::SourceIsFromCacheAttribute, fromCache);
+    complete();
+}
+
+void ResilientReply::complete()
+{
+    m_done = true;
+    if (m_hedgeTimer) m_hedgeTimer->stop();
+    cancelAttempts();
+
+    setFinished(true);
+    if (!m_body.isEmpty()) {
+        emit readyRead();
+    }
+    emit finished();
+}
+
+void ResilientReply::cancelAttempts()
+{
+    const QList<QNetworkReply *> attempts = std::exchange(m_inFlight, {});
+    for (QNetworkReply *attempt : attempts) {
+        disconnect(attempt, nullptr, this, nullptr);
+        attempt->abort();
+        attempt->deleteLater();
+    }
+    m_attemptStart.clear();
+    m_timedOut.clear();
+}
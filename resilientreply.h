@@ -0,0 +1,91 @@
+#ifndef RESILIENTREPLY_H
+#define RESILIENTREPLY_H
+
+#include <QNetworkReply>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <functional>
+
+// Forward declarations for faster compilation
+class QTimer;
+class RequestPolicy;
+
+// Buffered QNetworkReply that stands in for one logical GET. Underneath it
+// runs as many network attempts as the RequestPolicy allows: each attempt is
+// cut off at the adaptive timeout, a hedged twin is started once the primary
+// outlives the p95 budget (the loser is aborted), and failed rounds are
+// retried with jittered backoff. Callers see a single finished() either way.
+// Nothing goes out until start(), so the first attempt can wait for a
+// RequestScheduler token; follow-up attempts ask the attempt gate instead.
+class ResilientReply : public QNetworkReply
+{
+    Q_OBJECT
+
+public:
+    using AttemptFactory = std::function<QNetworkReply *()>;
+
+    ResilientReply(const QNetworkRequest &request, AttemptFactory startAttempt,
+                   RequestPolicy *policy, QObject *parent = nullptr);
+    ~ResilientReply();
+
+    // A reply that finishes on the next event loop pass without any network
+    // traffic, used for cached bodies and fail-fast errors
+    static ResilientReply *completed(const QNetworkRequest &request, const QByteArray &body,
+                                     NetworkError error = NoError,
+                                     const QString &errorString = QString(),
+                                     QObject *parent = nullptr);
+
+    void start();
+
+    // Finishes with a body obtained elsewhere (e.g. another process fetched
+    // it) instead of starting or waiting for attempts
+    void serveFromCache(const QByteArray &body);
+
+    // Body to serve (flagged as from cache) if every attempt fails
+    void setFallbackBody(const QByteArray &body) { m_fallbackBody = body; }
+
+    // Consulted before hedges and retries; returning false skips the hedge
+    // and pushes the retry back by another backoff interval
+    void setAttemptGate(std::function<bool()> gate) { m_attemptGate = std::move(gate); }
+
+    const QByteArray &body() const { return m_body; }
+    bool isFromCache() const { return attribute(QNetworkRequest::SourceIsFromCacheAttribute).toBool(); }
+
+    void abort() override;
+    qint64 bytesAvailable() const override;
+    bool isSequential() const override { return true; }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+
+private:
+    explicit ResilientReply(const QNetworkRequest &request, QObject *parent);
+
+    void startRound();
+    void retryRound();
+    void launchAttempt();
+    void onAttemptFinished(QNetworkReply *attempt);
+    void onHedgeTimeout();
+    void finishFrom(QNetworkReply *attempt);
+    void finishWithBody(const QByteArray &body, bool fromCache);
+    void complete();
+    void cancelAttempts();
+
+    AttemptFactory m_startAttempt;
+    std::function<bool()> m_attemptGate;
+    RequestPolicy *m_policy = nullptr;
+    QTimer *m_hedgeTimer = nullptr;
+    QElapsedTimer m_clock;
+    QList<QNetworkReply *> m_inFlight;
+    QHash<QNetworkReply *, qint64> m_attemptStart; // ms on m_clock
+    QList<QNetworkReply *> m_timedOut;
+    QByteArray m_body;
+    QByteArray m_fallbackBody;
+    qint64 m_readPos = 0;
+    int m_retries = 0;
+    bool m_hedgedThisRound = false;
+    bool m_done = false;
+};
+
+#endif // RESILIENTREPLY_H
@@ -0,0 +1,299 @@
+#include "sharedcache.h"
+#include <QDateTime>
+#include <QThread>
+#include "logging.h"
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+
+namespace {
+
+constexpr quint32 kMagic = 0x31435745; // "EWC1"; bump when the layout changes
+
+// 128 sets of two 32 KB slots: 8 MB of address space, touched only as used
+constexpr quint32 kSetCount = 128;
+constexpr quint32 kWays = 2;
+constexpr quint32 kSlotCount = kSetCount * kWays;
+constexpr quint32 kSlotBytes = 32 * 1024;
+constexpr quint32 kLeaseCount = 1024;
+
+// A slot whose write has been in progress this long belongs to a dead process
+constexpr qint64 kStaleWriteMs = 1000;
+
+// Readers give up (a miss) rather than spin behind a busy writer
+constexpr int kReadAttempts = 8;
+
+// A lease word packs a 24-bit key tag over a 40-bit deadline (ms since the
+// segment's epoch, about 34 years), so taking a lease is a single CAS
+constexpr int kLeaseTagShift = 40;
+constexpr quint64 kLeaseDeadlineMask = (quint64(1) << kLeaseTagShift) - 1;
+
+static_assert(std::atomic<quint64>::is_always_lock_free, "shared memory needs address-free atomics");
+static_assert(std::atomic<quint32>::is_always_lock_free, "shared memory needs address-free atomics");
+
+quint64 fnv1a64(QByteArrayView data)
+{
+    quint64 hash = 0xCBF29CE484222325ull;
+    for (char c : data) {
+        hash ^= quint8(c);
+        hash *= 0x100000001B3ull;
+    }
+    return hash;
+}
+
+quint64 leaseTag(quint64 hash)
+{
+    return (hash >> kLeaseTagShift) | 1; // Never zero, so a zero word is always free
+}
+
+qint64 nowMs()
+{
+    return QDateTime::currentMSecsSinceEpoch(); // Wall clock: the only one processes share
+}
+
+struct SegmentHeader {
+    std::atomic<quint32> magic;
+    quint32 reserved;
+    std::atomic<qint64> epochMs; // Lease deadlines count from here
+    std::atomic<quint64> leases[kLeaseCount]; // Tag and deadline; 0 when free
+};
+
+struct CacheSlot {
+    std::atomic<quint32> sequence; // Seqlock; odd while a write is in progress
+    std::atomic<quint32> keyLength; // 0 for an empty slot
+    std::atomic<quint32> bodyLength;
+    quint32 reserved;
+    std::atomic<quint64> keyHash;
+    std::atomic<qint64> storedAtMs;
+    std::atomic<qint64> writeStartedMs;
+    char data[kSlotBytes - 40]; // Key, then body
+};
+static_assert(sizeof(CacheSlot) == kSlotBytes, "slots are laid out back to back");
+
+constexpr qsizetype kSlotsOffset = (sizeof(SegmentHeader) + 63) / 64 * 64;
+constexpr qsizetype kSlotDataBytes = sizeof(CacheSlot::data);
+constexpr qsizetype kSegmentBytes = kSlotsOffset + qsizetype(kSlotCount) * qsizetype(sizeof(CacheSlot));
+
+SegmentHeader *segmentHeader(uchar *base)
+{
+    return reinterpret_cast<SegmentHeader *>(base);
+}
+
+CacheSlot *slotAt(uchar *base, quint32 index)
+{
+    return reinterpret_cast<CacheSlot *>(base + kSlotsOffset + qsizetype(index) * qsizetype(sizeof(CacheSlot)));
+}
+
+qint64 leaseClock(const SegmentHeader *header)
+{
+    return qMax<qint64>(0, nowMs() - header->epochMs.load(std::memory_order_relaxed));
+}
+
+} // namespace
+
+SharedCache::SharedCache(const QString &name)
+{
+    attach(name);
+}
+
+SharedCache::~SharedCache() = default;
+
+bool SharedCache::attach(const QString &name)
+{
+    if (m_base) return true;
+    if (name.isEmpty()) return false;
+
+    // A fresh segment is zero-filled, which is already a valid empty cache
+    m_memory.setNativeKey(QSharedMemory::platformSafeKey(name));
+    const bool ready = m_memory.create(kSegmentBytes)
+                       || (m_memory.error() == QSharedMemory::AlreadyExists && m_memory.attach());
+    if (!ready || m_memory.size() < kSegmentBytes) {
+        qCWarning(lcCache) << "Shared cache unavailable:" << m_memory.errorString();
+        m_memory.detach();
+        return false;
+    }
+
+    uchar *base = static_cast<uchar *>(m_memory.data());
+    SegmentHeader *header = segmentHeader(base);
+    quint32 magic = 0;
+    if (!header->magic.compare_exchange_strong(magic, kMagic) && magic != kMagic) {
+        // Left over by a build with a different layout
+        qCWarning(lcCache) << "Shared cache" << name << "has an incompatible layout; not using it";
+        m_memory.detach();
+        return false;
+    }
+    qint64 epoch = 0;
+    header->epochMs.compare_exchange_strong(epoch, nowMs());
+
+    m_base = base;
+    return true;
+}
+
+int SharedCache::setOf(QByteArrayView key)
+{
+    return int(fnv1a64(key) % kSetCount);
+}
+
+int SharedCache::setCount()
+{
+    return int(kSetCount);
+}
+
+int SharedCache::waysPerSet()
+{
+    return int(kWays);
+}
+
+bool SharedCache::lookup(QByteArrayView key, qint64 maxAgeMs, QByteArray *body)
+{
+    if (!m_base || key.isEmpty() || key.size() > kSlotDataBytes) {
+        ++m_misses;
+        return false;
+    }
+
+    const quint64 hash = fnv1a64(key);
+    const quint32 set = quint32(hash % kSetCount);
+    const qint64 now = nowMs();
+    for (quint32 way = 0; way < kWays; ++way) {
+        CacheSlot *slot = slotAt(m_base, set * kWays + way);
+        if (slot->keyHash.load(std::memory_order_relaxed) != hash) continue;
+
+        for (int attempt = 0; attempt < kReadAttempts; ++attempt) {
+            const quint32 before = slot->sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                QThread::yieldCurrentThread();
+                continue;
+            }
+
+            // Lengths may be torn by a racing writer; bound them before copying
+            const quint32 keyLength = slot->keyLength.load(std::memory_order_relaxed);
+            const quint32 bodyLength = slot->bodyLength.load(std::memory_order_relaxed);
+            const bool matches = slot->keyHash.load(std::memory_order_relaxed) == hash
+                                 && keyLength == quint32(key.size())
+                                 && bodyLength <= kSlotDataBytes - keyLength
+                                 && std::memcmp(slot->data, key.data(), keyLength) == 0;
+            const bool fresh = matches && now - slot->storedAtMs.load(std::memory_order_relaxed) <= maxAgeMs;
+            QByteArray copy;
+            if (fresh) copy = QByteArray(slot->data + keyLength, qsizetype(bodyLength));
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot->sequence.load(std::memory_order_relaxed) != before) continue; // Torn; read again
+            if (!fresh) break;
+
+            *body = std::move(copy);
+            ++m_hits;
+            return true;
+        }
+    }
+    ++m_misses;
+    return false;
+}
+
+bool SharedCache::insert(QByteArrayView key, QByteArrayView body)
+{
+    if (!m_base || key.isEmpty() || key.size() + body.size() > kSlotDataBytes) return false;
+
+    const quint64 hash = fnv1a64(key);
+    const quint32 set = quint32(hash % kSetCount);
+
+    // The key's own slot if it has one, otherwise the older way (empty ones are oldest)
+    CacheSlot *target = nullptr;
+    for (quint32 way = 0; way < kWays && !target; ++way) {
+        CacheSlot *slot = slotAt(m_base, set * kWays + way);
+        if (slot->keyHash.load(std::memory_order_relaxed) == hash) target = slot;
+    }
+    if (!target) {
+        target = slotAt(m_base, set * kWays);
+        for (quint32 way = 1; way < kWays; ++way) {
+            CacheSlot *slot = slotAt(m_base, set * kWays + way);
+            if (slot->storedAtMs.load(std::memory_order_relaxed) < target->storedAtMs.load(std::memory_order_relaxed)) {
+                target = slot;
+            }
+        }
+    }
+
+    const qint64 now = nowMs();
+    quint32 sequence = target->sequence.load(std::memory_order_relaxed);
+    if (sequence & 1) {
+        // Another process is writing; step in only if it died doing so
+        if (now - target->writeStartedMs.load(std::memory_order_relaxed) < kStaleWriteMs) return false;
+        if (!target->sequence.compare_exchange_strong(sequence, sequence + 2, std::memory_order_acquire)) return false;
+        sequence += 2;
+    } else {
+        if (!target->sequence.compare_exchange_strong(sequence, sequence + 1, std::memory_order_acquire)) return false;
+        sequence += 1;
+    }
+    target->writeStartedMs.store(now, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    target->keyHash.store(hash, std::memory_order_relaxed);
+    target->keyLength.store(quint32(key.size()), std::memory_order_relaxed);
+    target->bodyLength.store(quint32(body.size()), std::memory_order_relaxed);
+    target->storedAtMs.store(now, std::memory_order_relaxed);
+    std::memcpy(target->data, key.data(), size_t(key.size()));
+    std::memcpy(target->data + key.size(), body.data(), size_t(body.size()));
+
+    target->sequence.store(sequence + 1, std::memory_order_release);
+    ++m_inserts;
+    return true;
+}
+
+bool SharedCache::tryAcquireLease(QByteArrayView key, qint64 durationMs)
+{
+    if (!m_base) return true;
+
+    const quint64 hash = fnv1a64(key);
+    const quint64 tag = leaseTag(hash);
+    std::atomic<quint64> &lease = segmentHeader(m_base)->leases[hash % kLeaseCount];
+    const qint64 now = leaseClock(segmentHeader(m_base));
+
+    quint64 current = lease.load(std::memory_order_acquire);
+    for (;;) {
+        const bool held = current != 0 && qint64(current & kLeaseDeadlineMask) > now;
+        if (held) {
+            if ((current >> kLeaseTagShift) != tag) return true; // Another key; fetch without deduping
+            ++m_leasesBusy;
+            return false;
+        }
+
+        const quint64 taken = (tag << kLeaseTagShift) | (quint64(now + durationMs) & kLeaseDeadlineMask);
+        if (lease.compare_exchange_weak(current, taken, std::memory_order_acq_rel)) {
+            ++m_leasesTaken;
+            return true;
+        }
+    }
+}
+
+bool SharedCache::isLeased(QByteArrayView key) const
+{
+    if (!m_base) return false;
+
+    const quint64 hash = fnv1a64(key);
+    const quint64 current = segmentHeader(m_base)->leases[hash % kLeaseCount].load(std::memory_order_acquire);
+    return (current >> kLeaseTagShift) == leaseTag(hash)
+           && qint64(current & kLeaseDeadlineMask) > leaseClock(segmentHeader(m_base));
+}
+
+void SharedCache::releaseLease(QByteArrayView key)
+{
+    if (!m_base) return;
+
+    const quint64 hash = fnv1a64(key);
+    std::atomic<quint64> &lease = segmentHeader(m_base)->leases[hash % kLeaseCount];
+    quint64 current = lease.load(std::memory_order_relaxed);
+    if ((current >> kLeaseTagShift) == leaseTag(hash)) {
+        lease.compare_exchange_strong(current, 0, std::memory_order_release);
+    }
+}
+
+QVariantMap SharedCache::toVariantMap() const
+{
+    QVariantMap map;
+    map["attached"] = isAttached();
+    map["hits"] = m_hits;
+    map["misses"] = m_misses;
+    map["inserts"] = m_inserts;
+    map["fetchesElected"] = m_leasesTaken; // This process fetched on behalf of all
+    map["fetchesDeferred"] = m_leasesBusy; // Waited for another process instead
+    return map;
+}
@@ -0,0 +1,68 @@
+#ifndef SHAREDCACHE_H
+#define SHAREDCACHE_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QSharedMemory>
+#include <QString>
+#include <QVariantMap>
+
+// Response cache shared by every ElegantWeather process on the machine,
+// so N instances showing the same city cost one upstream fetch, not N.
+// The segment is a fixed array of two-way set-associative slots; an
+// all-zero segment is a valid empty cache, so whichever process creates
+// it needs no setup step. Each slot is guarded by a seqlock: readers never
+// block and simply retry if a writer raced them, and a writer that died
+// mid-update is taken over once its write is stale.
+//
+// Leases elect one fetcher per key: the first process to miss takes the
+// lease and fetches, the others poll the cache until the body appears or
+// the lease runs out (e.g. because the fetcher crashed).
+class SharedCache
+{
+public:
+    // Attaches to (or creates) the segment called name. With an empty name,
+    // or if that fails, the cache stays detached and every call is a cheap miss.
+    explicit SharedCache(const QString &name = QString());
+    ~SharedCache();
+
+    SharedCache(const SharedCache &) = delete;
+    SharedCache &operator=(const SharedCache &) = delete;
+
+    // For a cache constructed detached; does nothing once attached
+    bool attach(const QString &name);
+    bool isAttached() const { return m_base != nullptr; }
+
+    // Bodies stored within the last maxAgeMs; false on miss
+    bool lookup(QByteArrayView key, qint64 maxAgeMs, QByteArray *body);
+
+    // False if the body is too big for a slot or another process is
+    // writing the same slot right now; both are fine to ignore
+    bool insert(QByteArrayView key, QByteArrayView body);
+
+    // True if this process should fetch key. Also true, without holding
+    // anything, when an unrelated key holds the lease entry it hashes to.
+    bool tryAcquireLease(QByteArrayView key, qint64 durationMs);
+    bool isLeased(QByteArrayView key) const;
+    void releaseLease(QByteArrayView key);
+
+    // This process's hits, misses, inserts and lease outcomes
+    QVariantMap toVariantMap() const;
+
+    // Keys in the same set share its waysPerSet() slots; a key is only
+    // evicted by another key of its set, e.g. when sizing a test
+    static int setOf(QByteArrayView key);
+    static int setCount();
+    static int waysPerSet();
+
+private:
+    QSharedMemory m_memory;
+    uchar *m_base = nullptr; // Start of the attached segment
+    qint64 m_hits = 0;
+    qint64 m_misses = 0;
+    qint64 m_inserts = 0;
+    qint64 m_leasesTaken = 0;
+    qint64 m_leasesBusy = 0;
+};
+
+#endif // SHAREDCACHE_H
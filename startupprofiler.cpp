@@ -0,0 +1,49 @@
+#include "startupprofiler.h"
+#include <QElapsedTimer>
+#include <QVector>
+#include <cstdio>
+
+namespace {
+
+struct Phase {
+    const char *name;
+    qint64 endNs; // Since start()
+};
+
+bool g_enabled = false;
+QElapsedTimer g_clock;
+QVector<Phase> g_phases;
+
+} // namespace
+
+void StartupProfiler::start(bool enabled)
+{
+    g_enabled = enabled;
+    if (!enabled) return;
+    g_phases.reserve(16);
+    g_clock.start();
+}
+
+bool StartupProfiler::isEnabled()
+{
+    return g_enabled;
+}
+
+void StartupProfiler::mark(const char *name)
+{
+    if (!g_enabled) return;
+    g_phases.append({name, g_clock.nsecsElapsed()});
+}
+
+void StartupProfiler::report()
+{
+    if (!g_enabled) return;
+
+    std::printf("%-24s %12s %12s\n", "phase", "ms", "since start");
+    qint64 previousNs = 0;
+    for (const Phase &phase : std::as_const(g_phases)) {
+        std::printf("%-24s %12.3f %12.3f\n", phase.name, (phase.endNs - previousNs) / 1e6, phase.endNs / 1e6);
+        previousNs = phase.endNs;
+    }
+    std::fflush(stdout);
+}
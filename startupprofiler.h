@@ -0,0 +1,21 @@
+#ifndef STARTUPPROFILER_H
+#define STARTUPPROFILER_H
+
+// Wall-clock profile of a cold launch, phase by phase, for
+// `ElegantWeather --startup-profile`. Marks are a single branch while
+// profiling is off, so they stay in place in normal runs.
+namespace StartupProfiler {
+
+// Starts the clock; call first thing in main()
+void start(bool enabled);
+bool isEnabled();
+
+// Ends the phase called name, which began at the previous mark
+void mark(const char *name);
+
+// Prints each phase's duration and the time since start() to stdout
+void report();
+
+} // namespace StartupProfiler
+
+#endif // STARTUPPROFILER_H
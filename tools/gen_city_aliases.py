@@ -0,0 +1,212 @@
+#!/usr/bin/env python3
+"""
+Generates the compile-time city alias table from a tab-separated data file.
+
+Each data line is `alias<TAB>API name`; blank lines and lines starting with
+'#' are skipped. Aliases are normalized exactly as CityAliases::lookup()
+normalizes its input (see normalize() below), then placed in a minimal
+perfect hash built with hash-and-displace: keys are grouped into buckets by
+one FNV-1a hash, and each bucket gets the first seed that sends all of its
+keys to free slots under a second FNV-1a hash.
+
+    python3 tools/gen_city_aliases.py data/city_aliases.tsv city_aliases_table.h
+
+qmake runs this as an extra compiler; see ElegantWeather.pro.
+"""
+
+import argparse
+import sys
+import unicodedata
+
+FNV_OFFSET = 0x811C9DC5
+FNV_PRIME = 0x01000193
+FOLD_LIMIT = 0x250  # Basic Latin through Latin Extended-B
+
+# Letters that don't decompose to an ASCII base under NFKD
+FOLD_OVERRIDES = {
+    "ß": "ss", "ẞ": "ss", "æ": "ae", "Æ": "ae", "œ": "oe", "Œ": "oe",
+    "ø": "o", "Ø": "o", "ł": "l", "Ł": "l", "đ": "d", "Đ": "d",
+    "ð": "d", "Ð": "d", "þ": "th", "Þ": "th", "ı": "i", "ħ": "h", "Ħ": "h",
+    "ŧ": "t", "Ŧ": "t", "ŀ": "l", "Ŀ": "l",
+}
+
+
+def fold(cp: int) -> str:
+    """Normalized spelling of one code point below FOLD_LIMIT"""
+    ch = chr(cp)
+    if ch in FOLD_OVERRIDES:
+        return FOLD_OVERRIDES[ch]
+    if ch.isspace():
+        return " "
+    if unicodedata.category(ch).startswith("C"):
+        return ""
+    base = "".join(c for c in unicodedata.normalize("NFKD", ch) if not unicodedata.combining(c))
+    base = base.lower()
+    if base and all(ord(c) < 0x80 for c in base):
+        return base
+    lowered = ch.lower()
+    return lowered if len(lowered) == 1 else ch
+
+
+FOLD_TABLE = [fold(cp) for cp in range(FOLD_LIMIT)]
+
+
+def normalize(name: str) -> bytes:
+    """Must match normalizedKey() in cityaliases.cpp"""
+    out = []
+    pending_space = False
+    for ch in name:
+        cp = ord(ch)
+        if cp < FOLD_LIMIT:
+            piece = FOLD_TABLE[cp]
+        else:
+            lowered = ch.lower()
+            piece = " " if ch.isspace() else (lowered if len(lowered) == 1 else ch)
+        for c in piece:
+            if c == " ":
+                pending_space = bool(out)
+            elif c == ".":
+                continue
+            elif c == ",":
+                out.append(",")
+                pending_space = True
+            else:
+                if pending_space:
+                    out.append(" ")
+                    pending_space = False
+                out.append(c)
+    return "".join(out).encode("utf-8")
+
+
+def fnv1a(data: bytes, seed: int) -> int:
+    h = (FNV_OFFSET ^ seed) & 0xFFFFFFFF
+    for b in data:
+        h ^= b
+        h = (h * FNV_PRIME) & 0xFFFFFFFF
+    return h
+
+
+def read_aliases(path: str) -> dict:
+    aliases = {}
+    with open(path, encoding="utf-8") as f:
+        for number, line in enumerate(f, 1):
+            line = line.rstrip("\n")
+            if not line.strip() or line.lstrip().startswith("#"):
+                continue
+            fields = line.split("\t")
+            if len(fields) != 2 or not fields[0].strip() or not fields[1].strip():
+                sys.exit(f"{path}:{number}: expected 'alias<TAB>API name'")
+            key = normalize(fields[0])
+            value = fields[1].strip().encode("utf-8")
+            if key in aliases and aliases[key] != value:
+                sys.exit(f"{path}:{number}: '{fields[0]}' already maps to '{aliases[key].decode()}'")
+            aliases[key] = value
+    return aliases
+
+
+def build_table(keys: list, seed: int):
+    slot_count = max(1, len(keys))
+    bucket_count = max(1, (len(keys) + 3) // 4)
+
+    buckets = [[] for _ in range(bucket_count)]
+    for key in keys:
+        buckets[fnv1a(key, seed) % bucket_count].append(key)
+
+    slots = [None] * slot_count
+    displacements = [0] * bucket_count
+    # Biggest buckets first, while most slots are still free
+    for index in sorted(range(bucket_count), key=lambda i: -len(buckets[i])):
+        bucket = buckets[index]
+        if not bucket:
+            continue
+        for displacement in range(1, 1 << 24):
+            chosen = [fnv1a(key, displacement) % slot_count for key in bucket]
+            if len(set(chosen)) == len(chosen) and all(slots[s] is None for s in chosen):
+                for key, s in zip(bucket, chosen):
+                    slots[s] = key
+                displacements[index] = displacement
+                break
+        else:
+            return None
+    return slots, displacements
+
+
+def c_string(text: str) -> str:
+    # One literal per byte so a hex escape can't swallow the next character
+    if all(0x20 <= ord(c) < 0x7F and c not in '"\\' for c in text):
+        return f'"{text}"'
+    return " ".join(f'"\\x{b:02x}"' for b in text.encode("utf-8")) or '""'
+
+
+def emit(path: str, source: str, aliases: dict, seed: int, slots: list, displacements: list):
+    blob = bytearray()
+    entries = []
+    for key in slots:
+        if key is None:
+            entries.append((0, 0, 0, 0))
+            continue
+        key_offset = len(blob)
+        blob += key
+        value_offset = len(blob)
+        blob += aliases[key]
+        entries.append((key_offset, len(key), value_offset, len(aliases[key])))
+
+    lines = [
+        f"// Generated by tools/gen_city_aliases.py from {source}; do not edit.",
+        "",
+        "namespace CityAliasTable {",
+        "",
+        "struct Entry {",
+        "    quint32 keyOffset;",
+        "    quint32 keyLength; // 0 marks an empty slot",
+        "    quint32 valueOffset;",
+        "    quint32 valueLength;",
+        "};",
+        "",
+        f"constexpr quint32 kSeed = {seed}u;",
+        f"constexpr quint32 kBucketCount = {len(displacements)}u;",
+        f"constexpr quint32 kSlotCount = {len(slots)}u;",
+        f"constexpr quint32 kFoldLimit = 0x{FOLD_LIMIT:x}u;",
+        "",
+        # A brace list rather than one string literal; MSVC caps literals at 64 KB
+        f"constexpr char kStrings[{max(1, len(blob))}] = {{",
+    ]
+    data = list(blob) or [0]
+    for i in range(0, len(data), 16):
+        lines.append("    " + ", ".join(f"'\\x{b:02x}'" for b in data[i:i + 16]) + ",")
+    lines += ["};", "", f"constexpr Entry kEntries[{len(entries)}] = {{"]
+    for entry in entries:
+        lines.append("    {%du, %du, %du, %du}," % entry)
+    lines += ["};", "", f"constexpr quint32 kDisplacements[{len(displacements)}] = {{"]
+    for i in range(0, len(displacements), 8):
+        lines.append("    " + ", ".join(f"{d}u" for d in displacements[i:i + 8]) + ",")
+    lines += ["};", "", "// Normalized UTF-8 spelling of each code point below kFoldLimit",
+              "constexpr const char *kFold[kFoldLimit] = {"]
+    for cp in range(0, FOLD_LIMIT, 8):
+        lines.append("    " + ", ".join(c_string(FOLD_TABLE[c]) for c in range(cp, cp + 8)) + ",")
+    lines += ["};", "", "} // namespace CityAliasTable", ""]
+
+    with open(path, "w", encoding="utf-8", newline="\n") as f:
+        f.write("\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("input")
+    parser.add_argument("output")
+    options = parser.parse_args()
+
+    aliases = read_aliases(options.input)
+    keys = sorted(aliases)
+    for seed in range(1, 1000):
+        table = build_table(keys, seed)
+        if table:
+            break
+    else:
+        sys.exit("no perfect hash found; try a different table size")
+
+    emit(options.output, options.input.replace("\\", "/").split("/")[-1], aliases, seed, *table)
+
+
+if __name__ == "__main__":
+    main()
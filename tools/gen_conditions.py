@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+"""
+Generates the compile-time weather condition table from a tab-separated data file.
+
+The first non-comment line is the header, `id<TAB>icon<TAB>` followed by one
+language code per column; every following line is an OpenWeatherMap
+condition id, its icon and its description in each language. Blank lines and
+lines starting with '#' are skipped. The output maps each id to a row with a
+flat array indexed by id, so a lookup is two array reads.
+
+    python3 tools/gen_conditions.py data/weather_conditions.tsv conditions_table.h
+
+qmake runs this as an extra compiler; see ElegantWeather.pro.
+"""
+
+import argparse
+import sys
+
+FALLBACK_ICON = "🌤️"  # Row 0, for ids the table doesn't know
+
+
+def read_conditions(path: str):
+    languages = None
+    rows = {}
+    with open(path, encoding="utf-8") as f:
+        for number, line in enumerate(f, 1):
+            line = line.rstrip("\n")
+            if not line.strip() or line.lstrip().startswith("#"):
+                continue
+            fields = [field.strip() for field in line.split("\t")]
+            if languages is None:
+                if len(fields) < 3 or fields[:2] != ["id", "icon"]:
+                    sys.exit(f"{path}:{number}: expected 'id<TAB>icon<TAB>language...' header")
+                languages = fields[2:]
+                if languages[0] != "en":
+                    sys.exit(f"{path}:{number}: the first language must be 'en', the fallback")
+                continue
+            if len(fields) != len(languages) + 2 or not all(fields):
+                sys.exit(f"{path}:{number}: expected an id, an icon and {len(languages)} descriptions")
+            if not fields[0].isdigit() or not 100 <= int(fields[0]) <= 999:
+                sys.exit(f"{path}:{number}: '{fields[0]}' is not a condition id")
+            condition_id = int(fields[0])
+            if condition_id in rows:
+                sys.exit(f"{path}:{number}: condition {condition_id} is listed twice")
+            rows[condition_id] = (fields[1], fields[2:])
+    if not rows:
+        sys.exit(f"{path}: no conditions")
+    return languages, rows
+
+
+def c_string(text: str) -> str:
+    # One literal per byte so a hex escape can't swallow the next character
+    if all(0x20 <= ord(c) < 0x7F and c not in '"\\' for c in text):
+        return f'"{text}"'
+    return " ".join(f'"\\x{b:02x}"' for b in text.encode("utf-8")) or '""'
+
+
+def emit(path: str, source: str, languages: list, rows: dict):
+    ids = sorted(rows)
+    first, last = ids[0], ids[-1]
+    row_of = {condition_id: row for row, condition_id in enumerate(ids, 1)}
+    index = [row_of.get(condition_id, 0) for condition_id in range(first, last + 1)]
+    if len(ids) > 255:
+        sys.exit("more than 255 conditions; widen kRows")
+
+    lines = [
+        f"// Generated by tools/gen_conditions.py from {source}; do not edit.",
+        "",
+        "namespace ConditionTable {",
+        "",
+        f"constexpr int kFirstId = {first};",
+        f"constexpr int kLastId = {last};",
+        f"constexpr int kRowCount = {len(ids) + 1}; // Row 0 stands in for unknown ids",
+        f"constexpr int kLanguageCount = {len(languages)}; // English first",
+        "",
+        "constexpr const char *kLanguages[kLanguageCount] = {",
+        "    " + ", ".join(c_string(language) for language in languages) + ",",
+        "};",
+        "",
+        "// Row of each id from kFirstId to kLastId; 0 where there's no such condition",
+        "constexpr quint8 kRows[kLastId - kFirstId + 1] = {",
+    ]
+    for i in range(0, len(index), 20):
+        lines.append("    " + ", ".join(str(row) for row in index[i:i + 20]) + ",")
+    lines += ["};", "", "constexpr const char *kIcons[kRowCount] = {", f"    {c_string(FALLBACK_ICON)},"]
+    for condition_id in ids:
+        lines.append(f"    {c_string(rows[condition_id][0])}, // {condition_id}")
+    lines += ["};", "", "constexpr const char *kDescriptions[kRowCount][kLanguageCount] = {",
+              "    {" + ", ".join('""' for _ in languages) + "},"]
+    for condition_id in ids:
+        lines.append(f"    // {condition_id} {rows[condition_id][1][0]}")
+        lines.append("    {" + ", ".join(c_string(text) for text in rows[condition_id][1]) + "},")
+    lines += ["};", "", "} // namespace ConditionTable", ""]
+
+    with open(path, "w", encoding="utf-8", newline="\n") as f:
+        f.write("\n".join(lines))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("input")
+    parser.add_argument("output")
+    options = parser.parse_args()
+
+    languages, rows = read_conditions(options.input)
+    emit(options.output, options.input.replace("\\", "/").split("/")[-1], languages, rows)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,47 @@
+#!/usr/bin/env python3
+"""
+Local stand-in for weather-ai-agent/service.py: the same JSON-lines protocol
+over stdin/stdout, with canned replies and no model behind it.
+
+Point the app at it with ELEGANTWEATHER_AI_SERVICE. Replies are
+ELEGANTWEATHER_MOCK_AI_REPLY_CHARS characters long (default 800), about the
+length of a real answer.
+"""
+
+import json
+import os
+import sys
+
+
+def handle_request(request: dict, state: dict, reply_chars: int) -> dict:
+    command = request.get("command")
+    if command == "set_weather":
+        state["location"] = request.get("location", "")
+        return {"status": "success", "command": "set_weather", "location": state["location"]}
+    if command == "query":
+        if not request.get("prompt"):
+            return {"status": "error", "command": "query", "message": "No prompt provided"}
+        text = f"In {state.get('location') or 'your city'} it looks like a fine day. "
+        return {"status": "success", "command": "query", "response": (text * (reply_chars // len(text) + 1))[:reply_chars],
+                "is_bye": False}
+    if command == "ping":
+        return {"status": "success", "command": "ping", "message": "pong"}
+    return {"status": "error", "message": f"Unknown command: {command}"}
+
+
+def main():
+    reply_chars = int(os.environ.get("ELEGANTWEATHER_MOCK_AI_REPLY_CHARS", "800"))
+    state = {}
+    sys.stdout.write(json.dumps({"status": "ready"}) + "\n")
+    sys.stdout.flush()
+    for line in sys.stdin:
+        try:
+            response = handle_request(json.loads(line), state, reply_chars)
+        except json.JSONDecodeError as e:
+            response = {"status": "error", "message": f"Invalid JSON: {e}"}
+        sys.stdout.write(json.dumps(response) + "\n")
+        sys.stdout.flush()
+
+
+if __name__ == "__main__":
+    main()
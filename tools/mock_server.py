@@ -0,0 +1,262 @@
+#!/usr/bin/env python3
+"""
+Local stand-in for the OpenWeatherMap, Unsplash and NASA endpoints.
+
+Point the app at it with ELEGANTWEATHER_OWM_URL / ELEGANTWEATHER_UNSPLASH_URL /
+ELEGANTWEATHER_NASA_URL. With --cert/--key it serves TLS; pass the same
+certificate to the app through ELEGANTWEATHER_CA_CERTS. GET /__stats returns
+connection and request counters so connection reuse can be checked. Photo
+searches point back at the server, which serves a generated PNG per query.
+
+    openssl req -x509 -newkey rsa:2048 -nodes -days 30 -subj /CN=localhost \\
+        -keyout key.pem -out cert.pem
+    python3 tools/mock_server.py --port 8443 --cert cert.pem --key key.pem
+"""
+
+import argparse
+import hashlib
+import json
+import math
+import random
+import ssl
+import struct
+import threading
+import time
+import zlib
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from urllib.parse import urlparse, parse_qs
+
+
+class Stats:
+    def __init__(self):
+        self.lock = threading.Lock()
+        self.connections = 0
+        self.requests = {}
+        self.rate_limited = 0
+        self.window_start = time.monotonic()
+        self.window_count = 0
+
+    def count_connection(self):
+        with self.lock:
+            self.connections += 1
+
+    def count_request(self, path: str):
+        with self.lock:
+            self.requests[path] = self.requests.get(path, 0) + 1
+
+    def take_quota(self, per_minute: int) -> int:
+        """Fixed one-minute window like OpenWeatherMap; returns Retry-After or 0"""
+        with self.lock:
+            now = time.monotonic()
+            if now - self.window_start >= 60:
+                self.window_start = now
+                self.window_count = 0
+            if self.window_count >= per_minute:
+                self.rate_limited += 1
+                return max(1, int(60 - (now - self.window_start)))
+            self.window_count += 1
+            return 0
+
+    def snapshot(self) -> dict:
+        with self.lock:
+            return {
+                "connections": self.connections,
+                "requests": dict(self.requests),
+                "totalRequests": sum(self.requests.values()),
+                "rateLimited": self.rate_limited,
+            }
+
+
+def weather_payload(city: str) -> dict:
+    seed = sum(ord(c) for c in city)
+    temp = 275.0 + seed % 30
+    return {
+        "coord": {"lon": -122.42 + seed % 7, "lat": 37.77 - seed % 5},
+        "weather": [{"id": 801, "main": "Clouds", "description": "few clouds", "icon": "02d"}],
+        "main": {
+            "temp": temp,
+            "feels_like": temp - 1.5,
+            "temp_min": temp - 3.0,
+            "temp_max": temp + 2.5,
+            "pressure": 1015,
+            "humidity": 40 + seed % 50,
+        },
+        "wind": {"speed": 3.6 + seed % 4},
+        "dt": int(time.time()),
+        "timezone": -25200,
+        "name": city.split(",")[0],
+        "cod": 200,
+    }
+
+
+def forecast_payload(city: str) -> dict:
+    seed = sum(ord(c) for c in city)
+    start = int(time.time()) // 10800 * 10800 + 10800
+    steps = []
+    for i in range(40):
+        hour = (start + i * 10800 - 25200) // 3600 % 24
+        temp = 275.0 + seed % 30 + 6.0 * math.sin((hour - 9) / 24.0 * 2 * math.pi)
+        step = {
+            "dt": start + i * 10800,
+            "main": {"temp": round(temp, 2), "humidity": 40 + (seed + i) % 50},
+            "weather": [{"id": 500 if (seed + i) % 9 == 0 else 801}],
+            "pop": round(((seed + i) % 10) / 10.0, 1),
+        }
+        if (seed + i) % 9 == 0:
+            step["rain"] = {"3h": 0.4 + (i % 3) * 0.3}
+        steps.append(step)
+    return {"cod": "200", "cnt": len(steps), "list": steps,
+            "city": {"name": city.split(",")[0], "timezone": -25200}}
+
+
+def geocode_payload(query: str) -> list:
+    name = query.split(",")[0].strip().title()
+    return [
+        {"name": name, "state": "California", "country": "US", "lat": 37.77, "lon": -122.42},
+        {"name": name, "country": "GB", "lat": 51.5, "lon": -0.12},
+    ]
+
+
+def mars_payload() -> dict:
+    sols = ["675", "676", "677", "678", "679", "680", "681"]
+    payload = {"sol_keys": sols}
+    for i, sol in enumerate(sols):
+        payload[sol] = {
+            "AT": {"av": -62.3 - i, "mx": -20.1 + i, "mn": -96.2 - i},
+            "HWS": {"av": 4.7 + i * 0.2},
+            "PRE": {"av": 750.0 + i},
+            "First_UTC": "2020-10-%02dT00:00:00Z" % (12 + i),
+        }
+    return payload
+
+
+def noise_png(width: int, height: int) -> bytes:
+    # Noise doesn't compress, so the download and decoded sizes are those of a real photo
+    rows = random.Random(width * height)
+    raw = b"".join(b"\x00" + rows.randbytes(width * 3) for _ in range(height))
+
+    def chunk(kind: bytes, data: bytes) -> bytes:
+        return struct.pack(">I", len(data)) + kind + data + struct.pack(">I", zlib.crc32(kind + data))
+
+    header = struct.pack(">IIBBBBB", width, height, 8, 2, 0, 0, 0)
+    return (b"\x89PNG\r\n\x1a\n" + chunk(b"IHDR", header) + chunk(b"IDAT", zlib.compress(raw, 1))
+            + chunk(b"IEND", b""))
+
+
+class MockHandler(BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"  # Keep-alive, so connection reuse is observable
+
+    def log_message(self, format, *args):
+        if self.server.verbose:
+            super().log_message(format, *args)
+
+    def do_GET(self):
+        url = urlparse(self.path)
+        query = {k: v[0] for k, v in parse_qs(url.query).items()}
+
+        if url.path == "/__stats":
+            self.send_json(self.server.stats.snapshot())
+            return
+
+        self.server.stats.count_request(url.path)
+        self.simulate_latency()
+
+        quota = self.server.options.rate_limit
+        if quota and url.path in ("/data/2.5/weather", "/data/2.5/uvi", "/data/2.5/forecast", "/geo/1.0/direct"):
+            retry_after = self.server.stats.take_quota(quota)
+            if retry_after:
+                self.send_json({"cod": 429, "message": "rate limit exceeded"}, status=429,
+                               headers={"Retry-After": str(retry_after)})
+                return
+
+        if url.path == "/data/2.5/weather":
+            self.send_json(weather_payload(query.get("q", "San Francisco")))
+        elif url.path == "/data/2.5/forecast":
+            self.send_json(forecast_payload(query.get("q", "San Francisco")))
+        elif url.path == "/data/2.5/uvi":
+            self.send_json({"lat": query.get("lat"), "lon": query.get("lon"), "value": 6.2})
+        elif url.path == "/geo/1.0/direct":
+            self.send_json(geocode_payload(query.get("q", "")))
+        elif url.path == "/search/photos":
+            photo = hashlib.sha1(query.get("query", "").encode("utf-8")).hexdigest()[:16]
+            host = self.headers.get("Host", f"{self.server.options.host}:{self.server.options.port}")
+            self.send_json({"results": [{"urls": {"regular": f"{self.server.scheme}://{host}/photos/{photo}.png"}}]})
+        elif url.path.startswith("/photos/"):
+            self.send_bytes(self.server.photo, "image/png")
+        elif url.path.startswith("/insight_weather"):
+            self.send_json(mars_payload())
+        else:
+            self.send_json({"cod": 404, "message": "not found"}, status=404)
+
+    def simulate_latency(self):
+        options = self.server.options
+        delay = options.latency_ms + random.uniform(0, options.jitter_ms)
+        if options.stall_rate and random.random() < options.stall_rate:
+            delay += options.stall_ms
+        if delay > 0:
+            time.sleep(delay / 1000.0)
+
+    def send_json(self, payload, status: int = 200, headers: dict = None):
+        self.send_bytes(json.dumps(payload).encode("utf-8"), "application/json; charset=utf-8", status, headers)
+
+    def send_bytes(self, body: bytes, content_type: str, status: int = 200, headers: dict = None):
+        self.send_response(status)
+        self.send_header("Content-Type", content_type)
+        self.send_header("Content-Length", str(len(body)))
+        for name, value in (headers or {}).items():
+            self.send_header(name, value)
+        self.end_headers()
+        self.wfile.write(body)
+
+
+class MockServer(ThreadingHTTPServer):
+    daemon_threads = True
+
+    def __init__(self, address, options):
+        super().__init__(address, MockHandler)
+        self.options = options
+        self.verbose = options.verbose
+        self.stats = Stats()
+        self.scheme = "http"
+        width, height = options.photo_size
+        self.photo = noise_png(width, height)
+
+    def get_request(self):
+        connection = super().get_request()
+        self.stats.count_connection()
+        return connection
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Local stand-in for ElegantWeather's upstream APIs")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8443)
+    parser.add_argument("--cert", help="PEM certificate; enables TLS together with --key")
+    parser.add_argument("--key", help="PEM private key")
+    parser.add_argument("--latency-ms", type=float, default=0.0, help="Base server time per request")
+    parser.add_argument("--jitter-ms", type=float, default=0.0, help="Uniform extra server time")
+    parser.add_argument("--stall-rate", type=float, default=0.0, help="Fraction of requests that stall")
+    parser.add_argument("--stall-ms", type=float, default=10000.0, help="Extra delay of a stalled request")
+    parser.add_argument("--rate-limit", type=int, default=0,
+                        help="OpenWeatherMap calls per minute before answering 429 (0 = unlimited)")
+    parser.add_argument("--photo-size", type=int, nargs=2, default=(400, 600), metavar=("WIDTH", "HEIGHT"),
+                        help="Size of the photo served for every search")
+    parser.add_argument("--verbose", action="store_true")
+    options = parser.parse_args()
+
+    server = MockServer((options.host, options.port), options)
+    if options.cert and options.key:
+        context = ssl.SSLContext(ssl.PROTOCOL_TLS_SERVER)
+        context.load_cert_chain(options.cert, options.key)
+        server.socket = context.wrap_socket(server.socket, server_side=True)
+        server.scheme = "https"
+
+    print(f"Mock server listening on {server.scheme}://{options.host}:{options.port}", flush=True)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+
+
+if __name__ == "__main__":
+    main()
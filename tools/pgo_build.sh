@@ -0,0 +1,154 @@
+#!/usr/bin/env bash
+# Profile-guided, link-time optimized release build (GCC or Clang).
+#
+#   tools/pgo_build.sh [build-dir] [trace.ndjson...]
+#
+# 1. Builds the plain LTO release into build-dir/baseline, for comparison.
+# 2. Builds an instrumented release into build-dir/pgo (qmake PGO=generate).
+# 3. Trains it offline: the benchmark suite against tools/mock_server.py, each
+#    recorded session given (see ELEGANTWEATHER_RECORD) replayed through the
+#    resilience layer, and a few cold starts on the offscreen platform.
+# 4. Rebuilds build-dir/pgo with the collected profile (qmake PGO=use).
+# 5. Runs the parse, IPC and startup benchmarks on both builds and writes
+#    build-dir/pgo-comparison.txt.
+#
+# Every launch of the app is bounded by timeout(1), where available, so a
+# hung run fails instead of stalling the build.
+#
+# QMAKE, MAKEFLAGS, PYTHON, PGO_MOCK_PORT, PGO_BENCH_TIMEOUT and
+# PGO_STARTUP_TIMEOUT (seconds) override the defaults.
+set -euo pipefail
+
+SRC=$(cd "$(dirname "$0")/.." && pwd)
+BUILD=$(mkdir -p "${1:-$SRC/build-pgo}" && cd "${1:-$SRC/build-pgo}" && pwd)
+shift || true
+TRACES=("$@")
+
+QMAKE=${QMAKE:-qmake}
+PYTHON=${PYTHON:-python3}
+PORT=${PGO_MOCK_PORT:-8631}
+export MAKEFLAGS=${MAKEFLAGS:--j$(nproc 2>/dev/null || sysctl -n hw.ncpu)}
+PGO_DIR=$BUILD/pgo-data
+
+# Benchmarks compared between the builds: response parsing and aggregation,
+# cross-process cache, log hand-off and the AI service pipe. Startup is timed
+# separately.
+COMPARE=(parse forecast history aliases conditions sharedcache logging aiagent)
+STARTUP_RUNS=5
+BENCH_TIMEOUT=${PGO_BENCH_TIMEOUT:-1800}
+STARTUP_TIMEOUT=${PGO_STARTUP_TIMEOUT:-60}
+
+bounded() { # seconds, command...
+    if command -v timeout >/dev/null; then
+        timeout "$@"
+    elif command -v gtimeout >/dev/null; then
+        gtimeout "$@"
+    else
+        shift
+        "$@"
+    fi
+}
+
+binary() {
+    if [[ -x $1/ElegantWeather.app/Contents/MacOS/ElegantWeather ]]; then
+        echo "$1/ElegantWeather.app/Contents/MacOS/ElegantWeather"
+    else
+        echo "$1/ElegantWeather"
+    fi
+}
+
+build() { # dir, qmake arguments...
+    local dir=$1
+    shift
+    mkdir -p "$dir"
+    (cd "$dir" && "$QMAKE" "$SRC/ElegantWeather.pro" CONFIG+=release PYTHON="$PYTHON" "$@" && make)
+}
+
+# Cold starts on the offscreen platform; prints the time to the first frame of each
+startups() { # binary
+    for ((i = 0; i < STARTUP_RUNS; ++i)); do
+        QT_QPA_PLATFORM=offscreen QT_QUICK_BACKEND=software bounded "$STARTUP_TIMEOUT" \
+            "$1" --startup-profile | awk '$1 == "first" && $2 == "frame" { print $4 }' \
+            || echo "warning: cold start $((i + 1)) failed or timed out" >&2
+    done
+}
+
+run_benchmarks() { # binary, benchmark names...
+    local app=$1
+    shift
+    ELEGANTWEATHER_OWM_URL=http://127.0.0.1:$PORT \
+    ELEGANTWEATHER_UNSPLASH_URL=http://127.0.0.1:$PORT \
+    ELEGANTWEATHER_NASA_URL=http://127.0.0.1:$PORT \
+    ELEGANTWEATHER_AI_SERVICE=$SRC/tools/mock_ai_service.py \
+        bounded "$BENCH_TIMEOUT" "$app" --benchmark "$@"
+}
+
+echo "== Baseline (LTO) build"
+build "$BUILD/baseline"
+
+echo "== Instrumented build"
+rm -rf "$PGO_DIR"
+mkdir -p "$PGO_DIR"
+build "$BUILD/pgo" PGO=generate PGO_DIR="$PGO_DIR"
+
+"$PYTHON" "$SRC/tools/mock_server.py" --host 127.0.0.1 --port "$PORT" --latency-ms 20 --jitter-ms 10 &
+MOCK=$!
+trap 'kill $MOCK 2>/dev/null || true' EXIT
+sleep 1
+
+# A failed training run only costs coverage, so keep going
+echo "== Training"
+run_benchmarks "$(binary "$BUILD/pgo")" || echo "warning: benchmark training run failed"
+for trace in ${TRACES[@]+"${TRACES[@]}"}; do
+    ELEGANTWEATHER_REPLAY=$trace ELEGANTWEATHER_REPLAY_SPEED=0 \
+        run_benchmarks "$(binary "$BUILD/pgo")" replay || echo "warning: replay of $trace failed"
+done
+startups "$(binary "$BUILD/pgo")" >/dev/null
+
+if compgen -G "$PGO_DIR/*.profraw" >/dev/null; then
+    "${LLVM_PROFDATA:-llvm-profdata}" merge -output="$PGO_DIR/merged.profdata" "$PGO_DIR"/*.profraw
+fi
+
+echo "== Optimized build"
+# Same directory, so GCC finds each object's profile under the same name
+(cd "$BUILD/pgo" && make clean >/dev/null)
+rm -f "$(binary "$BUILD/pgo")"
+build "$BUILD/pgo" PGO=use PGO_DIR="$PGO_DIR"
+
+echo "== Comparison"
+# A benchmark that reports a failure (the shared cache one does when fetches
+# exceed their bound) still prints its numbers; compare them and say so. The
+# replay runs on its own, as a replay setting turns off the network and the
+# shared cache for everything else.
+measure() { # build dir, output file
+    {
+        run_benchmarks "$(binary "$1")" "${COMPARE[@]}" || echo "warning: a comparison benchmark failed on $1" >&2
+        if ((${#TRACES[@]})); then
+            ELEGANTWEATHER_REPLAY=${TRACES[0]} run_benchmarks "$(binary "$1")" replay \
+                || echo "warning: the replay benchmark failed on $1" >&2
+        fi
+        startups "$(binary "$1")" | sort -n | awk '{ t[NR] = $1 } END { if (NR) printf "%-14s %-28s %14.3f ms\n", "startup", "first frame, median", t[int((NR + 1) / 2)] }'
+    } >"$2"
+}
+measure "$BUILD/baseline" "$BUILD/report-baseline.txt"
+measure "$BUILD/pgo" "$BUILD/report-pgo.txt"
+
+# Benchmark lines are "bench metric value unit"; join them on bench and metric
+awk 'FNR == 1 { file++ }
+     NF >= 4 && $(NF - 1) ~ /^-?[0-9.]+$/ {
+         key = $1 " " $2
+         for (i = 3; i < NF - 1; ++i) key = key " " $i
+         if (file == 1) { base[key] = $(NF - 1); unit[key] = $NF; order[++n] = key }
+         else pgo[key] = $(NF - 1)
+     }
+     END {
+         printf "%-44s %14s %14s %8s\n", "benchmark metric", "LTO", "LTO+PGO", "ratio"
+         for (i = 1; i <= n; ++i) {
+             k = order[i]
+             if (!(k in pgo)) continue
+             printf "%-44s %14.3f %14.3f %8s  %s\n", k, base[k], pgo[k],
+                    base[k] != 0 ? sprintf("%.2f", pgo[k] / base[k]) : "-", unit[k]
+         }
+     }' "$BUILD/report-baseline.txt" "$BUILD/report-pgo.txt" | tee "$BUILD/pgo-comparison.txt"
+
+echo "Optimized binary: $(binary "$BUILD/pgo")"
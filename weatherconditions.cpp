@@ -0,0 +1,40 @@
+#include "weatherconditions.h"
+#include <QLatin1StringView>
+#include <QtGlobal>
+#include "conditions_table.h" // Generated from data/weather_conditions.tsv
+
+namespace {
+
+int rowFor(int conditionId)
+{
+    if (conditionId < ConditionTable::kFirstId || conditionId > ConditionTable::kLastId) return 0;
+    return ConditionTable::kRows[conditionId - ConditionTable::kFirstId];
+}
+
+int languageColumn(QStringView language)
+{
+    const QStringView code = language.left(2);
+    for (int column = 0; column < ConditionTable::kLanguageCount; ++column) {
+        if (code.compare(QLatin1StringView(ConditionTable::kLanguages[column]), Qt::CaseInsensitive) == 0) {
+            return column;
+        }
+    }
+    return 0; // English
+}
+
+} // namespace
+
+bool WeatherConditions::isKnown(int conditionId)
+{
+    return rowFor(conditionId) != 0;
+}
+
+QString WeatherConditions::icon(int conditionId)
+{
+    return QString::fromUtf8(ConditionTable::kIcons[rowFor(conditionId)]);
+}
+
+QString WeatherConditions::description(int conditionId, QStringView language)
+{
+    return QString::fromUtf8(ConditionTable::kDescriptions[rowFor(conditionId)][languageColumn(language)]);
+}
@@ -0,0 +1,26 @@
+#ifndef WEATHERCONDITIONS_H
+#define WEATHERCONDITIONS_H
+
+#include <QString>
+#include <QStringView>
+
+// Icons and localized descriptions for OpenWeatherMap condition ids
+// (https://openweathermap.org/weather-conditions). The table is generated
+// at build time from data/weather_conditions.tsv by tools/gen_conditions.py
+// and indexed directly by id, so changing the display language re-renders
+// from the stored id without asking the API for another translation.
+namespace WeatherConditions {
+
+bool isKnown(int conditionId);
+
+// A generic icon for unknown ids
+QString icon(int conditionId);
+
+// Lowercase, as the API words them. Languages are matched on their first
+// two letters ("pt_BR" is "pt"); unsupported ones get English. Empty for
+// unknown ids.
+QString description(int conditionId, QStringView language);
+
+} // namespace WeatherConditions
+
+#endif // WEATHERCONDITIONS_H
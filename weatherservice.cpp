@@ -6,17 +6,181 @@
 #include <QDateTime>
 #include <QNetworkAccessManager>
 #include <QNetworkReply>
-#include <QSettings>
 #include <QTimer>
 #include <QLocale>
-#include <QDebug>
+#include <QGuiApplication>
+#include <QSslConfiguration>
+#include <QStandardPaths>
+#include "appsettings.h"
+#include "resilientreply.h"
+#include "forecastmodel.h"
+#include "cityaliases.h"
+#include "networktrace.h"
+#include "weatherconditions.h"
+#include "logging.h"
+#include "memorybudget.h"
+#include "backgroundimages.h"
+#include <QPointer>
+#include <utility>
+
+namespace {
+
+// Re-prewarm once connections have sat unused long enough for servers to drop them
+constexpr qint64 kConnectionIdleMs = 60 * 1000;
+
+// OpenWeatherMap recomputes the 5-day forecast every three hours
+constexpr qint64 kForecastMaxAgeMs = 60 * 60 * 1000;
+
+// Observations older than this are averaged down to one per resolution
+constexpr qint64 kHistoryFullResolutionSeconds = 90 * 24 * 60 * 60;
+constexpr qint64 kHistoryCompactedResolutionSeconds = 60 * 60;
+constexpr int kHistoryCompactionDelayMs = 30 * 1000;
+constexpr int kHistoryCompactionStepMs = 200; // Between cities, so input and paints get through
+
+// A new InSight sol can appear at most about once a day (a sol is 24h 39m)
+constexpr qint64 kMarsRefetchMs = 12 * 60 * 60 * 1000;
+
+// How long a leased fetch may take before waiting instances do it themselves,
+// and how often they look for its result meanwhile
+constexpr qint64 kSharedLeaseMs = 15 * 1000;
+constexpr int kSharedPollMs = 50;
+
+// A position farther than this from every known city doesn't snap to one
+constexpr double kCitySnapRadiusKm = 75;
+
+// Budget for the last-good-response cache the circuit breaker serves from
+constexpr int kResponseCacheBytes = 1024 * 1024;
+
+// Default memory budgets; see MemoryBudget. About a thousand cities' forecasts,
+// fifty mapped history segments and every InSight sol ever published.
+constexpr qint64 kForecastBudgetBytes = 1024 * 1024;
+constexpr qint64 kHistoryMappedBudgetBytes = 32 * 1024 * 1024;
+constexpr qint64 kMarsSolBudgetBytes = 512 * 1024;
+constexpr qint64 kCityIndexBudgetBytes = 1024 * 1024;
+
+QString endpointBaseUrl(const char *envVar, const char *defaultUrl)
+{
+    const QString override = qEnvironmentVariable(envVar);
+    return override.isEmpty() ? QString::fromLatin1(defaultUrl) : override;
+}
+
+// Cache key for a request URL with credentials stripped
+QString responseCacheKey(const QUrl &url)
+{
+    return NetworkTrace::withoutSecrets(url).toString();
+}
+
+// ELEGANTWEATHER_RECORD captures every request to a trace file;
+// ELEGANTWEATHER_REPLAY answers from one instead of the network
+QNetworkAccessManager *createNetworkManager(QObject *parent)
+{
+    const QString replay = qEnvironmentVariable("ELEGANTWEATHER_REPLAY");
+    if (!replay.isEmpty()) {
+        bool ok = false;
+        const double speed = qEnvironmentVariable("ELEGANTWEATHER_REPLAY_SPEED").toDouble(&ok);
+        return new ReplayNetworkAccessManager(NetworkTrace::load(replay), ok ? speed : 1.0, parent);
+    }
+
+    const QString record = qEnvironmentVariable("ELEGANTWEATHER_RECORD");
+    if (!record.isEmpty()) return new RecordingNetworkAccessManager(record, parent);
+    return new QNetworkAccessManager(parent);
+}
+
+// How long a body another instance fetched stays good; 0 keeps the endpoint private
+qint64 sharedCacheMaxAgeMs(RequestMetrics::Endpoint endpoint)
+{
+    switch (endpoint) {
+        case RequestMetrics::Weather:
+            return 5 * 60 * 1000; // Stations report about every 10 minutes
+        case RequestMetrics::Uv:
+            return 10 * 60 * 1000;
+        case RequestMetrics::Forecast:
+            return 30 * 60 * 1000;
+        case RequestMetrics::Geocoding:
+        case RequestMetrics::Unsplash:
+            return 60 * 60 * 1000;
+        default:
+            return 0; // Mars sols have their own permanent cache
+    }
+}
+
+// One segment per user: QSharedMemory segments are private to their owner
+QString sharedCacheName()
+{
+    // A replay must see only its trace, not what other instances fetched, and
+    // a recording must see every response go over its own network manager
+    if (!qEnvironmentVariableIsEmpty("ELEGANTWEATHER_REPLAY")
+        || !qEnvironmentVariableIsEmpty("ELEGANTWEATHER_RECORD")) {
+        return QString();
+    }
+
+    const QString override = qEnvironmentVariable("ELEGANTWEATHER_SHARED_CACHE");
+    if (!override.isEmpty()) return override;
+    QString user = qEnvironmentVariable("USER");
+    if (user.isEmpty()) user = qEnvironmentVariable("USERNAME");
+    return "ElegantWeather.responses." + user;
+}
+
+QString historyDirectory()
+{
+    const QString override = qEnvironmentVariable("ELEGANTWEATHER_HISTORY_DIR");
+    if (!override.isEmpty()) return override;
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/history";
+}
+
+QString marsCacheDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::AppLocalDataLocation) + "/mars";
+}
+
+// Snapshot of an OpenWeatherMap current-conditions object; UV is patched in later
+HistoryRecord historyRecordFrom(const QJsonObject &weather)
+{
+    const QJsonObject main = weather["main"].toObject();
+    HistoryRecord record;
+    record.time = weather["dt"].toInteger();
+    record.temperatureKelvin = float(main["temp"].toDouble());
+    record.feelsLikeKelvin = float(main["feels_like"].toDouble());
+    record.humidity = float(main["humidity"].toDouble());
+    record.pressure = float(main["pressure"].toDouble());
+    record.windSpeed = float(weather["wind"].toObject()["speed"].toDouble());
+    record.conditionId = quint16(weather["weather"].toArray().at(0).toObject()["id"].toInt());
+    return record;
+}
+
+// max-age from the Cache-Control header; 0 if the server didn't send one
+qint64 cacheMaxAgeSeconds(const QNetworkReply *reply)
+{
+    const QList<QByteArray> directives = reply->rawHeader("Cache-Control").split(',');
+    for (const QByteArray &directive : directives) {
+        const QByteArray trimmed = directive.trimmed();
+        if (trimmed.startsWith("max-age=")) {
+            return trimmed.mid(8).toLongLong();
+        }
+    }
+    return 0;
+}
+
+} // namespace
 
 WeatherService::WeatherService(QObject *parent)
     : QObject(parent)
-    , m_networkManager(new QNetworkAccessManager(this))
+    , m_networkManager(nullptr) // Created by startNetwork()
+    , m_metrics(new RequestMetrics(this))
+    , m_scheduler(new RequestScheduler(this))
+    , m_refreshEngine(new RefreshEngine(this))
+    , m_autoRefresh(true)
+    , m_forecastModel(new ForecastModel(this))
+    , m_history(historyDirectory())
+    , m_marsSols(marsCacheDirectory())
+    , m_openWeatherBaseUrl(endpointBaseUrl("ELEGANTWEATHER_OWM_URL", "https://api.openweathermap.org"))
+    , m_unsplashBaseUrl(endpointBaseUrl("ELEGANTWEATHER_UNSPLASH_URL", "https://api.unsplash.com"))
+    , m_nasaBaseUrl(endpointBaseUrl("ELEGANTWEATHER_NASA_URL", "https://api.nasa.gov"))
+    , m_memoryBudget(nullptr)
     , m_city("San Francisco")
     , m_currentPlanet("Earth")
     , m_temperatureKelvin(293.15) // Default to 20°C / 68°F
+    , m_conditionId(0)
     , m_highTempKelvin(293.15)
     , m_lowTempKelvin(293.15)
     , m_humidity(0)
@@ -32,30 +196,325 @@ WeatherService::WeatherService(QObject *parent)
     , m_timeFormat("12")
     , m_language("en")
 {
-    qDebug() << "INIT: Starting with temperatureUnit =" << m_temperatureUnit;
-    initializeCityMappings();
+    qCDebug(lcWeather) << "INIT: Starting with temperatureUnit =" << m_temperatureUnit;
     loadSettings();
-    qDebug() << "INIT: After loadSettings, temperatureUnit =" << m_temperatureUnit;
+    qCDebug(lcWeather) << "INIT: After loadSettings, temperatureUnit =" << m_temperatureUnit;
 
     // Force fix if somehow Kelvin got through
     if (m_temperatureUnit == "Kelvin") {
-        qDebug() << "INIT: KELVIN DETECTED! Forcing to Fahrenheit";
+        qCDebug(lcWeather) << "INIT: KELVIN DETECTED! Forcing to Fahrenheit";
         m_temperatureUnit = "Fahrenheit";
         saveSettings();
     }
-    qDebug() << "INIT: Final temperatureUnit =" << m_temperatureUnit;
+    qCDebug(lcWeather) << "INIT: Final temperatureUnit =" << m_temperatureUnit;
 
     // Setup search timer for debouncing
     m_searchTimer = new QTimer(this);
     m_searchTimer->setSingleShot(true);
     m_searchTimer->setInterval(300); // 300ms delay
     connect(m_searchTimer, &QTimer::timeout, this, &WeatherService::performCitySearch);
+
+    // Request instrumentation is opt-in; while disabled it costs one branch per reply
+    m_metrics->setEnabled(qEnvironmentVariableIntValue("ELEGANTWEATHER_METRICS") > 0);
+    m_tracePath = qEnvironmentVariable("ELEGANTWEATHER_TRACE");
+    if (!m_tracePath.isEmpty()) {
+        m_metrics->setEnabled(true);
+        m_metrics->setTracing(true);
+    }
+    connect(m_metrics, &RequestMetrics::updated, this, &WeatherService::metricsChanged);
+
+    // Unsplash and the NASA DEMO_KEY have tight hourly quotas; never spend them on hedges
+    m_policies[RequestMetrics::Unsplash] = RequestPolicy(false);
+    m_policies[RequestMetrics::Mars] = RequestPolicy(false);
+    m_responseCache.setMaxCost(kResponseCacheBytes);
+
+    m_forecastModel->setTemperatureUnit(m_temperatureUnit);
+    m_forecastModel->setLanguage(m_language);
+
+    // Keep the current city (and any watched ones) fresh without QML polling
+    m_refreshEngine->watch(m_city);
+    for (const QString &city : std::as_const(m_watchedCities)) {
+        m_refreshEngine->watch(city);
+    }
+    connect(m_refreshEngine, &RefreshEngine::refreshDue, this, &WeatherService::onRefreshDue);
+
+    // Keeps the history small without competing with startup I/O
+    QTimer::singleShot(kHistoryCompactionDelayMs, this, &WeatherService::compactHistory);
+
+    // qGuiApp would blindly cast a plain QCoreApplication, so check the type
+    if (auto *guiApp = qobject_cast<QGuiApplication *>(QCoreApplication::instance())) {
+        connect(guiApp, &QGuiApplication::applicationStateChanged, this, [this](Qt::ApplicationState state) {
+            if (state == Qt::ApplicationActive) {
+                prewarmIfIdle();
+            }
+        });
+    }
+}
+
+WeatherService::~WeatherService()
+{
+    if (!m_tracePath.isEmpty()) {
+        writeTrace(m_tracePath);
+    }
+}
+
+void WeatherService::setMetricsEnabled(bool enabled)
+{
+    if (m_metrics->isEnabled() != enabled) {
+        m_metrics->setEnabled(enabled);
+        emit metricsEnabledChanged();
+    }
+}
+
+void WeatherService::setTracingEnabled(bool enabled)
+{
+    if (enabled) {
+        setMetricsEnabled(true);
+    }
+    m_metrics->setTracing(enabled);
+}
+
+bool WeatherService::writeTrace(const QString &path) const
+{
+    return m_metrics->writeTrace(path);
+}
+
+QVariantMap WeatherService::metricsSnapshot() const
+{
+    QVariantMap resilience;
+    for (int e = 0; e < RequestMetrics::EndpointCount; ++e) {
+        const auto endpoint = RequestMetrics::Endpoint(e);
+        resilience[RequestMetrics::endpointName(endpoint)] = m_policies[e].toVariantMap();
+    }
+
+    QVariantMap snapshot = m_metrics->snapshot();
+    snapshot["resilience"] = resilience;
+    snapshot["scheduler"] = m_scheduler->toVariantMap();
+    snapshot["refresh"] = m_refreshEngine->toVariantMap();
+    snapshot["sharedCache"] = m_sharedCache.toVariantMap();
+    if (m_memoryBudget) snapshot["memory"] = m_memoryBudget->breakdown();
+    return snapshot;
+}
+
+void WeatherService::resetMetrics()
+{
+    m_metrics->reset();
+}
+
+void WeatherService::registerMemory(MemoryBudget *budget)
+{
+    m_memoryBudget = budget;
+
+    // QCache drops least recently used bodies to fit a lower limit
+    budget->addPool(
+        "responses", this, kResponseCacheBytes, [this]() { return qint64(m_responseCache.totalCost()); },
+        [this](qint64 targetBytes) {
+            m_responseCache.setMaxCost(qsizetype(targetBytes));
+            m_responseCache.setMaxCost(qsizetype(m_memoryBudget->budget("responses")));
+        });
+    m_responseCache.setMaxCost(qsizetype(budget->budget("responses")));
+
+    // The current and watched cities are re-fetched on a timer anyway, so only others go
+    budget->addPool(
+        "forecasts", this, kForecastBudgetBytes, [this]() { return m_forecasts.byteSize(); },
+        [this](qint64 targetBytes) { m_forecasts.evictOldest(targetBytes, m_watchedCities + QStringList{m_city}); });
+
+    budget->addPool(
+        "history", this, kHistoryMappedBudgetBytes, [this]() { return m_history.mappedBytes(); },
+        [this](qint64 targetBytes) { m_history.trimMapped(targetBytes); });
+
+    // Decoded sols are read back from disk when next shown
+    budget->addPool(
+        "marsSols", this, kMarsSolBudgetBytes, [this]() { return m_marsSols.decodedBytes(); },
+        [this](qint64) { m_marsSols.dropDecoded(); });
+
+    budget->addPool("cityIndex", this, kCityIndexBudgetBytes, [this]() { return m_cityIndex.byteSize(); });
+}
+
+void WeatherService::startNetwork()
+{
+    if (m_networkManager) return;
+    ensureNetwork();
+
+    // Handshake with the upstream hosts before the first request needs them
+    if (m_apiKeySet) {
+        prewarmConnections();
+    }
+}
+
+void WeatherService::ensureNetwork()
+{
+    if (m_networkManager) return;
+    m_networkManager = createNetworkManager(this);
+    m_sharedCache.attach(sharedCacheName());
+}
+
+void WeatherService::prewarmConnections()
+{
+    ensureNetwork();
+    // Replayed sessions never touch the network
+    if (qobject_cast<ReplayNetworkAccessManager *>(m_networkManager)) return;
+
+#if QT_CONFIG(ssl)
+    // Offering h2 via ALPN lets every OpenWeatherMap request multiplex over
+    // the one connection opened here
+    QSslConfiguration ssl = QSslConfiguration::defaultConfiguration();
+    ssl.setAllowedNextProtocols({QSslConfiguration::ALPNProtocolHTTP2,
+                                 QSslConfiguration::NextProtocolHttp1_1});
+
+    QList<QUrl> hosts = {QUrl(m_openWeatherBaseUrl)};
+    if (!m_unsplashAccessKey.isEmpty()) {
+        hosts.append(QUrl(m_unsplashBaseUrl));
+    }
+
+    for (const QUrl &host : hosts) {
+        if (host.scheme() != "https") continue;
+        m_networkManager->connectToHostEncrypted(host.host(), quint16(host.port(443)), ssl, QString());
+        m_metrics->recordPrewarm(host.host());
+    }
+#endif
+    m_lastNetworkActivity.start();
+}
+
+void WeatherService::prewarmIfIdle()
+{
+    if (!m_apiKeySet || !m_networkManager) return; // startNetwork() prewarms anyway
+    if (!m_lastNetworkActivity.isValid() || m_lastNetworkActivity.hasExpired(kConnectionIdleMs)) {
+        prewarmConnections();
+    }
+}
+
+QNetworkReply *WeatherService::sendRequest(QNetworkRequest request, RequestMetrics::Endpoint endpoint,
+                                           RequestScheduler::Priority priority, const QString &dedupeKey)
+{
+    // A request can beat the first frame, e.g. when QML fetches on load
+    ensureNetwork();
+
+    // Qt 6 negotiates HTTP/2 by default; be explicit since connection sharing depends on it
+    request.setAttribute(QNetworkRequest::Http2AllowedAttribute, true);
+
+    const QString cacheKey = responseCacheKey(request.url());
+    const QByteArray *cached = m_responseCache.object(cacheKey);
+    RequestPolicy &policy = m_policies[endpoint];
+
+    // Everything on the OpenWeatherMap key shares its per-minute quota
+    const bool metered = endpoint == RequestMetrics::Weather
+                         || endpoint == RequestMetrics::Uv
+                         || endpoint == RequestMetrics::Forecast
+                         || endpoint == RequestMetrics::Geocoding;
+
+    // Another local instance may have fetched this moments ago
+    const qint64 sharedMaxAgeMs = sharedCacheMaxAgeMs(endpoint);
+    const QByteArray sharedKey = sharedMaxAgeMs > 0 ? cacheKey.toUtf8() : QByteArray();
+    QByteArray shared;
+
+    ResilientReply *reply;
+    if (sharedMaxAgeMs > 0 && m_sharedCache.lookup(sharedKey, sharedMaxAgeMs, &shared)) {
+        reply = ResilientReply::completed(request, shared, QNetworkReply::NoError, QString(), this);
+    } else if (!policy.allowRequest()) {
+        // Upstream is degraded; answer from cache instead of piling on
+        if (cached) {
+            policy.noteServedFromCache();
+            reply = ResilientReply::completed(request, *cached, QNetworkReply::NoError, QString(), this);
+        } else {
+            reply = ResilientReply::completed(request, QByteArray(), QNetworkReply::ServiceUnavailableError,
+                                              request.url().host() + " is temporarily unavailable", this);
+        }
+    } else {
+        m_lastNetworkActivity.start();
+        reply = new ResilientReply(request, [this, request, endpoint, metered]() {
+            QNetworkReply *attempt = m_networkManager->get(request);
+            m_metrics->track(attempt, endpoint);
+            if (metered) {
+                connect(attempt, &QNetworkReply::finished, this, [this, attempt]() {
+                    if (attempt->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt() == 429) {
+                        m_scheduler->onRateLimited(attempt->rawHeader("Retry-After").toInt());
+                    }
+                });
+            }
+            return attempt;
+        }, &policy, this);
+        if (cached) {
+            reply->setFallbackBody(*cached);
+        }
+
+        QPointer<ResilientReply> guard(reply);
+        std::function<void()> launch;
+        if (metered) {
+            // Retries and hedges only go out if the bucket can spare a token
+            reply->setAttemptGate([this, priority]() { return m_scheduler->tryAcquire(priority); });
+            const QString schedulerKey = dedupeKey.isEmpty() ? cacheKey : dedupeKey;
+            launch = [this, guard, priority, schedulerKey]() {
+                m_scheduler->submit(priority, schedulerKey,
+                                    [guard]() { if (guard) guard->start(); },
+                                    [guard]() { if (guard) guard->abort(); });
+            };
+        } else {
+            launch = [guard]() { if (guard) guard->start(); };
+        }
+
+        if (sharedMaxAgeMs > 0) {
+            fetchShared(reply, sharedKey, sharedMaxAgeMs, launch);
+        } else {
+            launch();
+        }
+    }
+
+    m_metrics->trackRequest(reply, endpoint);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, cacheKey]() {
+        if (reply->error() == QNetworkReply::NoError && !reply->isFromCache() && !reply->body().isEmpty()) {
+            m_responseCache.insert(cacheKey, new QByteArray(reply->body()), reply->body().size());
+        }
+    });
+    return reply;
+}
+
+void WeatherService::fetchShared(ResilientReply *reply, const QByteArray &key, qint64 maxAgeMs,
+                                 const std::function<void()> &launch)
+{
+    if (m_sharedCache.tryAcquireLease(key, kSharedLeaseMs)) {
+        // Elected: fetch for every local instance, then publish the result
+        connect(reply, &QNetworkReply::finished, this, [this, reply, key]() {
+            if (reply->error() == QNetworkReply::NoError && !reply->isFromCache() && !reply->body().isEmpty()) {
+                m_sharedCache.insert(key, reply->body());
+            }
+            m_sharedCache.releaseLease(key);
+        });
+        launch();
+        return;
+    }
+
+    // Another instance is fetching this; wait for it to publish, or take over
+    // if it gives up (failed, or died and let the lease run out)
+    auto *poll = new QTimer(reply);
+    poll->setInterval(kSharedPollMs);
+    connect(poll, &QTimer::timeout, this, [this, reply, poll, key, maxAgeMs, launch]() {
+        if (reply->isFinished()) {
+            poll->stop();
+            return;
+        }
+        QByteArray body;
+        if (m_sharedCache.lookup(key, maxAgeMs, &body)) {
+            poll->stop();
+            reply->serveFromCache(body);
+        } else if (!m_sharedCache.isLeased(key)) {
+            poll->stop();
+            fetchShared(reply, key, maxAgeMs, launch);
+        }
+    });
+    poll->start();
 }
 
 void WeatherService::setCity(const QString &city)
 {
     if (m_city != city) {
+        if (!m_watchedCities.contains(m_city)) {
+            m_refreshEngine->unwatch(m_city);
+            m_forecasts.remove(m_city);
+        }
         m_city = city;
+        m_forecastModel->setDays(m_forecasts.daily(m_city));
+        m_refreshEngine->watch(m_city);
         saveSettings();
         emit cityChanged();
     }
@@ -84,38 +543,148 @@ void WeatherService::fetchWeather()
 
     setLoading(true);
     setError("");
+    requestWeather(m_city, RequestScheduler::Foreground);
+}
 
+void WeatherService::requestWeather(const QString &city, RequestScheduler::Priority priority)
+{
     // Get the API name (might be different from display name)
-    QString apiCityName = getApiCityName(m_city);
+    QString apiCityName = getApiCityName(city);
 
-    QUrl url("https://api.openweathermap.org/data/2.5/weather");
+    QUrl url(m_openWeatherBaseUrl + "/data/2.5/weather");
     QUrlQuery query;
     query.addQueryItem("q", apiCityName);
     query.addQueryItem("appid", m_apiKey);
     query.addQueryItem("units", "standard"); // Request Kelvin for custom conversion
-    query.addQueryItem("lang", m_language); // Localized weather descriptions
     url.setQuery(query);
 
     QNetworkRequest request(url);
-    QNetworkReply *reply = m_networkManager->get(request);
+    QNetworkReply *reply = sendRequest(request, RequestMetrics::Weather, priority);
+    reply->setProperty("city", city);
+    reply->setProperty("background", priority != RequestScheduler::Foreground);
     connect(reply, &QNetworkReply::finished, this, &WeatherService::onWeatherReplyFinished);
 }
 
+void WeatherService::onRefreshDue(const QStringList &cities)
+{
+    if (m_apiKey.isEmpty() || showingPlanet()) return;
+
+    // The city on screen outranks watchlist cities nobody is looking at
+    for (const QString &city : cities) {
+        requestWeather(city, city == m_city ? RequestScheduler::Watchlist : RequestScheduler::Prefetch);
+    }
+}
+
+void WeatherService::watchCity(const QString &city)
+{
+    if (city.isEmpty() || m_watchedCities.contains(city)) return;
+
+    m_watchedCities.append(city);
+    m_refreshEngine->watch(city);
+    saveSettings();
+    emit watchedCitiesChanged();
+
+    // The engine schedules from the first observation onwards
+    if (!m_apiKey.isEmpty() && city != m_city) {
+        requestWeather(city, RequestScheduler::Prefetch);
+    }
+}
+
+void WeatherService::unwatchCity(const QString &city)
+{
+    if (!m_watchedCities.removeOne(city)) return;
+
+    if (city != m_city) {
+        m_refreshEngine->unwatch(city);
+        m_forecasts.remove(city);
+    }
+    saveSettings();
+    emit watchedCitiesChanged();
+}
+
+const CityIndex &WeatherService::cityIndex()
+{
+    // Loaded on first use so startup doesn't pay for it
+    if (m_cityIndex.isEmpty()) m_cityIndex.loadCsv(":/data/cities.csv");
+    return m_cityIndex;
+}
+
+QVariantList WeatherService::nearestCities(double latitude, double longitude, int count)
+{
+    const CityIndex &index = cityIndex();
+    QVariantList result;
+    const QVector<CityMatch> matches = index.nearest(latitude, longitude, count);
+    for (const CityMatch &match : matches) {
+        const CityLocation &city = index.city(match.index);
+        QVariantMap entry;
+        entry["name"] = city.displayName();
+        entry["latitude"] = city.latitude;
+        entry["longitude"] = city.longitude;
+        entry["distanceKm"] = match.distanceKm;
+        result.append(entry);
+    }
+    return result;
+}
+
+QString WeatherService::cityAt(double latitude, double longitude)
+{
+    const CityIndex &index = cityIndex();
+    const QVector<CityMatch> matches = index.nearest(latitude, longitude, 1);
+    if (matches.isEmpty() || matches.first().distanceKm > kCitySnapRadiusKm) return QString();
+    return index.city(matches.first().index).displayName();
+}
+
+bool WeatherService::setCityFromCoordinates(double latitude, double longitude)
+{
+    const QString city = cityAt(latitude, longitude);
+    if (city.isEmpty()) return false;
+
+    setCity(city);
+    return true;
+}
+
 void WeatherService::onWeatherReplyFinished()
 {
     QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
     if (!reply) return;
 
+    // Superseded by an identical queued fetch, which will finish the job
+    if (reply->error() == QNetworkReply::OperationCanceledError) {
+        reply->deleteLater();
+        return;
+    }
+
+    const QString city = reply->property("city").toString();
+    const bool background = reply->property("background").toBool();
+
     if (reply->error() == QNetworkReply::NoError) {
+        m_refreshEngine->setCacheMaxAge(city, cacheMaxAgeSeconds(reply));
         QByteArray data = reply->readAll();
+
+        // A watchlist city, or one the user has since navigated away from;
+        // only the refresh engine needs to see it
+        if (city != m_city) {
+            const QJsonObject weather = QJsonDocument::fromJson(data).object();
+            m_refreshEngine->recordObservation(city, weather);
+            m_history.append(city, historyRecordFrom(weather));
+            if (m_watchedCities.contains(city)) {
+                requestForecastIfStale(city, RequestScheduler::Prefetch);
+            }
+            reply->deleteLater();
+            return;
+        }
+
         parseWeatherData(data);
+        requestForecastIfStale(m_city, background ? RequestScheduler::Watchlist : RequestScheduler::Foreground);
 
-        // Fetch city background image
-        fetchCityBackground(m_city);
+        // Fetch city background image (unchanged by a background refresh)
+        if (!background) {
+            fetchCityBackground(m_city);
+        }
 
         // Fetch UV index if we have coordinates
         if (m_latitude != 0 && m_longitude != 0) {
-            QUrl uvUrl("https://api.openweathermap.org/data/2.5/uvi");
+            QUrl uvUrl(m_openWeatherBaseUrl + "/data/2.5/uvi");
             QUrlQuery query;
             query.addQueryItem("lat", QString::number(m_latitude));
             query.addQueryItem("lon", QString::number(m_longitude));
@@ -123,11 +692,17 @@ void WeatherService::onWeatherReplyFinished()
             uvUrl.setQuery(query);
 
             QNetworkRequest uvRequest(uvUrl);
-            QNetworkReply *uvReply = m_networkManager->get(uvRequest);
+            QNetworkReply *uvReply = sendRequest(uvRequest, RequestMetrics::Uv,
+                                                 background ? RequestScheduler::Watchlist
+                                                            : RequestScheduler::Foreground);
+            uvReply->setProperty("background", background);
             connect(uvReply, &QNetworkReply::finished, this, &WeatherService::onUvReplyFinished);
-        } else {
+        } else if (!background) {
             setLoading(false);
         }
+    } else if (background) {
+        // Keep showing the last good data; the engine retries shortly
+        m_refreshEngine->recordFailure(city);
     } else {
         setError("Failed to fetch weather data: " + reply->errorString());
         setLoading(false);
@@ -146,12 +721,80 @@ void WeatherService::onUvReplyFinished()
         parseUvData(data);
     }
 
-    setLoading(false);
+    // A background refresh never set the spinner, so it mustn't clear one a user fetch still needs
+    if (!reply->property("background").toBool()) {
+        setLoading(false);
+    }
+    reply->deleteLater();
+}
+
+QAbstractItemModel *WeatherService::forecast() const
+{
+    return m_forecastModel;
+}
+
+void WeatherService::requestForecastIfStale(const QString &city, RequestScheduler::Priority priority)
+{
+    const qint64 fetchedAt = m_forecasts.fetchedAtMs(city);
+    if (fetchedAt >= 0 && QDateTime::currentMSecsSinceEpoch() - fetchedAt < kForecastMaxAgeMs) return;
+
+    QUrl url(m_openWeatherBaseUrl + "/data/2.5/forecast");
+    QUrlQuery query;
+    query.addQueryItem("q", getApiCityName(city));
+    query.addQueryItem("appid", m_apiKey);
+    query.addQueryItem("units", "standard"); // Kelvin, like the current conditions
+    url.setQuery(query);
+
+    QNetworkRequest request(url);
+    QNetworkReply *reply = sendRequest(request, RequestMetrics::Forecast, priority);
+    reply->setProperty("city", city);
+    connect(reply, &QNetworkReply::finished, this, &WeatherService::onForecastReplyFinished);
+}
+
+void WeatherService::onForecastReplyFinished()
+{
+    QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
+    if (!reply) return;
+
+    // A failed forecast leaves the previous one (if any) in place; the next
+    // weather refresh asks again
+    if (reply->error() == QNetworkReply::NoError) {
+        const QString city = reply->property("city").toString();
+        RequestMetrics::Scope parseScope(m_metrics, RequestMetrics::Forecast, RequestMetrics::Parse);
+        const QJsonDocument doc = QJsonDocument::fromJson(reply->readAll());
+        const bool parsed = doc.isObject()
+                            && m_forecasts.ingest(city, doc.object(), QDateTime::currentMSecsSinceEpoch());
+        parseScope.finish();
+
+        if (parsed && city == m_city && !showingPlanet()) {
+            RequestMetrics::Scope bindingScope(m_metrics, RequestMetrics::Forecast, RequestMetrics::Binding);
+            applyForecast();
+            emit weatherDataChanged();
+        }
+    }
+
     reply->deleteLater();
 }
 
+void WeatherService::applyForecast()
+{
+    const QVector<ForecastDay> days = m_forecasts.daily(m_city);
+    m_forecastModel->setDays(days);
+    if (days.isEmpty()) return;
+
+    // temp_max/temp_min in current conditions describe spread across the
+    // city right now, not the day; use today's forecast range instead
+    const qint64 today = QDateTime::currentSecsSinceEpoch() + m_forecasts.utcOffsetSeconds(m_city);
+    const ForecastDay &first = days.first();
+    if (today >= first.localMidnight && today < first.localMidnight + 24 * 60 * 60) {
+        m_highTempKelvin = qMax(double(first.maxKelvin), m_temperatureKelvin);
+        m_lowTempKelvin = qMin(double(first.minKelvin), m_temperatureKelvin);
+    }
+}
+
 void WeatherService::parseWeatherData(const QByteArray &data)
 {
+    RequestMetrics::Scope parseScope(m_metrics, RequestMetrics::Weather, RequestMetrics::Parse);
     QJsonDocument doc = QJsonDocument::fromJson(data);
     if (doc.isNull() || !doc.isObject()) {
         setError("Invalid weather data received");
@@ -172,13 +815,9 @@ void WeatherService::parseWeatherData(const QByteArray &data)
     QJsonArray weatherArray = obj["weather"].toArray();
     if (!weatherArray.isEmpty()) {
         QJsonObject weather = weatherArray[0].toObject();
-        m_description = weather["description"].toString();
-        QString mainCondition = weather["main"].toString();
-        m_weatherIcon = getWeatherIcon(mainCondition);
-        // Capitalize first letter
-        if (!m_description.isEmpty()) {
-            m_description[0] = m_description[0].toUpper();
-        }
+        m_conditionId = weather["id"].toInt();
+        m_apiDescription = weather["description"].toString(); // For ids the table doesn't know
+        applyCondition();
     }
 
     // Parse wind speed
@@ -192,12 +831,53 @@ void WeatherService::parseWeatherData(const QByteArray &data)
 
     // Parse timezone offset (shift in seconds from UTC)
     m_timezoneOffset = obj["timezone"].toInt();
+    applyForecast();
+    m_history.append(m_city, historyRecordFrom(obj));
+    parseScope.finish();
 
+    m_refreshEngine->recordObservation(m_city, obj);
+
+    // Time the synchronous QML binding re-evaluation separately from parsing
+    RequestMetrics::Scope bindingScope(m_metrics, RequestMetrics::Weather, RequestMetrics::Binding);
     emit weatherDataChanged();
 }
 
+QVariantList WeatherService::history(qint64 fromSecs, qint64 toSecs, int points)
+{
+    QVariantList series;
+    const QVector<HistoryBucket> buckets = m_history.downsample(m_city, fromSecs, toSecs, points);
+    for (const HistoryBucket &bucket : buckets) {
+        QVariantMap point;
+        point["time"] = bucket.start;
+        point["low"] = convertTemperature(bucket.minTemperatureKelvin);
+        point["high"] = convertTemperature(bucket.maxTemperatureKelvin);
+        point["mean"] = convertTemperature(bucket.meanTemperatureKelvin);
+        point["humidity"] = bucket.meanHumidity;
+        point["windSpeed"] = bucket.meanWindSpeed;
+        point["uvIndex"] = bucket.maxUvIndex;
+        series.append(point);
+    }
+    return series;
+}
+
+void WeatherService::compactHistory()
+{
+    // One city per tick; the store is GUI-thread only and a city's rewrite is bounded
+    if (m_historyCompactionQueue.isEmpty()) {
+        m_historyCompactionQueue = m_history.cities();
+        if (m_historyCompactionQueue.isEmpty()) return;
+    }
+
+    const qint64 cutoff = QDateTime::currentSecsSinceEpoch() - kHistoryFullResolutionSeconds;
+    m_history.compact(m_historyCompactionQueue.takeFirst(), cutoff, kHistoryCompactedResolutionSeconds);
+    if (!m_historyCompactionQueue.isEmpty()) {
+        QTimer::singleShot(kHistoryCompactionStepMs, this, &WeatherService::compactHistory);
+    }
+}
+
 void WeatherService::parseUvData(const QByteArray &data)
 {
+    RequestMetrics::Scope parseScope(m_metrics, RequestMetrics::Uv, RequestMetrics::Parse);
     QJsonDocument doc = QJsonDocument::fromJson(data);
     if (doc.isNull() || !doc.isObject()) {
         return;
@@ -205,6 +885,10 @@ void WeatherService::parseUvData(const QByteArray &data)
 
     QJsonObject obj = doc.object();
     m_uvIndex = qRound(obj["value"].toDouble());
+    m_history.setLatestUvIndex(m_city, float(obj["value"].toDouble()));
+    parseScope.finish();
+
+    RequestMetrics::Scope bindingScope(m_metrics, RequestMetrics::Uv, RequestMetrics::Binding);
     emit weatherDataChanged();
 }
 
@@ -224,24 +908,21 @@ void WeatherService::setError(const QString &error)
     }
 }
 
-QString WeatherService::getWeatherIcon(const QString &condition)
+void WeatherService::applyCondition()
 {
-    // Map weather conditions to emoji icons
-    if (condition == "Clear") return "☀️";
-    if (condition == "Clouds") return "☁️";
-    if (condition == "Rain") return "🌧️";
-    if (condition == "Drizzle") return "🌦️";
-    if (condition == "Thunderstorm") return "⛈️";
-    if (condition == "Snow") return "❄️";
-    if (condition == "Mist" || condition == "Fog") return "🌫️";
-    if (condition == "Haze") return "🌫️";
-    if (condition == "Smoke") return "💨";
-    return "🌤️"; // Default
+    m_weatherIcon = WeatherConditions::icon(m_conditionId);
+    m_description = WeatherConditions::isKnown(m_conditionId)
+                        ? WeatherConditions::description(m_conditionId, m_language)
+                        : m_apiDescription;
+    // Capitalize first letter
+    if (!m_description.isEmpty()) {
+        m_description[0] = m_description[0].toUpper();
+    }
 }
 
 void WeatherService::loadSettings()
 {
-    QSettings settings("ElegantWeather", "ElegantWeather");
+    AppSettings settings;
     m_apiKey = settings.value("apiKey", "").toString();
     m_apiKeySet = !m_apiKey.isEmpty();
     m_unsplashAccessKey = settings.value("unsplashAccessKey", "").toString();
@@ -249,52 +930,44 @@ void WeatherService::loadSettings()
 
     // Load temperature unit, but reject Kelvin (use locale-based default instead)
     QString savedUnit = settings.value("temperatureUnit", m_temperatureUnit).toString();
-    qDebug() << "loadSettings: Read temperatureUnit from config =" << savedUnit;
+    qCDebug(lcWeather) << "loadSettings: Read temperatureUnit from config =" << savedUnit;
     if (savedUnit == "Kelvin") {
-        qDebug() << "loadSettings: Rejecting Kelvin, keeping" << m_temperatureUnit;
+        qCDebug(lcWeather) << "loadSettings: Rejecting Kelvin, keeping" << m_temperatureUnit;
         // Don't use Kelvin - use locale-based default instead
         m_temperatureUnit = m_temperatureUnit; // Keep the locale-detected value
     } else {
-        qDebug() << "loadSettings: Accepting saved unit" << savedUnit;
+        qCDebug(lcWeather) << "loadSettings: Accepting saved unit" << savedUnit;
         m_temperatureUnit = savedUnit;
     }
 
     m_timeFormat = settings.value("timeFormat", "12").toString();
     m_language = settings.value("language", "en").toString();
+
+    // Calls per minute allowed by the OpenWeatherMap plan (60 on the free tier)
+    m_scheduler->setCallsPerMinute(settings.value("apiCallsPerMinute", 60).toInt());
+
+    m_watchedCities = settings.value("watchedCities").toStringList();
+    m_autoRefresh = settings.value("autoRefresh", true).toBool();
+    m_refreshEngine->setEnabled(m_autoRefresh);
 }
 
 void WeatherService::saveSettings()
 {
-    QSettings settings("ElegantWeather", "ElegantWeather");
+    AppSettings settings;
     settings.setValue("apiKey", m_apiKey);
     settings.setValue("unsplashAccessKey", m_unsplashAccessKey);
     settings.setValue("city", m_city);
     settings.setValue("temperatureUnit", m_temperatureUnit);
     settings.setValue("timeFormat", m_timeFormat);
     settings.setValue("language", m_language);
-}
-
-void WeatherService::initializeCityMappings()
-{
-    // Map modern/proper city names to the names the API recognizes
-    // Format: m_cityMappings["Display Name"] = "API Name"
-
-    // Alaska - Utqiagvik (formerly Barrow)
-    m_cityMappings["Utqiagvik"] = "Barrow";
-    m_cityMappings["Utqiagvik, US"] = "Barrow, US";
-    m_cityMappings["Utqiagvik, Alaska"] = "Barrow, Alaska";
-
-    // Can add more renamed cities here as needed
-    // Examples:
-    // m_cityMappings["Mumbai"] = "Bombay";
-    // m_cityMappings["Kolkata"] = "Calcutta";
+    settings.setValue("watchedCities", m_watchedCities);
 }
 
 QString WeatherService::getApiCityName(const QString &displayName)
 {
-    // Check if there's a mapping for this city name
-    // If not found, return the original name
-    return m_cityMappings.value(displayName, displayName);
+    // Renamed cities, exonyms and the like; see data/city_aliases.tsv
+    const QUtf8StringView alias = CityAliases::lookup(displayName);
+    return alias.isEmpty() ? displayName : alias.toString();
 }
 
 QString WeatherService::getTimeOfDay() const
@@ -334,6 +1007,9 @@ void WeatherService::searchCities(const QString &query)
     // Store the query and restart the timer (debouncing)
     m_pendingSearchQuery = query;
     m_searchTimer->start();
+
+    // The debounce window hides a fresh handshake if the connection went idle
+    prewarmIfIdle();
 }
 
 void WeatherService::performCitySearch()
@@ -342,16 +1018,18 @@ void WeatherService::performCitySearch()
         return;
     }
 
-    // Use OpenWeatherMap Geocoding API
-    QUrl url("http://api.openweathermap.org/geo/1.0/direct");
+    // Use OpenWeatherMap Geocoding API (HTTPS so it shares the weather connection)
+    QUrl url(m_openWeatherBaseUrl + "/geo/1.0/direct");
     QUrlQuery query;
     query.addQueryItem("q", m_pendingSearchQuery);
     query.addQueryItem("limit", "5");
     query.addQueryItem("appid", m_apiKey);
     url.setQuery(query);
 
+    // Only the newest query matters, so queued lookups replace each other
     QNetworkRequest request(url);
-    QNetworkReply *reply = m_networkManager->get(request);
+    QNetworkReply *reply = sendRequest(request, RequestMetrics::Geocoding,
+                                       RequestScheduler::Autocomplete, "geo/autocomplete");
     connect(reply, &QNetworkReply::finished, this, &WeatherService::onGeocodingReplyFinished);
 }
 
@@ -360,9 +1038,16 @@ void WeatherService::onGeocodingReplyFinished()
     QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
     if (!reply) return;
 
+    // Superseded by a newer query or shed by the scheduler
+    if (reply->error() == QNetworkReply::OperationCanceledError) {
+        reply->deleteLater();
+        return;
+    }
+
     m_citySuggestions.clear();
 
     if (reply->error() == QNetworkReply::NoError) {
+        RequestMetrics::Scope parseScope(m_metrics, RequestMetrics::Geocoding, RequestMetrics::Parse);
         QByteArray data = reply->readAll();
         QJsonDocument doc = QJsonDocument::fromJson(data);
 
@@ -386,6 +1071,7 @@ void WeatherService::onGeocodingReplyFinished()
         }
     }
 
+    RequestMetrics::Scope bindingScope(m_metrics, RequestMetrics::Geocoding, RequestMetrics::Binding);
     emit citySuggestionsChanged();
     reply->deleteLater();
 }
@@ -403,7 +1089,7 @@ void WeatherService::fetchCityBackground(const QString &cityName)
     // Add time of day to the search query
     searchQuery += getTimeOfDay();
 
-    QUrl url("https://api.unsplash.com/search/photos");
+    QUrl url(m_unsplashBaseUrl + "/search/photos");
     QUrlQuery query;
     query.addQueryItem("query", searchQuery);
     query.addQueryItem("per_page", "1");
@@ -413,7 +1099,7 @@ void WeatherService::fetchCityBackground(const QString &cityName)
     QNetworkRequest request(url);
     request.setRawHeader("Authorization", QString("Client-ID %1").arg(m_unsplashAccessKey).toUtf8());
 
-    QNetworkReply *reply = m_networkManager->get(request);
+    QNetworkReply *reply = sendRequest(request, RequestMetrics::Unsplash);
     connect(reply, &QNetworkReply::finished, this, &WeatherService::onUnsplashReplyFinished);
 }
 
@@ -423,6 +1109,7 @@ void WeatherService::onUnsplashReplyFinished()
     if (!reply) return;
 
     if (reply->error() == QNetworkReply::NoError) {
+        RequestMetrics::Scope parseScope(m_metrics, RequestMetrics::Unsplash, RequestMetrics::Parse);
         QByteArray data = reply->readAll();
         QJsonDocument doc = QJsonDocument::fromJson(data);
 
@@ -437,8 +1124,17 @@ void WeatherService::onUnsplashReplyFinished()
                 QString imageUrl = urls["regular"].toString();
 
                 if (!imageUrl.isEmpty()) {
-                    m_backgroundImageUrl = imageUrl;
-                    emit backgroundImageUrlChanged();
+                    // Photos already downloaded are shown from memory
+                    const QString held = m_backgroundImages ? m_backgroundImages->find(imageUrl) : imageUrl;
+                    if (held.isEmpty()) {
+                        fetchBackgroundImage(imageUrl);
+                    } else {
+                        m_backgroundImageUrl = held;
+                        m_pendingBackgroundUrl.clear();
+                        parseScope.finish();
+                        RequestMetrics::Scope bindingScope(m_metrics, RequestMetrics::Unsplash, RequestMetrics::Binding);
+                        emit backgroundImageUrlChanged();
+                    }
                 }
             }
         }
@@ -447,6 +1143,28 @@ void WeatherService::onUnsplashReplyFinished()
     reply->deleteLater();
 }
 
+void WeatherService::fetchBackgroundImage(const QString &imageUrl)
+{
+    // Photos come from Unsplash's CDN, not its API, so they skip the quota and the response cache
+    ensureNetwork();
+    m_pendingBackgroundUrl = imageUrl;
+    QNetworkReply *reply = m_networkManager->get(QNetworkRequest(QUrl(imageUrl)));
+    m_metrics->track(reply, RequestMetrics::Unsplash);
+    connect(reply, &QNetworkReply::finished, this, [this, reply, imageUrl]() {
+        reply->deleteLater();
+        if (imageUrl != m_pendingBackgroundUrl || !m_backgroundImages) return; // Superseded
+        m_pendingBackgroundUrl.clear();
+        if (reply->error() != QNetworkReply::NoError) {
+            qCWarning(lcNetwork) << "Background download failed:" << reply->errorString();
+            return;
+        }
+
+        m_backgroundImageUrl = m_backgroundImages->insert(imageUrl, reply->readAll());
+        RequestMetrics::Scope bindingScope(m_metrics, RequestMetrics::Unsplash, RequestMetrics::Binding);
+        emit backgroundImageUrlChanged();
+    });
+}
+
 void WeatherService::setCurrentPlanet(const QString &planet)
 {
     if (m_currentPlanet != planet) {
@@ -457,6 +1175,9 @@ void WeatherService::setCurrentPlanet(const QString &planet)
         emit currentPlanetChanged();
         emit showingPlanetChanged();
 
+        // Mars data only changes once per sol; auto-refresh is for Earth
+        m_refreshEngine->setEnabled(m_autoRefresh && planet == "Earth");
+
         // Clear ALL weather data when switching planets
         m_temperatureKelvin = 0;
         m_highTempKelvin = 0;
@@ -465,18 +1186,26 @@ void WeatherService::setCurrentPlanet(const QString &planet)
         m_windSpeed = 0;
         m_feelsLikeKelvin = 0;
         m_uvIndex = 0;
+        m_conditionId = 0;
+        m_apiDescription.clear();
         m_description = "";
         m_weatherIcon = "";
+        m_forecastModel->setDays({});
 
         if (planet == "Mars") {
+            // The Earth city stays refreshed only if it is on the watchlist
+            if (!m_watchedCities.contains(m_city)) {
+                m_refreshEngine->unwatch(m_city);
+            }
             m_city = "Mars";
             emit cityChanged();
             emit weatherDataChanged();
             fetchMarsWeather();
-            // fetchMarsWeather will set loading to false when done
+            // fetchMarsWeather sets loading to false once it has data to show
         } else if (planet == "Earth") {
             // Return to default Earth city
             m_city = "San Francisco";
+            m_refreshEngine->watch(m_city);
             emit cityChanged();
             emit weatherDataChanged();
             setLoading(false);
@@ -493,9 +1222,11 @@ void WeatherService::setTemperatureUnit(const QString &unit)
 
     if (m_temperatureUnit != unit) {
         m_temperatureUnit = unit;
+        m_forecastModel->setTemperatureUnit(unit);
         saveSettings();
         emit temperatureUnitChanged();
         emit weatherDataChanged(); // Trigger UI update with new units
+        emit marsSolsChanged();
     }
 }
 
@@ -520,11 +1251,13 @@ void WeatherService::setLanguage(const QString &lang)
 {
     if (m_language != lang) {
         m_language = lang;
+        m_forecastModel->setLanguage(lang);
         saveSettings();
         emit languageChanged();
-        // Re-fetch weather to get localized descriptions
-        if (m_currentPlanet == "Earth" && !m_city.isEmpty()) {
-            fetchWeather();
+        // Descriptions come from the condition table, so no refetch is needed
+        if (m_currentPlanet == "Earth" && m_conditionId != 0) {
+            applyCondition();
+            emit weatherDataChanged();
         }
     }
 }
@@ -542,16 +1275,30 @@ double WeatherService::convertTemperature(double kelvin) const
 
 void WeatherService::fetchMarsWeather()
 {
-    setLoading(true);
     setError("");
 
+    // Sol reports never change, so show the newest cached one straight away
+    // and only go to the network when a new sol may have been published
+    const bool cached = !m_marsSols.isEmpty();
+    if (cached) {
+        applyMarsSol(m_marsSols.sols().last());
+        setLoading(false);
+        if (QDateTime::currentMSecsSinceEpoch() - m_marsSols.fetchedAtMs() < kMarsRefetchMs) return;
+    } else {
+        setLoading(true);
+    }
+
     // NASA InSight Mars Weather API
     // Note: InSight mission ended, but using demo for now
     // Alternative: https://mars.nasa.gov/rss/api/?feed=weather&category=msl&feedtype=json
-    QUrl url("https://api.nasa.gov/insight_weather/?api_key=DEMO_KEY&feedtype=json&ver=1.0");
+    QUrl url(m_nasaBaseUrl + "/insight_weather/?api_key=DEMO_KEY&feedtype=json&ver=1.0");
 
     QNetworkRequest request(url);
-    QNetworkReply *reply = m_networkManager->get(request);
+    if (cached && !m_marsSols.etag().isEmpty()) {
+        // Spare the DEMO_KEY quota a full body when nothing was published
+        request.setRawHeader("If-None-Match", m_marsSols.etag());
+    }
+    QNetworkReply *reply = sendRequest(request, RequestMetrics::Mars);
     connect(reply, &QNetworkReply::finished, this, &WeatherService::onMarsWeatherReplyFinished);
 }
 
@@ -560,52 +1307,53 @@ void WeatherService::onMarsWeatherReplyFinished()
     QNetworkReply *reply = qobject_cast<QNetworkReply*>(sender());
     if (!reply) return;
 
-    if (reply->error() == QNetworkReply::NoError) {
+    const int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+    if (reply->error() == QNetworkReply::NoError && status == 304) {
+        m_marsSols.setFetched(m_marsSols.etag(), QDateTime::currentMSecsSinceEpoch());
+    } else if (reply->error() == QNetworkReply::NoError) {
+        RequestMetrics::Scope parseScope(m_metrics, RequestMetrics::Mars, RequestMetrics::Parse);
         QByteArray data = reply->readAll();
         QJsonDocument doc = QJsonDocument::fromJson(data);
 
         if (doc.isObject()) {
             QJsonObject obj = doc.object();
-            QJsonArray solKeys = obj["sol_keys"].toArray();
-
-            if (!solKeys.isEmpty()) {
-                // Get the most recent sol (Martian day)
-                QString latestSol = solKeys.last().toString();
-                QJsonObject solData = obj[latestSol].toObject();
-
-                // Parse Mars atmospheric temperature (API returns Celsius, store as Kelvin)
-                QJsonObject at = solData["AT"].toObject();
-                if (!at.isEmpty()) {
-                    double avgTemp = at["av"].toDouble();
-                    double maxTemp = at["mx"].toDouble();
-                    double minTemp = at["mn"].toDouble();
-                    // Convert from Celsius to Kelvin for internal storage
-                    m_temperatureKelvin = avgTemp + 273.15;
-                    m_highTempKelvin = maxTemp + 273.15;
-                    m_lowTempKelvin = minTemp + 273.15;
-                }
-
-                // Parse wind speed
-                QJsonObject hws = solData["HWS"].toObject();
-                if (!hws.isEmpty()) {
-                    m_windSpeed = hws["av"].toDouble() * 2.237; // Convert m/s to mph
-                }
-
-                // Parse pressure
-                QJsonObject pre = solData["PRE"].toObject();
-                if (!pre.isEmpty()) {
-                    // Store pressure in humidity field for now (Mars doesn't have humidity)
-                    m_humidity = qRound(pre["av"].toDouble());
+            const QJsonArray solKeys = obj["sol_keys"].toArray();
+
+            // Only sols we haven't seen are converted and stored
+            bool added = false;
+            for (const QJsonValue &key : solKeys) {
+                const QString sol = key.toString();
+                if (m_marsSols.contains(sol)) continue;
+
+                const QJsonObject report = obj[sol].toObject();
+                if (report.isEmpty() || !m_marsSols.insert(sol, report)) continue;
+                added = true;
+
+                // Keep every sol in the observation history too
+                const QJsonObject at = report["AT"].toObject();
+                const QDateTime start = QDateTime::fromString(report["First_UTC"].toString(), Qt::ISODate);
+                if (at.isEmpty() || !start.isValid()) continue;
+
+                HistoryRecord record;
+                record.time = start.toSecsSinceEpoch();
+                record.temperatureKelvin = float(at["av"].toDouble() + 273.15);
+                record.feelsLikeKelvin = record.temperatureKelvin;
+                record.windSpeed = float(report["HWS"].toObject()["av"].toDouble());
+                record.pressure = float(report["PRE"].toObject()["av"].toDouble());
+                m_history.append("Mars", record);
+            }
+            m_marsSols.setFetched(reply->rawHeader("ETag"), QDateTime::currentMSecsSinceEpoch());
+            parseScope.finish();
+
+            if (added) {
+                emit marsSolsChanged();
+                if (m_currentPlanet == "Mars") {
+                    RequestMetrics::Scope bindingScope(m_metrics, RequestMetrics::Mars, RequestMetrics::Binding);
+                    applyMarsSol(m_marsSols.sols().last());
                 }
-
-                m_description = "Martian atmospheric conditions";
-                m_weatherIcon = "🔴"; // Mars emoji
-                m_city = "Mars (Sol " + latestSol + ")";
-
-                emit weatherDataChanged();
             }
         }
-    } else {
+    } else if (m_marsSols.isEmpty() && m_currentPlanet == "Mars") {
         // If API fails, use known Mars atmospheric data (store in Kelvin)
         m_temperatureKelvin = -63 + 273.15; // Average temp
         m_highTempKelvin = -21 + 273.15;
@@ -618,6 +1366,70 @@ void WeatherService::onMarsWeatherReplyFinished()
         emit weatherDataChanged();
     }
 
-    setLoading(false);
+    // A late reply after switching back to Earth must not end Earth's fetch
+    if (m_currentPlanet == "Mars") {
+        setLoading(false);
+    }
     reply->deleteLater();
 }
+
+void WeatherService::applyMarsSol(const QString &sol)
+{
+    const QJsonObject solData = m_marsSols.sol(sol);
+    if (solData.isEmpty()) return;
+
+    // Parse Mars atmospheric temperature (API returns Celsius, store as Kelvin)
+    QJsonObject at = solData["AT"].toObject();
+    if (!at.isEmpty()) {
+        double avgTemp = at["av"].toDouble();
+        double maxTemp = at["mx"].toDouble();
+        double minTemp = at["mn"].toDouble();
+        // Convert from Celsius to Kelvin for internal storage
+        m_temperatureKelvin = avgTemp + 273.15;
+        m_highTempKelvin = maxTemp + 273.15;
+        m_lowTempKelvin = minTemp + 273.15;
+    }
+
+    // Parse wind speed
+    QJsonObject hws = solData["HWS"].toObject();
+    if (!hws.isEmpty()) {
+        m_windSpeed = hws["av"].toDouble() * 2.237; // Convert m/s to mph
+    }
+
+    // Parse pressure
+    QJsonObject pre = solData["PRE"].toObject();
+    if (!pre.isEmpty()) {
+        // Store pressure in humidity field for now (Mars doesn't have humidity)
+        m_humidity = qRound(pre["av"].toDouble());
+    }
+
+    m_description = "Martian atmospheric conditions";
+    m_weatherIcon = "🔴"; // Mars emoji
+    m_city = "Mars (Sol " + sol + ")";
+    emit cityChanged();
+    emit weatherDataChanged();
+}
+
+QVariantList WeatherService::marsSols()
+{
+    QVariantList series;
+    const QStringList sols = m_marsSols.sols();
+    for (const QString &sol : sols) {
+        const QJsonObject report = m_marsSols.sol(sol);
+        if (report.isEmpty()) continue;
+
+        const QJsonObject at = report["AT"].toObject();
+        QVariantMap entry;
+        entry["sol"] = sol.toInt();
+        entry["date"] = QDateTime::fromString(report["First_UTC"].toString(), Qt::ISODate);
+        if (!at.isEmpty()) {
+            entry["temperature"] = convertTemperature(at["av"].toDouble() + 273.15);
+            entry["high"] = convertTemperature(at["mx"].toDouble() + 273.15);
+            entry["low"] = convertTemperature(at["mn"].toDouble() + 273.15);
+        }
+        entry["windSpeed"] = report["HWS"].toObject()["av"].toDouble() * 2.237; // mph, like windSpeed
+        entry["pressure"] = report["PRE"].toObject()["av"].toDouble(); // Pa
+        series.append(entry);
+    }
+    return series;
+}
@@ -4,13 +4,33 @@
 #include <QObject>
 #include <QString>
 #include <QStringList>
-#include <QMap>
+#include <QVariantMap>
+#include <QElapsedTimer>
+#include <QCache>
+#include <QPointer>
+#include <array>
+#include "requestmetrics.h"
+#include "requestpolicy.h"
+#include "requestscheduler.h"
+#include "refreshengine.h"
+#include "forecaststore.h"
+#include "historystore.h"
+#include "marssolcache.h"
+#include "cityindex.h"
+#include "sharedcache.h"
+#include <functional>
 
 // Forward declarations for faster compilation
+class BackgroundImageProvider;
+class ForecastModel;
+class MemoryBudget;
+class QAbstractItemModel;
 class QNetworkAccessManager;
 class QNetworkReply;
+class QNetworkRequest;
 class QSettings;
 class QTimer;
+class ResilientReply;
 
 class WeatherService : public QObject
 {
@@ -36,9 +56,15 @@ class WeatherService : public QObject
     Q_PROPERTY(QString timeFormat READ timeFormat WRITE setTimeFormat NOTIFY timeFormatChanged)
     Q_PROPERTY(QString language READ language WRITE setLanguage NOTIFY languageChanged)
     Q_PROPERTY(QString temperatureUnitSymbol READ temperatureUnitSymbol NOTIFY temperatureUnitChanged)
+    Q_PROPERTY(bool metricsEnabled READ metricsEnabled WRITE setMetricsEnabled NOTIFY metricsEnabledChanged)
+    Q_PROPERTY(QVariantMap metrics READ metricsSnapshot NOTIFY metricsChanged)
+    Q_PROPERTY(QAbstractItemModel *forecast READ forecast CONSTANT)
+    Q_PROPERTY(QVariantList marsSols READ marsSols NOTIFY marsSolsChanged)
+    Q_PROPERTY(QStringList watchedCities READ watchedCities NOTIFY watchedCitiesChanged)
 
 public:
     explicit WeatherService(QObject *parent = nullptr);
+    ~WeatherService();
 
     QString city() const { return m_city; }
     void setCity(const QString &city);
@@ -73,6 +99,58 @@ public:
     QString language() const { return m_language; }
     void setLanguage(const QString &lang);
 
+    bool metricsEnabled() const { return m_metrics->isEnabled(); }
+    void setMetricsEnabled(bool enabled);
+
+    // Per-endpoint phase histograms, byte counts, outcomes and resilience state
+    Q_INVOKABLE QVariantMap metricsSnapshot() const;
+    Q_INVOKABLE void setTracingEnabled(bool enabled);
+    Q_INVOKABLE bool writeTrace(const QString &path) const;
+    Q_INVOKABLE void resetMetrics();
+
+    // Daily rows (dayName, date, high, low, mean, precipitation, pop, icon) for the current city
+    QAbstractItemModel *forecast() const;
+
+    // Recorded observations of the current city in [fromSecs, toSecs), downsampled
+    // to at most `points` entries of {time, low, high, mean, humidity, windSpeed, uvIndex}
+    Q_INVOKABLE QVariantList history(qint64 fromSecs, qint64 toSecs, int points);
+
+    // Every cached InSight sol, oldest first: {sol, date, temperature, high, low, windSpeed, pressure}
+    QVariantList marsSols();
+
+    // Extra cities kept fresh in the background alongside the current one
+    QStringList watchedCities() const { return m_watchedCities; }
+    Q_INVOKABLE void watchCity(const QString &city);
+    Q_INVOKABLE void unwatchCity(const QString &city);
+
+    // Offline reverse lookup over the bundled city list, no geocoder round trip.
+    // nearestCities gives {name, latitude, longitude, distanceKm}, nearest first;
+    // cityAt is empty when nothing is close enough to snap to.
+    Q_INVOKABLE QVariantList nearestCities(double latitude, double longitude, int count);
+    Q_INVOKABLE QString cityAt(double latitude, double longitude);
+    Q_INVOKABLE bool setCityFromCoordinates(double latitude, double longitude);
+
+    // Connections and QML bindings that run when signal (a SIGNAL() string)
+    // is emitted; for FrameProfiler
+    int signalReceivers(const char *signal) const { return receivers(signal); }
+
+    // Reports the response cache, forecasts, mapped history, decoded Mars
+    // sols and the city index to budget, which trims them when they're over
+    void registerMemory(MemoryBudget *budget);
+
+    // The name OpenWeatherMap knows a city by, after the alias table
+    static QString getApiCityName(const QString &displayName);
+
+    // Where downloaded city backgrounds go; without it QML loads the photo URL itself
+    void setBackgroundImages(BackgroundImageProvider *images) { m_backgroundImages = images; }
+
+    // Creates the network manager, attaches the shared cache and prewarms.
+    // Deferred until after the first frame, so none of it delays the window.
+    void startNetwork();
+
+    // Open TLS (HTTP/2 where offered) connections to the upstream hosts ahead of the first request
+    Q_INVOKABLE void prewarmConnections();
+
     Q_INVOKABLE void fetchWeather();
     Q_INVOKABLE void setApiKey(const QString &apiKey);
     Q_INVOKABLE void searchCities(const QString &query);
@@ -93,41 +171,82 @@ signals:
     void temperatureUnitChanged();
     void timeFormatChanged();
     void languageChanged();
+    void metricsEnabledChanged();
+    void metricsChanged();
+    void watchedCitiesChanged();
+    void marsSolsChanged();
 
 private slots:
     void onWeatherReplyFinished();
     void onUvReplyFinished();
+    void onForecastReplyFinished();
     void onGeocodingReplyFinished();
     void onUnsplashReplyFinished();
     void onMarsWeatherReplyFinished();
     void performCitySearch();
+    void onRefreshDue(const QStringList &cities);
 
 private:
+    QNetworkReply *sendRequest(QNetworkRequest request, RequestMetrics::Endpoint endpoint,
+                               RequestScheduler::Priority priority = RequestScheduler::Foreground,
+                               const QString &dedupeKey = QString());
+    void fetchShared(ResilientReply *reply, const QByteArray &key, qint64 maxAgeMs,
+                     const std::function<void()> &launch);
+    void ensureNetwork();
+    void prewarmIfIdle();
+    void requestWeather(const QString &city, RequestScheduler::Priority priority);
+    void requestForecastIfStale(const QString &city, RequestScheduler::Priority priority);
+    void applyForecast();
+    void compactHistory();
+    const CityIndex &cityIndex();
+    void applyMarsSol(const QString &sol);
+    void fetchBackgroundImage(const QString &imageUrl);
     void parseWeatherData(const QByteArray &data);
     void parseUvData(const QByteArray &data);
     void setLoading(bool loading);
     void setError(const QString &error);
-    QString getWeatherIcon(const QString &condition);
+    void applyCondition();
     void loadSettings();
     void saveSettings();
-    void initializeCityMappings();
-    QString getApiCityName(const QString &displayName);
     QString getTimeOfDay() const;
     double convertTemperature(double kelvin) const;
 
-    QNetworkAccessManager *m_networkManager;
+    QNetworkAccessManager *m_networkManager; // Null until startNetwork()
+    RequestMetrics *m_metrics;
+    RequestScheduler *m_scheduler; // Token bucket for the OpenWeatherMap quota
+    RefreshEngine *m_refreshEngine; // Decides when the current and watched cities are re-fetched
+    bool m_autoRefresh;
+    QStringList m_watchedCities;
+    ForecastStore m_forecasts; // Columnar 5-day/3-hour forecasts for the current and watched cities
+    ForecastModel *m_forecastModel;
+    HistoryStore m_history; // Every observation, appended to memory-mapped segments
+    QStringList m_historyCompactionQueue; // Cities still to compact in this pass
+    MarsSolCache m_marsSols; // Sol reports are immutable, so fetched at most once
+    SharedCache m_sharedCache; // Shared with other local instances, one fetcher per key; attached by startNetwork()
+    CityIndex m_cityIndex; // Bundled cities for coordinates -> name, loaded on first use
+    QString m_tracePath; // Written on destruction when ELEGANTWEATHER_TRACE is set
+    QString m_openWeatherBaseUrl; // Overridable so a local stand-in server can be used
+    QString m_unsplashBaseUrl;
+    QString m_nasaBaseUrl;
+    QElapsedTimer m_lastNetworkActivity; // Drives re-prewarming after idle periods
+    std::array<RequestPolicy, RequestMetrics::EndpointCount> m_policies; // Timeouts, hedging, breaker
+    QCache<QString, QByteArray> m_responseCache; // Last good body per URL, served while degraded
+    MemoryBudget *m_memoryBudget; // Null unless registerMemory() was called
+    QPointer<BackgroundImageProvider> m_backgroundImages; // Owned by the QML engine
     QString m_apiKey;
     QString m_unsplashAccessKey;
     QString m_city;
-    QMap<QString, QString> m_cityMappings; // Display name -> API name
     QStringList m_citySuggestions;
     QTimer *m_searchTimer;
     QString m_pendingSearchQuery;
     QString m_backgroundImageUrl;
+    QString m_pendingBackgroundUrl; // Photo being downloaded; a slower earlier one is ignored
     QString m_currentPlanet;
     double m_temperatureKelvin; // Store in Kelvin, convert in getter
     QString m_description;
     QString m_weatherIcon;
+    int m_conditionId; // OpenWeatherMap condition id; 0 when there's none
+    QString m_apiDescription;
     double m_highTempKelvin; // Store in Kelvin, convert in getter
     double m_lowTempKelvin; // Store in Kelvin, convert in getter
     int m_humidity;